@@ -18,12 +18,13 @@
 # You should have received a copy of the GNU General Public License
 # along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
+import math
 import re
 import sys	
+import time
 import egret_ext
 import egret_api
 from optparse import OptionParser
-#import time
 
 # Precondition: regexStr successfully compiles and all strings in testStrings
 # match the regular expression
@@ -69,6 +70,76 @@ def get_group_info(regexStr, testStrings, namedOnly):
 
    return groupDict
 
+# growth classes, in the order of the engine's classification
+GROWTH_CLASSES = ["linear", "quadratic", "cubic", "exponential"]
+
+# returns the (prefix, pump, suffix) of each REDOS finding in the list of
+# (code, message) warnings
+def get_redos_findings(warnings):
+    findings = []
+    for (code, message) in warnings:
+        if code == "REDOS":
+            parts = []
+            for line in message.split("\n")[1:4]:
+                quoted = line.split(":", 1)[1].strip()[1:-1]
+                parts.append(quoted.encode("latin-1").decode("unicode_escape")
+                             .encode("latin-1").decode("utf-8", "replace"))
+            findings.append(tuple(parts))
+    return findings
+
+# classifies the growth of values measured at increasing pump counts the
+# same way the engine does: the last value is compared with the last one
+# at half the pumps or fewer
+def classify_growth(pumps, values):
+    if len(pumps) < 2:
+        return "linear"
+    j = len(pumps) - 1
+    i = 0
+    for k in range(j):
+        if 2 * pumps[k] <= pumps[j]:
+            i = k
+    if values[i] <= 0 or values[j] <= values[i]:
+        return "linear"
+    growth = math.log(values[j] / values[i])
+    exponent = growth / math.log(pumps[j] / pumps[i])
+    if math.exp(growth / (pumps[j] - pumps[i])) >= 1.5:
+        return "exponential"
+    elif exponent >= 2.5:
+        return "cubic"
+    elif exponent >= 1.5:
+        return "quadratic"
+    return "linear"
+
+# times re on prefix + pump * k + suffix for a growing number of pumps k
+# (until a match takes longer than limit seconds) and classifies the growth
+def time_growth(regex, prefix, pump, suffix, limit = 0.2, maxPumps = 100000):
+    pumps = []
+    times = []
+    k = 1
+    while k <= maxPumps:
+        testStr = prefix + pump * k + suffix
+        best = None
+        for i in range(3):
+            start = time.perf_counter()
+            regex.fullmatch(testStr)
+            elapsed = time.perf_counter() - start
+            best = elapsed if best == None else min(best, elapsed)
+            if best > 0.001:
+                break
+        pumps.append(k)
+        times.append(best)
+        if best > limit:
+            break
+        nextK = k + 1 if k < 4 else k + k // 2
+
+        # do not start a match that would take far too long
+        if len(times) >= 2 and times[-2] > 0:
+            ratio = (times[-1] / times[-2]) ** (1.0 / (pumps[-1] - pumps[-2]))
+            if ratio >= 1.5 and best * ratio ** (nextK - k) > 10 * limit:
+                break
+        k = nextK
+    return classify_growth(pumps, times)
+
 parser = OptionParser()
 parser.add_option("-f", "--file", dest = "fileName", help = "file containing regex")
 parser.add_option("-r", "--regex", dest = "regex", help = "regular expression")
@@ -83,6 +154,30 @@ parser.add_option("-g", "--groups", action = "store_true", dest = "showGroups",
     default = False, help = "show groups")
 parser.add_option("-n", "--named_groups", action = "store_true", dest = "showNamedGroups",
     default = False, help = "only show named groups")
+parser.add_option("--max_strings", type = "int", dest = "maxStrings",
+    default = 0, help = "maximum number of test strings (0 for no limit)")
+parser.add_option("--max_bytes", type = "int", dest = "maxBytes",
+    default = 0, help = "maximum total bytes of test strings (0 for no limit)")
+parser.add_option("--max_length", type = "int", dest = "maxLength",
+    default = 0, help = "maximum length of a test string (0 for no limit)")
+parser.add_option("--suite", dest = "suiteFile",
+    help = "also write the test strings to a binary suite file")
+parser.add_option("--paths", dest = "paths", default = "basis",
+    help = "how paths are chosen: basis or cover (fewest paths covering every edge)")
+parser.add_option("-j", "--threads", type = "int", dest = "threads",
+    default = 1, help = "threads generating evil strings (0 for one per core)")
+parser.add_option("--profile", action = "store_true", dest = "profile",
+    default = False, help = "display the backtracking steps taken by the test strings")
+parser.add_option("--growth", action = "store_true", dest = "growth",
+    default = False, help = "measure how matching steps grow for each backtracking warning")
+parser.add_option("--growth_timing", action = "store_true", dest = "growthTiming",
+    default = False, help = "time how Python's re slows down for each backtracking warning")
+parser.add_option("--trace", dest = "traceFile",
+    help = "write a Chrome trace of the run to a file")
+parser.add_option("--trace_paths", action = "store_true", dest = "tracePaths",
+    default = False, help = "trace the work for each path as well as each phase")
+parser.add_option("-t", "--timeout", type = "float", dest = "timeout",
+    default = 0, help = "time limit in seconds (0 for no limit)")
 opts, args = parser.parse_args()
 
 # check for valid command lines
@@ -107,11 +202,15 @@ else:
 
 # execute regex-test
 #start_time = time.process_time()
-inputStrs = egret_ext.run(regexStr, opts.baseSubstring, opts.debugMode, opts.statMode)
-status = inputStrs[0]
-inputStrs = inputStrs[1:]
-hasError = (status[0:5] == "ERROR")
-hasWarning = (not hasError and status != "SUCCESS")
+result = egret_ext.run_result(regexStr, opts.baseSubstring, opts.debugMode, opts.statMode,
+                              max_strings = opts.maxStrings, max_bytes = opts.maxBytes,
+                              max_length = opts.maxLength, timeout = opts.timeout,
+                              paths = opts.paths, threads = opts.threads,
+                              profile = opts.profile, growth = opts.growth,
+                              trace = opts.traceFile, trace_paths = opts.tracePaths)
+inputStrs = result.strings
+hasError = (result.status == egret_ext.STATUS_ERROR)
+warnings = [ message for (code, message) in result.warnings ]
 
 if not hasError:
 
@@ -127,17 +226,20 @@ if not hasError:
         nonMatches.append(inputStr)
   #elapsed_time = time.process_time() - start_time
 
+  # write the binary suite (with accept results) if requested, from the
+  # strings already generated
+  if opts.suiteFile:
+      accepted = set(matches)
+      egret_ext.write_result(result, regexStr, opts.baseSubstring, opts.suiteFile,
+                             lambda s: s in accepted)
+
   # display groups if requested
   if opts.showGroups or opts.showNamedGroups:
       groupDict = get_group_info(regexStr, matches, opts.showNamedGroups)
       if groupDict == None:
           showGroups = False
           if opts.showGroups:
-              if hasWarning:
-                  status = status + "Regex does not have any capturing groups\n"
-              else:
-                  hasWarning = True
-                  status = "Regex does not have any capturing groups\n"
+              warnings.append("Regex does not have any capturing groups")
       else:
           showGroups = True
           maxLength = 7 # smallest size of format
@@ -156,15 +258,31 @@ if not hasError:
     print(fmt.format("Non-matches", len(nonMatches)))
     #print(fmt.format("Time", elapsed_time))
 
+  # classify the growth of the matching time (linear if no finding)
+  if opts.growthTiming:
+      worst = 0
+      for (prefix, pump, suffix) in get_redos_findings(result.warnings):
+          growth = GROWTH_CLASSES.index(time_growth(regex, prefix, pump, suffix))
+          worst = max(worst, growth)
+      timedGrowth = GROWTH_CLASSES[worst]
+
 
 # write the output header
 header = "Regex: " + regexStr + "\n\n"
 if descStr != "":
     header += ("Description: " + descStr + "\n\n")
 if hasError:
-    header += (status + "\n")
-elif hasWarning:
-    header += ("Warnings:\n" + status + "\n")
+    header += (result.error + "\n")
+elif len(warnings) > 0:
+    header += ("Warnings:\n" + "\n".join(warnings) + "\n\n")
+if not hasError and opts.growth:
+    growth = "linear"
+    for (code, message) in result.warnings:
+        if code == "GROWTH":
+            growth = message.split()[-1]
+    header += ("Growth (matcher steps): " + growth + "\n\n")
+if not hasError and opts.growthTiming:
+    header += ("Growth (re timing): " + timedGrowth + "\n\n")
 
 if opts.outputFile:
     outFile = open(opts.outputFile, 'w')
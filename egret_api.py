@@ -19,24 +19,58 @@
 # along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 import re
+import threading
+import time
+from collections import OrderedDict
 import egret_ext
 
-def run_egret(regexStr, baseSubstring, testList):
-    inputStrs = egret_ext.run(regexStr, baseSubstring, False, False)
-    status = inputStrs[0]
-    if status[0:5] == "ERROR":
-        return ([], [], status, [])
-    elif status == "SUCCESS":
+# Compiled regexes of recent requests, so a regex run again with another
+# base substring or limits is not compiled again.  Regexes that did not
+# compile are not kept, since the compile may only have run out of time.
+COMPILED_CACHE_SIZE = 32
+compiledCache = OrderedDict()
+compiledCacheLock = threading.Lock()
+
+def get_compiled(regexStr, timeout = 0):
+    with compiledCacheLock:
+        compiled = compiledCache.get(regexStr)
+        if compiled is not None:
+            compiledCache.move_to_end(regexStr)
+            return compiled
+    compiled = egret_ext.compile(regexStr, timeout = timeout)
+    if compiled.error is None:
+        with compiledCacheLock:
+            compiledCache[regexStr] = compiled
+            if len(compiledCache) > COMPILED_CACHE_SIZE:
+                compiledCache.popitem(last = False)
+    return compiled
+
+# Limits of 0 mean no limit, timeout is in seconds (and covers compiling
+# the regex as well as generating the strings), paths is basis or cover.
+def run_egret(regexStr, baseSubstring, testList, maxStrings = 0, maxBytes = 0, maxLength = 0,
+              timeout = 0, paths = "basis"):
+    start = time.monotonic()
+    compiled = get_compiled(regexStr, timeout)
+    if timeout > 0:
+        # a limit of 0 would mean no limit, so keep a sliver of time
+        timeout = max(timeout - (time.monotonic() - start), 0.001)
+    result = compiled.generate(baseSubstring, max_strings = maxStrings,
+                               max_bytes = maxBytes, max_length = maxLength,
+                               timeout = timeout, paths = paths)
+    if result.status == egret_ext.STATUS_ERROR:
+        return ([], [], result.error, [])
+    elif result.status == egret_ext.STATUS_SUCCESS:
         warnings = None
     else:
-        warnings = status.rstrip().split("\n")
+        warnings = []
+        for (code, message) in result.warnings:
+            warnings.extend(message.split("\n"))
 
-    inputStrs = inputStrs[1:]
     matches = []
     nonMatches = []
     regex = re.compile(regexStr)
 
-    inputStrs = sorted(list(set(inputStrs) | set(testList)))
+    inputStrs = sorted(set(result.strings) | set(testList))
     
     for inputStr in inputStrs:
         search = regex.fullmatch(inputStr)
@@ -0,0 +1,158 @@
+# egret_suite.py: Reader for EGRET binary suite files
+#
+# Copyright (C) 2016  Eric Larson and Anna Kirk
+# elarson@seattleu.edu
+#
+# This file is part of EGRET.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# The file layout is described in src/SuiteFile.h.  Strings are decoded from
+# the mapped file on demand, so opening a suite does not read the strings.
+
+import mmap
+import struct
+
+MAGIC = b"EGRSUITE"
+FORMAT_VERSION = 1
+HEADER = struct.Struct("<8sIIQIIQQQQ16s")
+
+HAS_ACCEPT = 0x1
+HAS_SOURCES = 0x2
+
+# string sources (same order as StringSource in src/Sink.h)
+INITIAL = 0
+BACKREFERENCE = 1
+EVIL = 2
+
+# 64-bit FNV-1a of regex and base substring (matches suite_fingerprint)
+def fingerprint(regexStr, baseSubstring):
+    h = 14695981039346656037
+    for b in regexStr.encode() + b"\0" + baseSubstring.encode():
+        h ^= b
+        h = (h * 1099511628211) & 0xffffffffffffffff
+    return h
+
+class Suite:
+
+    def __init__(self, fileName):
+        with open(fileName, "rb") as f:
+            self._data = mmap.mmap(f.fileno(), 0, access = mmap.ACCESS_READ)
+        if len(self._data) < HEADER.size:
+            raise ValueError("Invalid suite file " + fileName)
+        (magic, version, self.flags, self.fingerprint, self._count, self._restart,
+         self._indexPos, self._acceptPos, self._sourcesPos, self._statusPos,
+         engineVersion) = HEADER.unpack_from(self._data, 0)
+        if magic != MAGIC or version != FORMAT_VERSION or self._restart == 0:
+            raise ValueError("Invalid suite file " + fileName)
+        self.engine_version = engineVersion.rstrip(b"\0").decode()
+        self._bitmapSize = (self._count + 7) // 8
+
+    def close(self):
+        self._data.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def __len__(self):
+        return self._count
+
+    def _varint(self, pos):
+        v = 0
+        shift = 0
+        while True:
+            b = self._data[pos]
+            pos += 1
+            v |= (b & 0x7f) << shift
+            if not (b & 0x80):
+                return (v, pos)
+            shift += 7
+
+    # yields (index, bytes) for the strings in a restart block
+    def _block(self, block):
+        (pos,) = struct.unpack_from("<Q", self._data, self._indexPos + 8 * block)
+        s = b""
+        first = block * self._restart
+        for i in range(first, min(first + self._restart, self._count)):
+            (shared, pos) = self._varint(pos)
+            (suffix, pos) = self._varint(pos)
+            s = s[:shared] + self._data[pos:pos + suffix]
+            pos += suffix
+            yield (i, s)
+
+    def _get(self, i):
+        for (j, s) in self._block(i // self._restart):
+            if j == i:
+                return s
+
+    def __getitem__(self, i):
+        if i < 0:
+            i += self._count
+        if i < 0 or i >= self._count:
+            raise IndexError("suite index out of range")
+        return self._get(i).decode()
+
+    def __iter__(self):
+        for block in range((self._count + self._restart - 1) // self._restart):
+            for (i, s) in self._block(block):
+                yield s.decode()
+
+    # returns the index of a string, or -1 if it is not in the suite
+    def find(self, testStr):
+        if self._count == 0:
+            return -1
+        key = testStr.encode()
+        lo = 0
+        hi = (self._count + self._restart - 1) // self._restart
+        while hi - lo > 1:
+            mid = (lo + hi) // 2
+            if self._get(mid * self._restart) <= key:
+                lo = mid
+            else:
+                hi = mid
+        for (i, s) in self._block(lo):
+            if s == key:
+                return i
+            if s > key:
+                break
+        return -1
+
+    def __contains__(self, testStr):
+        return self.find(testStr) >= 0
+
+    def _bit(self, pos, i):
+        return bool((self._data[pos + i // 8] >> (i % 8)) & 1)
+
+    def has_accept(self):
+        return (self.flags & HAS_ACCEPT) != 0
+
+    # returns True if the regex accepts string i (None if not recorded)
+    def accepted(self, i):
+        if not self.has_accept():
+            return None
+        return self._bit(self._acceptPos, i)
+
+    # returns the set of sources (INITIAL, BACKREFERENCE, EVIL) for string i
+    def sources(self, i):
+        if not (self.flags & HAS_SOURCES):
+            return set()
+        return set(src for src in (INITIAL, BACKREFERENCE, EVIL)
+                   if self._bit(self._sourcesPos + src * self._bitmapSize, i))
+
+    def status(self):
+        (length,) = struct.unpack_from("<I", self._data, self._statusPos)
+        return self._data[self._statusPos + 4:self._statusPos + 4 + length].decode()
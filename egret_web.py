@@ -37,6 +37,12 @@ data['useDiffBase'] = False
 UPLOAD_FOLDER = '/tmp' # Uploads module requires this to be set, but nothing is actually saved there
 ALLOWED_EXTENSIONS = set(['txt'])
 
+# limits on the generated test strings for a single request
+MAX_STRINGS = 10000
+MAX_BYTES = 1000000
+MAX_LENGTH = 10000
+TIMEOUT = 5.0 # seconds
+
 # configuration
 DEBUG = True
 
@@ -97,7 +103,8 @@ def run_egret():
       
     if data['regex'] != '':
       (data['passList'], data['failList'], data['errorMsg'], data['warnings']) = \
-        egret_api.run_egret(data['regex'], baseSubstr, session)
+        egret_api.run_egret(data['regex'], baseSubstr, session,
+                            MAX_STRINGS, MAX_BYTES, MAX_LENGTH, TIMEOUT)
     else:
       (data['passList'], data['failList'], data['errorMsg'], data['warnings']) = \
         ([], [], None, None)
@@ -0,0 +1,97 @@
+/*  Budget.cpp: resource limits for test string generation
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <sstream>
+#include <string>
+#include "Budget.h"
+#include "Stats.h"
+#include "error.h"
+using namespace std;
+
+void
+Budget::set_limits(unsigned int _max_strings, unsigned long _max_bytes, unsigned int _max_length)
+{
+  max_strings = _max_strings;
+  max_bytes = _max_bytes;
+  max_length = _max_length;
+}
+
+bool
+Budget::admit(const string &s)
+{
+  // strings that are too long are dropped, but generation continues
+  if (max_length != 0 && s.length() > max_length) {
+    dropped_length++;
+    return false;
+  }
+
+  // once the string or byte limit is reached, everything else is dropped
+  if (!exhausted && max_bytes != 0 && bytes + s.length() > max_bytes) {
+    exhausted = true;
+    byte_limit_hit = true;
+  }
+  if (exhausted) {
+    dropped_limit++;
+    return false;
+  }
+
+  strings++;
+  bytes += s.length();
+  if (max_strings != 0 && strings >= max_strings) exhausted = true;
+  return true;
+}
+
+bool
+Budget::is_truncated()
+{
+  return dropped_limit != 0 || dropped_length != 0 || skipped_paths != 0;
+}
+
+void
+Budget::add_warnings()
+{
+  if (dropped_limit != 0 || skipped_paths != 0) {
+    stringstream s;
+    if (byte_limit_hit)
+      s << "LIMIT WARNING: Reached maximum of " << max_bytes << " bytes of test strings\n";
+    else
+      s << "LIMIT WARNING: Reached maximum of " << max_strings << " test strings\n";
+    s << "...Strings dropped: " << dropped_limit << "\n";
+    s << "...Paths skipped:   " << skipped_paths;
+    addWarning(s.str());
+  }
+  if (dropped_length != 0) {
+    stringstream s;
+    s << "LIMIT WARNING: Dropped " << dropped_length
+      << " test strings longer than " << max_length << " characters";
+    addWarning(s.str());
+  }
+}
+
+void
+Budget::add_stats(Stats &stats)
+{
+  stats.add("BUDGET", "Budget strings", strings);
+  stats.add("BUDGET", "Budget bytes", bytes);
+  stats.add("BUDGET", "Dropped (string/byte limit)", dropped_limit);
+  stats.add("BUDGET", "Dropped (length limit)", dropped_length);
+  stats.add("BUDGET", "Skipped paths", skipped_paths);
+}
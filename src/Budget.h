@@ -0,0 +1,82 @@
+/*  Budget.h: resource limits for test string generation
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BUDGET_H
+#define BUDGET_H
+
+#include <string>
+#include "Stats.h"
+using namespace std;
+
+class Budget {
+
+public:
+
+  Budget() {
+    max_strings = 0;
+    max_bytes = 0;
+    max_length = 0;
+    strings = 0;
+    bytes = 0;
+    exhausted = false;
+    byte_limit_hit = false;
+    dropped_limit = 0;
+    dropped_length = 0;
+    skipped_paths = 0;
+  }
+
+  // sets the limits (a limit of 0 means no limit)
+  void set_limits(unsigned int _max_strings, unsigned long _max_bytes, unsigned int _max_length);
+
+  // returns true if the string fits in the budget and charges it against
+  // the budget, returns false (and records the drop) otherwise
+  bool admit(const string &s);
+
+  // returns true if no further strings can be admitted
+  bool is_exhausted() { return exhausted; }
+
+  // records paths that were not processed because the budget ran out
+  void skip_paths(unsigned int count) { skipped_paths += count; }
+
+  // returns true if any string was dropped or path was skipped
+  bool is_truncated();
+
+  // adds warnings describing what was dropped
+  void add_warnings();
+
+  // add budget stats
+  void add_stats(Stats &stats);
+
+private:
+
+  unsigned int max_strings;	// maximum number of strings (0 if no limit)
+  unsigned long max_bytes;	// maximum total bytes (0 if no limit)
+  unsigned int max_length;	// maximum length of a string (0 if no limit)
+  unsigned int strings;		// number of strings admitted
+  unsigned long bytes;		// number of bytes admitted
+  bool exhausted;		// set when the string or byte limit is reached
+  bool byte_limit_hit;		// set if the byte limit (not string limit) was reached
+  unsigned int dropped_limit;	// strings dropped after the budget was exhausted
+  unsigned int dropped_length;	// strings dropped due to the length limit
+  unsigned int skipped_paths;	// paths skipped after the budget ran out
+};
+
+#endif // BUDGET_H
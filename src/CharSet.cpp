@@ -19,7 +19,7 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#include <cassert>
+#include <cstdint>
 #include <iostream>
 #include <set>
 #include <sstream>
@@ -27,14 +27,280 @@
 #include "CharSet.h"
 #include "error.h"
 #include "StringPath.h"
-#include <string>
+#include "UnicodeTables.h"
+#include "Utf8.h"
 #include <algorithm>
+#include <string>
 using namespace std;
 
+//=============================================================
+// Character class tables
+//=============================================================
+
+// bits for characters lo..hi that fall in a word (lo and hi are 0..63)
+static constexpr uint64_t
+span_bits(int lo, int hi)
+{
+  return lo > hi ? 0 : (hi - lo == 63 ? ~(uint64_t) 0 : (((uint64_t) 1 << (hi - lo + 1)) - 1) << lo);
+}
+
+// bits for characters lo..hi that fall in word w
+static constexpr uint64_t
+range_bits(int w, int lo, int hi)
+{
+  return span_bits(lo > 64 * w ? lo - 64 * w : 0, hi < 64 * w + 63 ? hi - 64 * w : 63);
+}
+
+static constexpr uint64_t
+digit_bits(int w)
+{
+  return range_bits(w, '0', '9');
+}
+
+static constexpr uint64_t
+word_bits(int w)
+{
+  return range_bits(w, '0', '9') | range_bits(w, 'A', 'Z') | range_bits(w, '_', '_') | range_bits(w, 'a', 'z');
+}
+
+static constexpr uint64_t
+space_bits(int w)
+{
+  return range_bits(w, ' ', ' ');
+}
+
+static constexpr uint64_t
+punct_bits(int w)
+{
+  return range_bits(w, 33, 47) | range_bits(w, 58, 64) | range_bits(w, 91, 96) | range_bits(w, 123, 126);
+}
+
+static constexpr uint64_t DIGIT_CHARS[4] = { digit_bits(0), digit_bits(1), digit_bits(2), digit_bits(3) };
+static constexpr uint64_t WORD_CHARS[4] = { word_bits(0), word_bits(1), word_bits(2), word_bits(3) };
+static constexpr uint64_t SPACE_CHARS[4] = { space_bits(0), space_bits(1), space_bits(2), space_bits(3) };
+static constexpr uint64_t NON_DIGIT_CHARS[4] = { ~digit_bits(0), ~digit_bits(1), ~digit_bits(2), ~digit_bits(3) };
+static constexpr uint64_t NON_WORD_CHARS[4] = { ~word_bits(0), ~word_bits(1), ~word_bits(2), ~word_bits(3) };
+static constexpr uint64_t NON_SPACE_CHARS[4] = { ~space_bits(0), ~space_bits(1), ~space_bits(2), ~space_bits(3) };
+static constexpr uint64_t WILDCARD_CHARS[4] = { ~range_bits(0, '\n', '\n'), ~(uint64_t) 0, ~(uint64_t) 0, ~(uint64_t) 0 };
+
+// letters and digits
+static constexpr uint64_t ALNUM_CHARS[4] = {
+  range_bits(0, '0', '9') | range_bits(0, 'A', 'Z') | range_bits(0, 'a', 'z'),
+  range_bits(1, '0', '9') | range_bits(1, 'A', 'Z') | range_bits(1, 'a', 'z'), 0, 0 };
+
+// order in which a complemented set is searched for a valid character
+static constexpr uint64_t LOWER_CHARS[4] = { range_bits(0, 'a', 'z'), range_bits(1, 'a', 'z'), 0, 0 };
+static constexpr uint64_t UPPER_CHARS[4] = { range_bits(0, 'A', 'Z'), range_bits(1, 'A', 'Z'), 0, 0 };
+static constexpr uint64_t PUNCT_CHARS[4] = { punct_bits(0), punct_bits(1), 0, 0 };
+static const uint64_t *VALID_CHAR_ORDER[] = { LOWER_CHARS, UPPER_CHARS, DIGIT_CHARS, SPACE_CHARS, PUNCT_CHARS };
+
+// returns the table for a character class
+static const uint64_t *
+class_chars(char c)
+{
+  switch (c) {
+    case 'w':	return WORD_CHARS;
+    case 'd':	return DIGIT_CHARS;
+    case 's':	return SPACE_CHARS;
+    case 'W':	return NON_WORD_CHARS;
+    case 'D':	return NON_DIGIT_CHARS;
+    case 'S':	return NON_SPACE_CHARS;
+    case '.':	return WILDCARD_CHARS;
+    default:
+    {
+      stringstream s;
+      s << "ERROR (internal): Invalid character class in character set: " << c;
+      throw EgretException(s.str());
+    }
+  }
+}
+
+// returns true if a character class includes every code point from 256 up
+static bool
+class_has_wide_chars(char c)
+{
+  return c == 'W' || c == 'D' || c == 'S' || c == '.';
+}
+
+// adds the code points of an item to the set of code points below 256 and
+// (if wide is not NULL) the set of code points from 256 up
+static void
+item_members(const CharSetItem &item, CharBitmap &low, IntervalSet *wide)
+{
+  switch (item.type) {
+    case CHARACTER_ITEM:
+      low.add(item.character);
+      break;
+    case CHAR_CLASS_ITEM:
+      low.add_words(class_chars(item.character));
+      if (wide && class_has_wide_chars(item.character)) wide->add(256, MAX_CODE_POINT);
+      break;
+    case CHAR_RANGE_ITEM:
+      low.add_range(item.range_start, item.range_end);
+      break;
+    case CODE_POINT_ITEM:
+      for (unsigned int cp = item.cp_start; cp <= item.cp_end && cp < 256; cp++) {
+	low.add((char) cp);
+      }
+      if (wide && item.cp_end >= 256) wide->add(max(item.cp_start, 256U), item.cp_end);
+      break;
+    case PROPERTY_ITEM:
+    {
+      const UnicodeProperty *prop = find_unicode_property(item.property);
+      if (prop == NULL) {
+	throw EgretException("ERROR (internal): Invalid Unicode property: " + item.property);
+      }
+      CharBitmap prop_low;
+      for (unsigned int i = 0; i < prop->count && prop->ranges[i].first < 256; i++) {
+	for (unsigned int cp = prop->ranges[i].first; cp <= prop->ranges[i].last && cp < 256; cp++) {
+	  prop_low.add((char) cp);
+	}
+      }
+      if (item.character == 'p') {
+	low.add_words(prop_low.get_words());
+	if (wide) {
+	  for (unsigned int i = 0; i < prop->count; i++) {
+	    if (prop->ranges[i].last >= 256)
+	      wide->add(max(prop->ranges[i].first, 256U), prop->ranges[i].last);
+	  }
+	}
+      }
+      else {
+	low.add_words(prop_low.complement().get_words());
+	if (wide) wide->add_complement(prop->ranges, prop->count, 256, MAX_CODE_POINT);
+      }
+      break;
+    }
+  }
+}
+
+// finds the lowest printable code point at or after from whose membership
+// in low / wide (wide membership flipped if wide_flipped) equals member
+static bool
+find_printable(const CharBitmap &low, const IntervalSet &wide, bool wide_flipped,
+               unsigned int from, bool member, unsigned int &cp)
+{
+  for (cp = max(from, 0x20U); cp < 256; cp++) {
+    if (cp >= 0x7F && cp < 0xA0) continue;	// control characters
+    if (low.contains((char) cp) == member) return true;
+  }
+  cp = from > 256 ? from : 256;
+  while (wide.find(cp, member != wide_flipped, cp)) {
+    if (cp < 0xD800 || cp > 0xDFFF) return true;
+    cp = 0xE000;	// skip surrogates
+  }
+  return false;
+}
+
+//=============================================================
+// IntervalSet
+//=============================================================
+
+void
+IntervalSet::add_complement(const UnicodeRange *table, unsigned int count, unsigned int from,
+                            unsigned int last)
+{
+  unsigned int next = from;
+  for (unsigned int i = 0; i < count && next <= last; i++) {
+    if (table[i].last < next) continue;
+    if (table[i].first > next) add(next, min(table[i].first - 1, last));
+    next = table[i].last + 1;
+  }
+  if (next <= last) add(next, last);
+}
+
+void
+IntervalSet::normalize()
+{
+  sort(ranges.begin(), ranges.end());
+  vector <pair <unsigned int, unsigned int> > merged;
+  vector <pair <unsigned int, unsigned int> >::iterator it;
+  for (it = ranges.begin(); it != ranges.end(); it++) {
+    if (!merged.empty() && it->first <= merged.back().second + 1) {
+      merged.back().second = max(merged.back().second, it->second);
+    }
+    else {
+      merged.push_back(*it);
+    }
+  }
+  ranges.swap(merged);
+}
+
+bool
+IntervalSet::contains(unsigned int cp) const
+{
+  // find the first range starting after cp, the range before it may hold cp
+  vector <pair <unsigned int, unsigned int> >::const_iterator it =
+    upper_bound(ranges.begin(), ranges.end(), make_pair(cp, ~0U));
+  if (it == ranges.begin()) return false;
+  --it;
+  return cp <= it->second;
+}
+
+bool
+IntervalSet::find(unsigned int from, bool member, unsigned int &cp) const
+{
+  vector <pair <unsigned int, unsigned int> >::const_iterator it =
+    upper_bound(ranges.begin(), ranges.end(), make_pair(from, ~0U));
+  bool in_range = false;
+  if (it != ranges.begin()) {
+    in_range = from <= (it - 1)->second;
+  }
+
+  if (member) {
+    if (in_range) {
+      cp = from;
+      return true;
+    }
+    if (it == ranges.end()) return false;
+    cp = it->first;
+    return true;
+  }
+
+  cp = in_range ? (it - 1)->second + 1 : from;
+  return cp <= MAX_CODE_POINT;
+}
+
+//=============================================================
+// CharBitmap
+//=============================================================
+
+void
+CharBitmap::add_range(char start, char end)
+{
+  for (int c = start; c <= end; c++) {
+    add((char) c);
+  }
+}
+
+bool
+CharBitmap::first_in(const uint64_t *w, char &c) const
+{
+  for (int i = 0; i < 4; i++) {
+    uint64_t found = words[i] & w[i];
+    if (found != 0) {
+      c = (char) (64 * i + __builtin_ctzll(found));
+      return true;
+    }
+  }
+  return false;
+}
+
+//=============================================================
+// CharSet
+//=============================================================
+
 void
 CharSet::add_item(CharSetItem item)
 {
   items.push_back(item);
+  has_signature = false;
+  has_test_chars = false;
+
+  item_members(item, members, &wide_members);
+  wide_members.normalize();
+  if (item.type != CHARACTER_ITEM) only_characters = false;
+  if (item.type == CODE_POINT_ITEM || item.type == PROPERTY_ITEM) has_unicode_items = true;
 }
 
 bool
@@ -60,22 +326,33 @@ CharSet::is_string_candidate()
         if (it->range_start == 'a' && it->range_end == 'z') return true;
         if (it->range_start == 'A' && it->range_end == 'Z') return true;
 	break;
+      case CODE_POINT_ITEM:
+	break;	// Ignore
+      case PROPERTY_ITEM:
+      {
+	// properties that include all lowercase or all uppercase letters
+	CharBitmap low;
+	item_members(*it, low, NULL);
+	if (low.superset_of(LOWER_CHARS) || low.superset_of(UPPER_CHARS)) return true;
+	break;
+      }
     }
   }
 
   return false;
 }
 
-char
+string
 CharSet::get_valid_character()
 {
   vector <CharSetItem>::iterator it;
+  unsigned int cp;
 
   if (!complement) {
     // If set is not complemented, choose the first explicit character.
     for (it = items.begin(); it != items.end(); it++) {
       if (it->type == CHARACTER_ITEM) {
-	return it->character;
+	return string(1, it->character);
       }
     }
     // If set is not complemented and there are no explicit character,
@@ -86,13 +363,13 @@ CharSet::get_valid_character()
 	  break; 	// Ignore - alreay processed in earlier loop.
         case CHAR_CLASS_ITEM:
           switch (it->character) {
-  	    case 'w':	return 'a';
-	    case 'd':	return '0';
-	    case 's':	return ' ';
-	    case 'W':	return ';';
-	    case 'D':	return 'a';
-	    case 'S':	return 'a';
-	    case '.':	return 'a';
+  	    case 'w':	return "a";
+	    case 'd':	return "0";
+	    case 's':	return " ";
+	    case 'W':	return ";";
+	    case 'D':	return "a";
+	    case 'S':	return "a";
+	    case '.':	return "a";
 	    default:
 	    {
 	      stringstream s;
@@ -103,37 +380,34 @@ CharSet::get_valid_character()
 	  }
           break;
         case CHAR_RANGE_ITEM:
-  	  return it->range_start;
+  	  return string(1, it->range_start);
+	  break;
+        case CODE_POINT_ITEM:
+	  return utf8_encode(it->cp_start);
+        case PROPERTY_ITEM:
+	{
+	  CharBitmap low;
+	  IntervalSet wide;
+	  item_members(*it, low, &wide);
+	  wide.normalize();
+	  if (find_printable(low, wide, false, 0, true, cp)) return utf8_encode(cp);
 	  break;
+	}
       }
     }
     throw EgretException("ERROR (internal): Could not find good char in regular char set");
   }
 
-  // At this point, the character set is complemented. Find the first valid character.
-  for (char c = 'a'; c <= 'z'; c++) {
-    if (is_valid_character(c)) return c;
+  // At this point, the character set is complemented. Find the first valid character,
+  // trying lowercase, uppercase, digits, space, and then punctuation.
+  CharBitmap valid = members.complement();
+  for (unsigned int i = 0; i < sizeof(VALID_CHAR_ORDER) / sizeof(VALID_CHAR_ORDER[0]); i++) {
+    char c;
+    if (valid.first_in(VALID_CHAR_ORDER[i], c)) return string(1, c);
   }
-  for (char c = 'A'; c <= 'Z'; c++) {
-    if (is_valid_character(c)) return c;
-  }
-  for (char c = '0'; c <= '9'; c++) {
-    if (is_valid_character(c)) return c;
-  }
-  if (is_valid_character(' ')) return ' ';
 
-  for (char c = 33; c <= 47; c++) {
-    if (is_valid_character(c)) return c;
-  }
-  for (char c = 58; c <= 64; c++) {
-    if (is_valid_character(c)) return c;
-  }
-  for (char c = 91; c <= 96; c++) {
-    if (is_valid_character(c)) return c;
-  }
-  for (char c = 123; c <= 126; c++) {
-    if (is_valid_character(c)) return c;
-  }
+  // Otherwise use the first valid character outside ASCII.
+  if (find_code_point(0xA0, true, cp)) return utf8_encode(cp);
 
   throw EgretException("ERROR (internal): Could not find good char in complemented char set");
 }
@@ -185,12 +459,15 @@ CharSet::check_only_digits_and_punctuation()
 	found_other = true;
       }
     }
+    else {
+      found_other = true;
+    }
   }
 
   if (found_digit && found_punctuation && !found_other) {
     stringstream s;
     s << "WARNING: Character set contains only digits and punctuation marks";
-    addWarning(s.str());
+    add_test_warning(s.str());
   }
 }
 
@@ -234,139 +511,138 @@ CharSet::check_single_punctuation()
   if (found_punctuation && !found_another_punctuation && !ignore && other_chars) {
     stringstream s;
     s << "WARNING: Only punctuation mark inside a character set is: " << string(1, punctuation_mark);
-    addWarning(s.str());
+    add_test_warning(s.str());
   }
 }
 
 string
 CharSet::get_charset_as_string()
 {
+  if (has_signature) return signature;
+
+  // explicit characters in sorted order (duplicates kept)
+  unsigned int counts[256] = { 0 };
   vector <CharSetItem>::iterator it;
-  string ret = "";
-  vector<CharSetItem> sorted_items = items;
+  for (it = items.begin(); it != items.end(); it++) {
+    if (it->type == CHARACTER_ITEM) counts[(unsigned char) it->character]++;
+  }
+  signature = "";
+  for (int c = -128; c < 128; c++) {
+    signature.append(counts[(unsigned char) c], (char) c);
+  }
+  has_signature = true;
 
-  struct sortClass {
-    bool operator() (CharSetItem x, CharSetItem y) { return (x.character <= y.character); }
-  } sortObject;
-  
-  std::sort(sorted_items.begin(), sorted_items.end(), sortObject);
+  return signature;
+}
 
-  for (it = sorted_items.begin(); it != sorted_items.end(); it++) {
-    ret.push_back(it->character);
-  }
-  
-  return ret;
+void
+CharSet::prepare(const set <char> &punct_marks)
+{
+  get_charset_as_string();
+
+  // the warnings are kept with the test characters and issued by each run
+  string ignored;
+  WarningScope scope(&ignored);
+  get_test_chars(punct_marks);
 }
 
-bool
-CharSet::only_has_characters()
+string
+CharSet::get_key()
 {
-  bool only_characters = true;
+  stringstream s;
+  s << (complement ? '^' : '[');
   vector <CharSetItem>::iterator it;
-
   for (it = items.begin(); it != items.end(); it++) {
-    if (it->type != CHARACTER_ITEM) {
-      only_characters = false;
-    }
-    else {
-      char c = it->character;
-      if ((c < 48) || ((c > 57) && (c < 65)) || ((c > 90) && (c < 97)) || (c > 122)) {
-	only_characters = false;
-      }
+    s << it->type << ':';
+    switch (it->type) {
+    case CHARACTER_ITEM:
+    case CHAR_CLASS_ITEM:
+      s << (int) it->character;
+      break;
+    case CHAR_RANGE_ITEM:
+      s << (int) it->range_start << '-' << (int) it->range_end;
+      break;
+    case CODE_POINT_ITEM:
+      s << it->cp_start << '-' << it->cp_end;
+      break;
+    case PROPERTY_ITEM:
+      s << it->character << it->property;
+      break;
     }
+    s << ',';
   }
-  
-  return only_characters;
+  s << ']';
+  return s.str();
 }
 
 bool
-CharSet::is_charset_complemented()
+CharSet::only_has_characters()
 {
-  return complement;
+  return only_characters && members.subset_of(ALNUM_CHARS);
 }
 
 bool
-CharSet::is_valid_character(char character)
+CharSet::is_charset_complemented()
 {
-  assert(complement);
-
-  vector <CharSetItem>::iterator it;
-  for (it = items.begin(); it != items.end(); it++) {
-    switch (it->type) {
-      case CHARACTER_ITEM:
-	if (character == it->character) return false;
-	break;
-      case CHAR_CLASS_ITEM:
-        switch (it->character) {
-          case 'w':
-	    if (character >= 'a' && character <= 'z') return false; 
-	    if (character >= 'A' && character <= 'Z') return false; 
-	    if (character >= '0' && character <= '9') return false; 
-	    if (character == '_') return false; 
-	    break;
-	  case 'd':
-	    if (character >= '0' && character <= '9') return false; 
-	    break;
-	  case 's':
-	    if (character == ' ') return false;
-	    break;
-	  case 'W':
-	  {
-	    bool matches_w = false;
-	    if (character >= 'a' && character <= 'z') matches_w = true;
-	    if (character >= 'A' && character <= 'Z') matches_w = true;
-	    if (character >= '0' && character <= '9') matches_w = true;
-	    if (character == '_') matches_w = true;
-	    if (!matches_w) return false;
-	    break;
-	  }
-	  case 'D':
-	    if (!(character >= '0' && character <= '9')) return false; 
-	    break;
-	  case 'S':
-	    if (character != ' ') return false;
-	    break;
-	  case '.':		
-	    throw EgretException("ERROR (internal): Wilcard '.' should never be in complemented char set");
-	  default:
-	  {
-	    stringstream s;
-	    s << "ERROR (internal): Invalid character class in character set: "
-	      << it->character;
-	    throw EgretException(s.str());
-	  }
-  	}
-        break;
-
-      case CHAR_RANGE_ITEM:
-        if (character >= it->range_start && character <= it->range_end) return false;
-        break;
-    }
-  }
-  return true;
+  return complement;
 }
 
-set <StringPath, spcompare>
-CharSet::gen_evil_strings(StringPath path_string, const set <char> &punct_marks)
+vector <StringPath>
+CharSet::gen_evil_strings(const StringPath &path_prefix, const StringPath &path_string,
+                          const set <char> &punct_marks)
 {
-  set <char> test_chars  = create_test_chars(punct_marks);
+  const set <char> &test_chars = get_test_chars(punct_marks);
   StringPath path_suffix;
   int initial = path_prefix.path.size() + 1;
   int final = path_string.path.size();
   for(int i = initial; i < final; i++) path_suffix.add_path_item(path_string.path[i]); 
 
-  set <StringPath, spcompare> evil_strings;
+  vector <StringPath> evil_strings;
   set <char>::iterator cs;
   for (cs = test_chars.begin(); cs != test_chars.end(); cs++) {
     StringPath new_string;
     new_string.add_path(path_prefix);
     new_string.add_string(string(1,*cs));
     new_string.add_path(path_suffix);
-    evil_strings.insert(new_string);
+    evil_strings.push_back(move(new_string));
+  }
+  vector <string>::iterator ws;
+  for (ws = wide_test_chars.begin(); ws != wide_test_chars.end(); ws++) {
+    StringPath new_string;
+    new_string.add_path(path_prefix);
+    new_string.add_string(*ws);
+    new_string.add_path(path_suffix);
+    evil_strings.push_back(move(new_string));
   }
   return evil_strings;
 }
 
+const set <char> &
+CharSet::get_test_chars(const set <char> &punct_marks)
+{
+  if (has_test_chars && punct_marks == test_punct_marks) {
+    // issue the same warnings as when the characters were created
+    vector <string>::iterator it;
+    for (it = test_warnings.begin(); it != test_warnings.end(); it++) {
+      addWarning(*it);
+    }
+    return test_chars;
+  }
+
+  test_warnings.clear();
+  test_chars = create_test_chars(punct_marks);
+  test_punct_marks = punct_marks;
+  has_test_chars = true;
+  return test_chars;
+}
+
+void
+CharSet::add_test_warning(string message)
+{
+  test_warnings.push_back(message);
+  addWarning(message);
+}
+
 set <char>
 CharSet::create_test_chars(const set<char> &punct_marks)
 {
@@ -536,6 +812,19 @@ CharSet::create_test_chars(const set<char> &punct_marks)
     }
   }
 
+  // Process Unicode items fourth - use the ASCII characters they include
+  for (it = items.begin(); it != items.end(); it++) {
+    if (it->type == CODE_POINT_ITEM || it->type == PROPERTY_ITEM) {
+      CharBitmap low;
+      item_members(*it, low, NULL);
+      if (low.intersects(LOWER_CHARS)) lowercase_flag = true;
+      if (low.intersects(UPPER_CHARS)) uppercase_flag = true;
+      if (low.intersects(DIGIT_CHARS)) digit_flag = true;
+      if (low.intersects(PUNCT_CHARS)) punct_flag = true;
+      if (low.contains(' ')) test_chars.insert(' ');
+    }
+  }
+
   // Process complemented sets
   if (complement) {
     uppercase_flag = true;
@@ -597,12 +886,54 @@ CharSet::create_test_chars(const set<char> &punct_marks)
     for (si = duplicates.begin(); si != duplicates.end(); si++) {
       s << " " << *si;
     }
-    addWarning(s.str());
+    add_test_warning(s.str());
   }
 
+  create_wide_test_chars();
   return test_chars;
 }
 
+void
+CharSet::create_wide_test_chars()
+{
+  wide_test_chars.clear();
+  if (!has_unicode_items) return;
+
+  // the ends of each Unicode item
+  set <unsigned int> cps;
+  unsigned int cp;
+  vector <CharSetItem>::iterator it;
+  for (it = items.begin(); it != items.end(); it++) {
+    if (it->type == CODE_POINT_ITEM) {
+      if (it->cp_start >= 0xA0) cps.insert(it->cp_start);
+      if (it->cp_end >= 0xA0) cps.insert(it->cp_end);
+    }
+    else if (it->type == PROPERTY_ITEM) {
+      CharBitmap low;
+      IntervalSet wide;
+      item_members(*it, low, &wide);
+      wide.normalize();
+      if (find_printable(low, wide, false, 0xA0, true, cp)) cps.insert(cp);
+    }
+  }
+
+  // a character outside ASCII that the set accepts and one that it rejects
+  if (find_code_point(0xA0, true, cp)) cps.insert(cp);
+  if (find_code_point(0xA0, false, cp)) cps.insert(cp);
+
+  set <unsigned int>::iterator ci;
+  for (ci = cps.begin(); ci != cps.end(); ci++) {
+    wide_test_chars.push_back(utf8_encode(*ci));
+  }
+}
+
+bool
+CharSet::find_code_point(unsigned int from, bool member, unsigned int &cp)
+{
+  return find_printable(complement ? members.complement() : members, wide_members,
+                        complement, from, member, cp);
+}
+
 bool
 CharSet::allows_punctuation()
 {
@@ -626,6 +957,14 @@ CharSet::allows_punctuation()
         break;
       case CHAR_RANGE_ITEM:
 	break;	// ignore
+      case CODE_POINT_ITEM:
+      case PROPERTY_ITEM:
+      {
+	CharBitmap low;
+	item_members(*it, low, NULL);
+	if (low.intersects(PUNCT_CHARS)) return true;
+	break;
+      }
     }
   }
 
@@ -649,6 +988,13 @@ CharSet::print()
     case CHAR_RANGE_ITEM:
       cout << it->range_start << "-" << it->range_end;
       break;
+    case CODE_POINT_ITEM:
+      cout << utf8_encode(it->cp_start);
+      if (it->cp_end != it->cp_start) cout << "-" << utf8_encode(it->cp_end);
+      break;
+    case PROPERTY_ITEM:
+      cout << "\\" << it->character << "{" << it->property << "}";
+      break;
     }
   }
 }
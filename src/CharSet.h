@@ -22,48 +22,170 @@
 #ifndef CHARSET_H
 #define CHARSET_H
 
+#include <cstdint>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
+#include "Counters.h"
 #include "StringPath.h"
+#include "UnicodeTables.h"
 using namespace std;
 
+// 256-bit set of characters, one bit per code point below 256
+class CharBitmap {
+
+public:
+
+  CharBitmap() { clear(); }
+
+  void clear() { words[0] = words[1] = words[2] = words[3] = 0; }
+
+  // adds a character
+  void add(char c) { words[index(c) >> 6] |= bit(c); }
+
+  // adds every character from start to end
+  void add_range(char start, char end);
+
+  // adds every character in a table of 4 words (union)
+  void add_words(const uint64_t *w) {
+    words[0] |= w[0]; words[1] |= w[1]; words[2] |= w[2]; words[3] |= w[3];
+  }
+
+  // returns true if the character is in the set
+  bool contains(char c) const { return (words[index(c) >> 6] & bit(c)) != 0; }
+
+  // returns true if the set has no characters
+  bool empty() const { return (words[0] | words[1] | words[2] | words[3]) == 0; }
+
+  // returns the characters in both sets
+  CharBitmap intersection(const CharBitmap &other) const {
+    CharBitmap b;
+    for (int i = 0; i < 4; i++) b.words[i] = words[i] & other.words[i];
+    return b;
+  }
+
+  // returns the complement of the set
+  CharBitmap complement() const {
+    CharBitmap b;
+    b.words[0] = ~words[0]; b.words[1] = ~words[1]; b.words[2] = ~words[2]; b.words[3] = ~words[3];
+    return b;
+  }
+
+  // returns true if the set has a character in the table of 4 words
+  bool intersects(const uint64_t *w) const {
+    return ((words[0] & w[0]) | (words[1] & w[1]) | (words[2] & w[2]) | (words[3] & w[3])) != 0;
+  }
+
+  // returns true if every character in the table of 4 words is in the set
+  bool superset_of(const uint64_t *w) const {
+    return ((w[0] & ~words[0]) | (w[1] & ~words[1]) | (w[2] & ~words[2]) | (w[3] & ~words[3])) == 0;
+  }
+
+  // returns true if every character in the set is in the table of 4 words
+  bool subset_of(const uint64_t *w) const {
+    return ((words[0] & ~w[0]) | (words[1] & ~w[1]) | (words[2] & ~w[2]) | (words[3] & ~w[3])) == 0;
+  }
+
+  // finds the lowest character in the set that is also in the table of
+  // 4 words, returns false if there is none
+  bool first_in(const uint64_t *w, char &c) const;
+
+  // returns the 4 words of the set
+  const uint64_t *get_words() const { return words; }
+
+private:
+
+  uint64_t words[4];		// bit c % 64 of word c / 64 is set if c is in the set
+
+  static unsigned int index(char c) { return (unsigned char) c; }
+  static uint64_t bit(char c) { return (uint64_t) 1 << (index(c) & 63); }
+};
+
+// set of code points stored as sorted, non-overlapping ranges
+class IntervalSet {
+
+public:
+
+  // adds a range of code points (call normalize once all ranges are added)
+  void add(unsigned int first, unsigned int last) { ranges.push_back(make_pair(first, last)); }
+
+  // adds the code points from from to last that are not in a table
+  void add_complement(const UnicodeRange *table, unsigned int count, unsigned int from,
+                      unsigned int last);
+
+  // sorts and merges the ranges
+  void normalize();
+
+  // returns true if the code point is in the set (binary search)
+  bool contains(unsigned int cp) const;
+
+  // finds the lowest code point at or after from that is (or is not) in
+  // the set, returns false if there is none
+  bool find(unsigned int from, bool member, unsigned int &cp) const;
+
+  // returns true if the set is empty
+  bool empty() const { return ranges.empty(); }
+
+private:
+
+  vector <pair <unsigned int, unsigned int> > ranges;	// sorted ranges (first, last)
+};
+
 typedef enum
 {
   CHARACTER_ITEM,
   CHAR_CLASS_ITEM,
-  CHAR_RANGE_ITEM
+  CHAR_RANGE_ITEM,
+  CODE_POINT_ITEM,
+  PROPERTY_ITEM
 } CharSetItemType;
 
 struct CharSetItem
 {
   CharSetItemType type;
-  char character;	// for CHARACTER_ITEM and CHAR_CLASS_ITEM
+  char character;	// for CHARACTER_ITEM and CHAR_CLASS_ITEM ('p' or 'P' for PROPERTY_ITEM)
   char range_start;	// for CHAR_RANGE_ITEM
   char range_end;	// for CHAR_RANGE_ITEM
+  unsigned int cp_start;	// for CODE_POINT_ITEM (character or range outside ASCII)
+  unsigned int cp_end;		// for CODE_POINT_ITEM
+  string property;	// for PROPERTY_ITEM (Unicode property name)
 };
 
 class CharSet {
 
 public:
 
-  CharSet() { complement = false; }
+  CharSet() {
+    complement = false;
+    only_characters = true;
+    has_unicode_items = false;
+    has_signature = false;
+    has_test_chars = false;
+  }
 
-  void set_path_prefix(StringPath p) { path_prefix = p; }
   void set_complement(bool c) { complement = c; }
   bool is_complement() { return complement; }
 
+  // returns true if the code point is in the set
+  bool contains(unsigned int cp) {
+    COUNT(CHAR_SET_PROBES);
+    return (cp < 256 ? members.contains((char) cp) : wide_members.contains(cp)) != complement;
+  }
+
   // add an item to the character set
   void add_item(CharSetItem item);
 
   // determines if character set is a string candidate
   bool is_string_candidate();
 
-  // gets a single valid character
-  char get_valid_character();
+  // gets a single valid character (UTF-8 encoded)
+  string get_valid_character();
 
-  // generate evil strings
-  set <StringPath, spcompare> gen_evil_strings(StringPath path_string, const set <char> &punct_marks);
+  // generate evil strings from the path string before the character set
+  // (in the order they are output)
+  vector <StringPath> gen_evil_strings(const StringPath &path_prefix, const StringPath &path_string,
+                                       const set <char> &punct_marks);
 
   // returns true if character set allows punctuation
   bool allows_punctuation();
@@ -76,6 +198,14 @@ public:
 
   string get_charset_as_string();
 
+  // computes the sorted characters and the test characters for punct_marks
+  // up front (without issuing warnings), so that later runs only read them
+  // and may share the set across threads
+  void prepare(const set <char> &punct_marks);
+
+  // returns a key that is the same for sets built from the same items
+  string get_key();
+
   bool only_has_characters();
 
   bool is_charset_complemented();
@@ -87,14 +217,38 @@ private:
 
   vector <CharSetItem> items;	// set of items comprising the set
   bool complement;		// true if set is complemented
-  StringPath path_prefix;		// path string up to visiting this node
+  CharBitmap members;		// code points below 256 in the items (before any complement)
+  IntervalSet wide_members;	// code points from 256 up in the items (before any complement)
+  bool only_characters;		// true if every item is a single character
+  bool has_unicode_items;	// true if any item is a CODE_POINT_ITEM or PROPERTY_ITEM
   string substring;		// substring corresponding to this char set
 
+  string signature;		// sorted characters of the set (once computed)
+  bool has_signature;		// set once signature is computed
+  set <char> test_chars;	// test characters (once computed)
+  set <char> test_punct_marks;	// punct marks test_chars was computed for
+  vector <string> wide_test_chars;	// test characters outside ASCII (UTF-8 encoded)
+  vector <string> test_warnings;	// warnings issued while computing test_chars
+  bool has_test_chars;		// set once test_chars is computed
+
   // determines if a character is valid in a complemented character set
-  bool is_valid_character(char character);
+  bool is_valid_character(char character) { return contains((unsigned char) character); }
+
+  // finds the lowest printable code point at or after from that is (or is
+  // not) in the set, returns false if there is none
+  bool find_code_point(unsigned int from, bool member, unsigned int &cp);
+
+  // creates the test characters outside ASCII
+  void create_wide_test_chars();
+
+  // returns the set of test characters (computed once and cached)
+  const set <char> &get_test_chars(const set <char> &punct_marks);
 
   // creates a set of test characters
   set <char> create_test_chars(const set <char> &punct_marks);
+
+  // adds a warning found while creating test characters
+  void add_test_warning(string message);
 };
 
 #endif // CHARSET_H
@@ -0,0 +1,246 @@
+/*  Corpus.cpp: runs the engine over a corpus of regexes
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Corpus.h"
+#include "Utf8.h"
+#include "error.h"
+using namespace std;
+
+// a regex in the corpus (points into the mapped file)
+struct CorpusLine
+{
+  unsigned int number;		// line number (from 1)
+  const char *start;		// first character of the regex
+  size_t length;		// length of the regex
+};
+
+static void map_corpus(const string &file_name, const char *&data, size_t &length);
+static vector <bool> read_done(const string &results_file, unsigned int num_lines);
+static string format_result(const CorpusLine &line, const vector <string> &result,
+                            double seconds);
+
+bool
+parse_shard(const string &s, unsigned int &shard, unsigned int &num_shards)
+{
+  size_t slash = s.find('/');
+  if (slash == string::npos || slash == 0 || slash == s.length() - 1) return false;
+  for (unsigned int i = 0; i < s.length(); i++) {
+    if (i != slash && !isdigit((unsigned char) s[i])) return false;
+  }
+
+  unsigned long i = strtoul(s.c_str(), NULL, 10);
+  unsigned long n = strtoul(s.c_str() + slash + 1, NULL, 10);
+  if (n == 0 || i >= n || n > 0xFFFFFFFFUL) return false;
+  shard = i;
+  num_shards = n;
+  return true;
+}
+
+CorpusSummary
+run_corpus(const string &corpus_file, const string &results_file, const CorpusOptions &options)
+{
+  const char *data;
+  size_t length;
+  map_corpus(corpus_file, data, length);
+
+  // find the regexes in this shard
+  vector <CorpusLine> lines;
+  unsigned int number = 0;
+  size_t pos = 0;
+  while (pos < length) {
+    const char *start = data + pos;
+    const char *newline = (const char *) memchr(start, '\n', length - pos);
+    size_t line_length = newline ? newline - start : length - pos;
+    pos += line_length + 1;
+    number++;
+
+    if (line_length > 0 && start[line_length - 1] == '\r') line_length--;
+    if (line_length == 0 || number % options.num_shards != options.shard) continue;
+    CorpusLine line;
+    line.number = number;
+    line.start = start;
+    line.length = line_length;
+    lines.push_back(line);
+  }
+
+  // skip the regexes that were finished by an earlier run
+  CorpusSummary summary;
+  summary.total = lines.size();
+  vector <bool> done = read_done(results_file, number);
+  vector <CorpusLine> todo;
+  for (unsigned int i = 0; i < lines.size(); i++) {
+    if (done[lines[i].number])
+      summary.skipped++;
+    else
+      todo.push_back(lines[i]);
+  }
+
+  FILE *out = fopen(results_file.c_str(), "a");
+  if (out == NULL) {
+    if (length > 0) munmap((void *) data, length);
+    throw EgretException("ERROR: Unable to write results file " + results_file);
+  }
+
+  // each worker takes the next regex, a record is flushed as soon as it is
+  // written so that the results file is always a valid checkpoint
+  atomic <unsigned int> next(0);
+  atomic <bool> failed(false);
+  mutex out_lock;
+  auto work = [&]() {
+    while (!failed) {
+      unsigned int i = next++;
+      if (i >= todo.size()) break;
+      const CorpusLine &line = todo[i];
+
+      chrono::steady_clock::time_point start = chrono::steady_clock::now();
+      vector <string> result = run_engine(string(line.start, line.length),
+                                          options.base_substring, options.engine);
+      chrono::duration <double> elapsed = chrono::steady_clock::now() - start;
+      string record = format_result(line, result, elapsed.count());
+
+      lock_guard <mutex> guard(out_lock);
+      if (fwrite(record.data(), 1, record.length(), out) != record.length()
+          || fflush(out) != 0) {
+        failed = true;
+        break;
+      }
+      summary.processed++;
+      if (result[0].compare(0, 5, "ERROR") == 0) summary.errors++;
+    }
+  };
+
+  unsigned int workers = options.workers;
+  if (workers == 0) workers = thread::hardware_concurrency();
+  if (workers == 0) workers = 1;
+  if (workers > todo.size()) workers = todo.size();
+  vector <thread> threads;
+  for (unsigned int i = 1; i < workers; i++) {
+    threads.push_back(thread(work));
+  }
+  work();
+  for (unsigned int i = 0; i < threads.size(); i++) {
+    threads[i].join();
+  }
+
+  bool closed = fclose(out) == 0;
+  if (length > 0) munmap((void *) data, length);
+  if (failed || !closed) {
+    throw EgretException("ERROR: Unable to write results file " + results_file);
+  }
+  return summary;
+}
+
+// maps the corpus file into memory (an empty file is not mapped)
+static void
+map_corpus(const string &file_name, const char *&data, size_t &length)
+{
+  int fd = open(file_name.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw EgretException("ERROR: Unable to open corpus file " + file_name);
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    throw EgretException("ERROR: Unable to open corpus file " + file_name);
+  }
+
+  data = NULL;
+  length = st.st_size;
+  if (length > 0) {
+    void *map = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+      close(fd);
+      throw EgretException("ERROR: Unable to map corpus file " + file_name);
+    }
+    madvise(map, length, MADV_SEQUENTIAL);
+    data = (const char *) map;
+  }
+  close(fd);
+}
+
+// returns the lines recorded in the results file (indexed by line number),
+// a record cut off by an interrupted run is removed from the file
+static vector <bool>
+read_done(const string &results_file, unsigned int num_lines)
+{
+  vector <bool> done(num_lines + 1, false);
+  ifstream in(results_file.c_str(), ios::binary);
+  if (!in.is_open()) return done;
+
+  const string key = "{\"line\":";
+  string record;
+  streamoff complete = 0;
+  while (getline(in, record)) {
+    if (in.eof()) break;	// no newline, the record is incomplete
+    complete = in.tellg();
+    if (record.compare(0, key.length(), key) != 0) continue;
+    unsigned long number = strtoul(record.c_str() + key.length(), NULL, 10);
+    if (number <= num_lines) done[number] = true;
+  }
+  in.close();
+
+  struct stat st;
+  if (stat(results_file.c_str(), &st) == 0 && st.st_size > complete) {
+    if (truncate(results_file.c_str(), complete) != 0) {
+      throw EgretException("ERROR: Unable to write results file " + results_file);
+    }
+  }
+  return done;
+}
+
+// formats the record for a regex, result is the status followed by the
+// test strings (as returned by run_engine)
+static string
+format_result(const CorpusLine &line, const vector <string> &result, double seconds)
+{
+  char buf[64];
+  string record = "{\"line\":";
+  snprintf(buf, sizeof(buf), "%u", line.number);
+  record += buf;
+  record += ",\"regex\":";
+  append_json_string(record, string(line.start, line.length));
+  record += ",\"status\":";
+  append_json_string(record, result[0]);
+  snprintf(buf, sizeof(buf), ",\"seconds\":%.6f", seconds);
+  record += buf;
+  record += ",\"strings\":[";
+  for (unsigned int i = 1; i < result.size(); i++) {
+    if (i > 1) record += ',';
+    append_json_string(record, result[i]);
+  }
+  record += "]}\n";
+  return record;
+}
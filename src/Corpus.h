@@ -0,0 +1,79 @@
+/*  Corpus.h: runs the engine over a corpus of regexes
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// A corpus file has one regex per line (blank lines are skipped).  Line i
+// (counting from 1) belongs to shard i % num_shards, so a corpus can be
+// split across machines by giving each one a different shard.
+//
+// Each regex in the shard gets one line in the results file, written as
+// soon as the regex is done:
+//
+//   {"line":12,"regex":"a+b","status":"SUCCESS","seconds":0.001234,
+//    "strings":["ab","aab",...]}
+//
+// The results file is also the checkpoint.  A run appends to an existing
+// results file and skips the lines recorded there, so an interrupted run
+// picks up where it stopped (a partly written last record is dropped).
+
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <string>
+#include "egret.h"
+using namespace std;
+
+// options for a corpus run
+struct CorpusOptions
+{
+  CorpusOptions() {
+    base_substring = "evil";
+    workers = 1;
+    shard = 0;
+    num_shards = 1;
+  }
+
+  string base_substring;	// base substring for every regex
+  EngineOptions engine;		// options for each engine run
+  unsigned int workers;		// regexes run at the same time (0 for one per core)
+  unsigned int shard;		// shard to run (0 to num_shards - 1)
+  unsigned int num_shards;	// number of shards the corpus is split into
+};
+
+// counts for a corpus run
+struct CorpusSummary
+{
+  CorpusSummary() { total = 0; skipped = 0; processed = 0; errors = 0; }
+
+  unsigned int total;		// regexes in the shard
+  unsigned int skipped;		// regexes already in the results file
+  unsigned int processed;	// regexes run
+  unsigned int errors;		// regexes whose status is an error
+};
+
+// parses a shard given as i/n, returns false if it is not valid
+bool parse_shard(const string &s, unsigned int &shard, unsigned int &num_shards);
+
+// runs the engine on each regex of the shard that is not already in the
+// results file, throws EgretException if a file cannot be read or written
+CorpusSummary run_corpus(const string &corpus_file, const string &results_file,
+                         const CorpusOptions &options);
+
+#endif // CORPUS_H
@@ -0,0 +1,108 @@
+/*  Counters.cpp: counts of events on the engine's hot paths
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string>
+#include <vector>
+#include "Counters.h"
+#include "Stats.h"
+using namespace std;
+
+#ifdef EGRET_COUNTERS
+
+atomic <unsigned long> counters[NUM_COUNTERS];
+
+static const char *counter_names[NUM_COUNTERS] = {
+  "StringPath copies",
+  "StringPath appends",
+  "StringPath growths",
+  "NFA copies",
+  "get_substring calls",
+  "Traverse visits",
+  "Char set probes",
+  "Dedup probes"
+};
+
+#endif // EGRET_COUNTERS
+
+PhaseCounters::Snapshot
+PhaseCounters::take_snapshot()
+{
+  Snapshot snapshot;
+  for (int i = 0; i < NUM_COUNTERS; i++) {
+#ifdef EGRET_COUNTERS
+    snapshot.counts[i] = counters[i].load(memory_order_relaxed);
+#else
+    snapshot.counts[i] = 0;
+#endif
+  }
+  snapshot.memory = get_memory_usage();
+  return snapshot;
+}
+
+void
+PhaseCounters::begin_phase(const string &name)
+{
+  end_phase();
+  start = take_snapshot();
+  phases.push_back(name);
+  in_phase = true;
+}
+
+void
+PhaseCounters::end_phase()
+{
+  if (!in_phase) return;
+  Snapshot now = take_snapshot();
+  Snapshot phase;
+  for (int i = 0; i < NUM_COUNTERS; i++) {
+    phase.counts[i] = now.counts[i] - start.counts[i];
+  }
+  phase.memory.allocations = now.memory.allocations - start.memory.allocations;
+  phase.memory.bytes = now.memory.bytes - start.memory.bytes;
+  phase.memory.peak_rss = now.memory.peak_rss - start.memory.peak_rss;
+  growth.push_back(phase);
+  in_phase = false;
+}
+
+void
+PhaseCounters::add_stats(Stats &stats)
+{
+  end_phase();
+#ifdef EGRET_COUNTERS
+  for (unsigned int p = 0; p < phases.size(); p++) {
+    for (int i = 0; i < NUM_COUNTERS; i++) {
+      if (growth[p].counts[i] == 0) continue;
+      stats.add("COUNTERS", phases[p] + ": " + counter_names[i], growth[p].counts[i]);
+    }
+  }
+#endif
+
+  // the phase that holds a blowup shows the most allocated bytes and the
+  // most growth of the peak resident set size
+  for (unsigned int p = 0; p < phases.size(); p++) {
+    if (counting_allocations()) {
+      stats.add("MEMORY", phases[p] + ": Allocations", growth[p].memory.allocations);
+      stats.add("MEMORY", phases[p] + ": Allocated bytes", growth[p].memory.bytes);
+    }
+    stats.add("MEMORY", phases[p] + ": Peak RSS growth (KB)", growth[p].memory.peak_rss);
+  }
+  stats.add("MEMORY", "Peak RSS (KB)", get_memory_usage().peak_rss);
+}
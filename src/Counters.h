@@ -0,0 +1,100 @@
+/*  Counters.h: counts of events on the engine's hot paths
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// The counters show where a run spends its work without a profiler.  They
+// are only compiled in when EGRET_COUNTERS is defined (make COUNTERS=1),
+// otherwise COUNT expands to nothing and no stats are added.  The counts
+// are kept for the whole process, so a run that overlaps another run
+// (on another thread) also counts that run's events.  The memory used in
+// each phase of a run is recorded with the counts (see Memory.h).
+
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+#include <string>
+#include <vector>
+#include "Memory.h"
+#include "Stats.h"
+using namespace std;
+
+typedef enum {
+  STRING_PATH_COPIES,		// StringPath copies
+  STRING_PATH_APPENDS,		// items or paths appended to a StringPath
+  STRING_PATH_GROWTHS,		// StringPath buffers reallocated to grow
+  NFA_COPIES,			// NFA copies (each copies the edge table)
+  GET_SUBSTRING_CALLS,		// Edge::get_substring calls
+  TRAVERSE_VISITS,		// states visited while enumerating paths
+  CHAR_SET_PROBES,		// code points looked up in a character set
+  DEDUP_PROBES,			// output strings checked for duplicates
+  NUM_COUNTERS
+} Counter;
+
+#ifdef EGRET_COUNTERS
+
+#include <atomic>
+
+extern atomic <unsigned long> counters[NUM_COUNTERS];
+
+#define COUNT(counter) counters[counter].fetch_add(1, memory_order_relaxed)
+
+#else
+
+#define COUNT(counter) ((void) 0)
+
+#endif // EGRET_COUNTERS
+
+// Counts for each phase of a run: the counters and the memory use are
+// read when a phase begins and ends.  The hot path counts are recorded
+// only when EGRET_COUNTERS is defined, and the allocations only when
+// EGRET_MEMORY is defined, the growth of the peak resident set size always.
+class PhaseCounters {
+
+public:
+
+  PhaseCounters() { in_phase = false; }
+
+  // ends the current phase (if any) and begins the next one
+  void begin_phase(const string &name);
+
+  // ends the current phase
+  void end_phase();
+
+  // adds the counts of each phase
+  void add_stats(Stats &stats);
+
+private:
+
+  // the counts at a point in a run (or their growth over a phase)
+  struct Snapshot {
+    unsigned long counts[NUM_COUNTERS];
+    MemoryUsage memory;
+  };
+
+  bool in_phase;			// set while a phase is open
+  Snapshot start;			// counts when the phase began
+  vector <string> phases;		// name of each phase
+  vector <Snapshot> growth;		// growth of the counts in each phase
+
+  // reads the counts
+  static Snapshot take_snapshot();
+};
+
+#endif // COUNTERS_H
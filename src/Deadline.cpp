@@ -0,0 +1,110 @@
+/*  Deadline.cpp: wall-clock deadline and cooperative cancellation
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <chrono>
+#include <sstream>
+#include <string>
+#include "Deadline.h"
+#include "Stats.h"
+#include "error.h"
+using namespace std;
+
+Deadline::Deadline()
+{
+  has_limit = false;
+  start = Clock::now();
+  token = NULL;
+  stopped = false;
+  cancelled = false;
+  checks = 0;
+}
+
+void
+Deadline::set_timeout(double seconds)
+{
+  if (seconds <= 0) {
+    has_limit = false;
+    return;
+  }
+  has_limit = true;
+  limit = start + chrono::duration_cast<Clock::duration>(chrono::duration<double>(seconds));
+}
+
+bool
+Deadline::expired(const char *phase)
+{
+  if (stopped) return true;
+  checks++;
+
+  if (token != NULL && token->is_cancelled()) {
+    stop(phase, true);
+  }
+  else if (has_limit && Clock::now() >= limit) {
+    stop(phase, false);
+  }
+  return stopped;
+}
+
+void
+Deadline::check(const char *phase)
+{
+  if (!expired(phase)) return;
+
+  stringstream s;
+  if (cancelled)
+    s << "ERROR: Run cancelled while " << stop_phase;
+  else
+    s << "ERROR: Time limit exceeded while " << stop_phase;
+  throw EgretException(s.str());
+}
+
+void
+Deadline::stop(const char *phase, bool by_cancel)
+{
+  lock_guard <mutex> guard(lock);
+  if (stopped) return;
+  cancelled = by_cancel;
+  stop_phase = phase;
+  stopped = true;
+}
+
+void
+Deadline::add_warnings()
+{
+  if (!stopped) return;
+
+  stringstream s;
+  if (cancelled)
+    s << "TIMEOUT WARNING: Run cancelled while " << stop_phase << ", test strings are partial";
+  else
+    s << "TIMEOUT WARNING: Time limit exceeded while " << stop_phase << ", test strings are partial";
+  addWarning(s.str());
+}
+
+void
+Deadline::add_stats(Stats &stats)
+{
+  Clock::duration elapsed = Clock::now() - start;
+  stats.add("DEADLINE", "Elapsed time (ms)",
+            chrono::duration_cast<chrono::milliseconds>(elapsed).count());
+  stats.add("DEADLINE", "Deadline checks", checks);
+  stats.add("DEADLINE", "Stopped early", stopped ? 1 : 0);
+}
@@ -0,0 +1,104 @@
+/*  Deadline.h: wall-clock deadline and cooperative cancellation
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DEADLINE_H
+#define DEADLINE_H
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include "Stats.h"
+using namespace std;
+
+// A cancellation token is owned by the caller and may be cancelled from
+// any thread while the engine is running.
+class CancelToken {
+
+public:
+
+  CancelToken() { cancelled = false; }
+
+  // requests that the run stop at the next safe point
+  void cancel() { cancelled = true; }
+
+  // returns true if the run has been cancelled
+  bool is_cancelled() const { return cancelled; }
+
+private:
+
+  atomic <bool> cancelled;	// set when cancellation is requested
+};
+
+// A deadline is checked by the engine at safe points.  Phases that cannot
+// produce partial results (parsing, NFA construction) throw an exception
+// when the deadline passes, the others stop early and keep what they have.
+// Checks may come from several threads at once.
+class Deadline {
+
+public:
+
+  Deadline();
+
+  // sets the time limit in seconds from now (0 means no limit)
+  void set_timeout(double seconds);
+
+  // sets the cancellation token (NULL means none)
+  void set_cancel_token(CancelToken *t) { token = t; }
+
+  // returns true if the deadline passed or the run was cancelled,
+  // phase names the work that is being abandoned
+  bool expired(const char *phase);
+
+  // throws an exception if the deadline passed or the run was cancelled
+  void check(const char *phase);
+
+  // returns true if the run was stopped early
+  bool has_expired() { return stopped; }
+
+  // adds a warning if the run was stopped early
+  void add_warnings();
+
+  // add deadline stats
+  void add_stats(Stats &stats);
+
+private:
+
+  typedef chrono::steady_clock Clock;
+
+  bool has_limit;		// set if there is a time limit
+  Clock::time_point start;	// time the run started
+  Clock::time_point limit;	// time the run must stop
+  CancelToken *token;		// cancellation token (NULL if none)
+  atomic <bool> stopped;	// set once the deadline passed or run was cancelled
+  bool cancelled;		// set if stopped due to cancellation
+  string stop_phase;		// phase in which the run was stopped
+  atomic <unsigned int> checks;	// number of checks performed
+  mutex lock;			// guards the reason for stopping
+
+  // records the reason for stopping (the first reason is kept)
+  void stop(const char *phase, bool by_cancel);
+
+  Deadline(const Deadline &other);
+  Deadline &operator= (const Deadline &other);
+};
+
+#endif // DEADLINE_H
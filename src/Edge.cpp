@@ -23,13 +23,15 @@
 #include <set>
 #include <string>
 #include <vector>
+#include "Counters.h"
 #include "Edge.h"
 #include "StringPath.h"
 using namespace std;
 
 StringPath
-Edge::get_substring()
+Edge::get_substring(const EdgeVisit &visit)
 {
+  COUNT(GET_SUBSTRING_CALLS);
   StringPath p;
   
   switch (type) {
@@ -37,12 +39,12 @@ Edge::get_substring()
     p.add_char(character);
     return p;
   case CHAR_SET_EDGE:
-    p.add_char(char_set->get_valid_character());
+    p.add_string(char_set->get_valid_character());
     return p;
   case STRING_EDGE:
-    return regex_str->get_substring();
+    return visit.substring;
   case END_LOOP_EDGE:
-    return regex_loop->get_substring();
+    return regex_loop->get_substring(visit.substring);
   case BACKREFERENCE_EDGE:
     {
       p.add_backreference(num, id);
@@ -64,40 +66,41 @@ Edge::get_substring()
 }
 
 void
-Edge::process_min_iter_string(StringPath *min_iter_string)
+Edge::process_min_iter_string(StringPath *min_iter_string, const EdgeVisit &first,
+                              const EdgeVisit &last)
 {
   switch (type) {
   case CHARACTER_EDGE:
   case CHAR_SET_EDGE:
     {
-      StringPath substring = get_substring();
+      StringPath substring = get_substring(first);
       if(substring.path.size() > 0) {
         min_iter_string->add_path(substring); // add substring to path
       }
       break;
     }
   case STRING_EDGE:
-    regex_str->process_min_iter_string(min_iter_string);
+    regex_str->process_min_iter_string(min_iter_string, first.substring);
     break;
   case END_LOOP_EDGE:
-    regex_loop->process_min_iter_string(min_iter_string);
+    regex_loop->process_min_iter_string(min_iter_string, first.substring, last.substring);
     break;
     // todo - future work, add begin group, end group, and backreference to min iter string
     /*case BEGIN_GROUP_EDGE:
     {
-      StringPath substring = get_substring();
+      StringPath substring = get_substring(first);
       min_iter_string->add_path(substring);
       break;
     }
   case END_GROUP_EDGE:
     {
-      StringPath substring = get_substring();
+      StringPath substring = get_substring(first);
       min_iter_string->add_path(substring);
       break;
     }
   case BACKREFERENCE_EDGE:
     {
-      StringPath substring = get_substring();
+      StringPath substring = get_substring(first);
       min_iter_string->add_path(substring);
       break;
       }*/
@@ -107,33 +110,13 @@ Edge::process_min_iter_string(StringPath *min_iter_string)
 }
 
 bool
-Edge::process_edge_in_path(StringPath path_prefix, StringPath base_substring)
+Edge::is_evil_edge()
 {
-  if (type == BEGIN_LOOP_EDGE) {
-    regex_loop->process_begin_loop(path_prefix, processed);
-  }
-
-  if (type == END_LOOP_EDGE) {
-    regex_loop->process_end_loop(path_prefix, processed);
-  }
-
-  // no further work needed if transition already processed
-  if (processed) return false;
-  processed = true;
-
-  // set the path prefix for nodes that need processing
   switch (type) {
     case CHAR_SET_EDGE:
-      char_set->set_path_prefix(path_prefix);
-      return true;
     case STRING_EDGE:
-      regex_str->set_path_prefix(path_prefix);
-      regex_str->set_substring(base_substring);
-      return true;
     case END_LOOP_EDGE:
-      return true;
     case BACKREFERENCE_EDGE:
-      return true;
     case BEGIN_GROUP_EDGE:
       return true;
     default:
@@ -141,25 +124,26 @@ Edge::process_edge_in_path(StringPath path_prefix, StringPath base_substring)
   }
 }
 
-set <StringPath, spcompare>
-Edge::gen_evil_strings(StringPath path_string, const set <char> &punct_marks)
+vector <StringPath>
+Edge::gen_evil_strings(const EdgeVisit &visit, const StringPath &path_string,
+                       const set <char> &punct_marks)
 {
   switch (type) {
     case CHAR_SET_EDGE:
-      return char_set->gen_evil_strings(path_string, punct_marks);
+      return char_set->gen_evil_strings(visit.prefix, path_string, punct_marks);
     case STRING_EDGE:
-      return regex_str->gen_evil_strings(path_string, punct_marks);
+      return regex_str->gen_evil_strings(visit.prefix, visit.substring, path_string, punct_marks);
     case END_LOOP_EDGE:
-      return regex_loop->gen_evil_strings(path_string);
+      return regex_loop->gen_evil_strings(visit.prefix, visit.substring, path_string);
     case BACKREFERENCE_EDGE:
     {
-      set <StringPath, spcompare> empty;
+      vector <StringPath> empty;
       return empty;
     }
   case BEGIN_GROUP_EDGE:
     default:
     {
-      set <StringPath, spcompare> empty;
+      vector <StringPath> empty;
       return empty;
     }
   }
@@ -24,6 +24,7 @@
 
 #include <set>
 #include <string>
+#include <vector>
 #include "CharSet.h"
 #include "RegexString.h"
 #include "RegexLoop.h"
@@ -44,33 +45,47 @@ typedef enum {
   END_GROUP_EDGE
 } EdgeType;
 
+// what is recorded when a path visits an edge
+struct EdgeVisit {
+  StringPath prefix;		// path string before the edge (before the loop for END_LOOP_EDGE)
+  StringPath substring;		// base substring (STRING_EDGE) or loop iteration (END_LOOP_EDGE)
+};
+
 class Edge {
 
 public:
 
-  Edge() { processed = false; }
-  Edge(EdgeType t) { type = t; processed = false; }
-  Edge(EdgeType t, char c) { type = t; character = c; processed = false; }
-  Edge(EdgeType t, CharSet *c) { type = t; char_set = c; processed = false; }
-  Edge(EdgeType t, RegexString *r) { type = t; regex_str = r; processed = false; }
-  Edge(EdgeType t, RegexLoop *r) { type = t; regex_loop = r; processed = false; }
-  Edge(EdgeType t, string _name, int _num, int _id) { type = t; name = _name; num = _num; id = _id;  processed = false; }
-  Edge(EdgeType t, string _name, int _num) { type = t; name = _name; num = _num;  processed = false; }
+  Edge() {}
+  Edge(EdgeType t) { type = t; }
+  Edge(EdgeType t, char c) { type = t; character = c; }
+  Edge(EdgeType t, CharSet *c) { type = t; char_set = c; }
+  Edge(EdgeType t, RegexString *r) { type = t; regex_str = r; }
+  Edge(EdgeType t, RegexLoop *r) { type = t; regex_loop = r; }
+  Edge(EdgeType t, string _name, int _num, int _id) { type = t; name = _name; num = _num; id = _id; }
+  Edge(EdgeType t, string _name, int _num) { type = t; name = _name; num = _num; }
 
   EdgeType getType() { return type; }
 
-  // get valid substring associated with edge
-  StringPath get_substring();
+  char get_character() { return character; }
+  CharSet *get_char_set() { return char_set; }
+  RegexString *get_regex_string() { return regex_str; }
+  RegexLoop *get_regex_loop() { return regex_loop; }
+
+  // get valid substring associated with edge for a visit
+  StringPath get_substring(const EdgeVisit &visit);
 
-  // process minimum iteration string
-  void process_min_iter_string(StringPath *min_iter_string);
+  // process minimum iteration string (first and last are the first and most
+  // recent visits to the edge)
+  void process_min_iter_string(StringPath *min_iter_string, const EdgeVisit &first,
+                               const EdgeVisit &last);
 
-  // perform path processing on the edge, returns true if edge should be used in
+  // returns true if the first path to visit the edge should use it in
   // creating evil strings
-  bool process_edge_in_path(StringPath path_prefix, StringPath base_substring);
+  bool is_evil_edge();
 
-  // generate evil strings
-  set <StringPath, spcompare> gen_evil_strings(StringPath path_string, const set <char> &punct_marks);
+  // generate evil strings (visit is the first visit to the edge)
+  vector <StringPath> gen_evil_strings(const EdgeVisit &visit, const StringPath &path_string,
+                                       const set <char> &punct_marks);
 
   string get_charset_as_string();
 
@@ -81,7 +96,6 @@ public:
 
 private:
   EdgeType type;		// type of edge
-  bool processed;		// set if processed in a path
   char character;		// character (for CHARACTER_EDGE)
   CharSet *char_set;		// character set (for CHAR_SET_EDGE)
   RegexString *regex_str;	// regex string (for STRING_EDGE)
@@ -0,0 +1,287 @@
+/*  Fuzzer.cpp: finds regexes that make the engine slow
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include "Fuzzer.h"
+#include "egret.h"
+#include "error.h"
+using namespace std;
+
+//=============================================================
+// Random regexes
+//=============================================================
+
+string
+RegexGrammar::generate()
+{
+  groups = 0;
+  return expr(0);
+}
+
+string
+RegexGrammar::expr(int depth)
+{
+  // alternatives with an empty side are rare
+  unsigned int choice = pick(12);
+  if (choice < 8) return concat(depth);
+  if (choice < 11) return concat(depth) + "|" + expr(depth);
+  return concat(depth) + "|";
+}
+
+string
+RegexGrammar::concat(int depth)
+{
+  string s = rep(depth);
+  unsigned int more = pick(4);
+  for (unsigned int i = 0; i < more; i++) {
+    s += rep(depth);
+  }
+  return s;
+}
+
+string
+RegexGrammar::rep(int depth)
+{
+  string s = atom(depth);
+  stringstream bounds;
+  unsigned int lower = pick(4);
+  switch (pick(12)) {
+  case 0:
+  case 1:
+    return s + "*";
+  case 2:
+  case 3:
+    return s + "+";
+  case 4:
+    return s + "?";
+  case 5:
+    // {0,0} is rejected as pointless
+    bounds << "{" << lower << "," << max(lower, 1U) + pick(4) << "}";
+    return s + bounds.str();
+  case 6:
+    bounds << "{" << lower << ",}";
+    return s + bounds.str();
+  default:
+    return s;
+  }
+}
+
+string
+RegexGrammar::atom(int depth)
+{
+  unsigned int choice = pick(depth < FUZZ_MAX_DEPTH ? 10 : 7);
+  if (choice < 4) return character();
+  if (choice < 6) return char_class();
+  if (choice < 7) return char_set();
+  return group(depth + 1);
+}
+
+string
+RegexGrammar::group(int depth)
+{
+  switch (pick(8)) {
+  case 0:
+  case 1:
+    return "(?:" + expr(depth) + ")";
+  case 2:
+  {
+    stringstream name;
+    name << "(?P<g" << ++groups << ">";
+    return name.str() + expr(depth) + ")";
+  }
+  case 3:
+    return "(?=" + expr(depth) + ")";
+  default:
+    return "(" + expr(depth) + ")";
+  }
+}
+
+string
+RegexGrammar::character()
+{
+  // a few characters, so that parts of a regex can match the same text
+  static const char *characters[] = { "a", "a", "b", "c", "0", "1", " ", "\\.", "-", "x" };
+  static const char *anchors[] = { "^", "$", "\\b" };
+  if (pick(16) == 0) return anchors[pick(3)];
+  return characters[pick(10)];
+}
+
+string
+RegexGrammar::char_class()
+{
+  static const char *classes[] = { "\\d", "\\w", "\\s", "\\D", "\\W", "\\S", "." };
+  return classes[pick(7)];
+}
+
+string
+RegexGrammar::char_set()
+{
+  static const char *items[] = { "a", "b", "0", "-", "$", "a-c", "0-9", "x-z", "\\d", "\\w", "\\s" };
+  string s = pick(4) == 0 ? "[^" : "[";
+  unsigned int count = 1 + pick(3);
+  for (unsigned int i = 0; i < count; i++) {
+    // a - between two items would make a range, so it is escaped unless it
+    // comes first or last
+    string item = items[pick(11)];
+    if (item == "-" && i > 0 && i + 1 < count) item = "\\-";
+    s += item;
+  }
+  return s + "]";
+}
+
+//=============================================================
+// Fuzzing
+//=============================================================
+
+// result of one engine run
+struct FuzzRun
+{
+  double seconds;		// time the run took
+  bool error;			// set if the regex did not parse
+  bool out_of_memory;		// set if the run ran out of memory
+  string stopped;		// warning if the run hit a limit ("" if not)
+};
+
+// runs the engine on a regex, throwing the test strings away
+static FuzzRun
+time_run(const string &regex, const FuzzOptions &options)
+{
+  FuzzRun run;
+  run.error = false;
+  run.out_of_memory = false;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  string status;
+  try {
+    status = run_engine(regex, options.base_substring, options.engine, [](const string &s) {});
+  }
+  catch (bad_alloc const &) {
+    run.out_of_memory = true;
+  }
+  chrono::duration <double> elapsed = chrono::steady_clock::now() - start;
+  run.seconds = elapsed.count();
+
+  if (status.compare(0, 5, "ERROR") == 0) {
+    run.error = true;
+    return run;
+  }
+  vector <Warning> warnings = splitWarnings(status);
+  for (unsigned int i = 0; i < warnings.size(); i++) {
+    if (warnings[i].code == "TIMEOUT" || warnings[i].code == "LIMIT") {
+      run.stopped = warnings[i].message.substr(0, warnings[i].message.find('\n'));
+      break;
+    }
+  }
+  return run;
+}
+
+// removes parts of a regex for as long as it still parses and its run takes
+// at least FUZZ_KEEP_RATIO of the original time (chunks of half the regex
+// first, then ever smaller chunks)
+static string
+minimize(const string &regex, double seconds, const FuzzOptions &options, double &min_seconds)
+{
+  string best = regex;
+  min_seconds = seconds;
+  double target = seconds * FUZZ_KEEP_RATIO;
+  unsigned int runs = 0;
+  for (size_t chunk = best.length() / 2; chunk > 0 && runs < FUZZ_MINIMIZE_RUNS; chunk /= 2) {
+    size_t i = 0;
+    while (i + chunk <= best.length() && runs < FUZZ_MINIMIZE_RUNS) {
+      string candidate = best.substr(0, i) + best.substr(i + chunk);
+      runs++;
+      FuzzRun run = time_run(candidate, options);
+      if (!run.error && !run.out_of_memory && run.seconds >= target) {
+        best = candidate;
+        min_seconds = run.seconds;
+      }
+      else {
+        i += chunk;
+      }
+    }
+  }
+  return best;
+}
+
+FuzzSummary
+run_fuzzer(const FuzzOptions &opts)
+{
+  FuzzOptions options = opts;
+  if (options.engine.timeout == 0) options.engine.timeout = FUZZ_DEFAULT_TIMEOUT;
+  if (options.engine.max_bytes == 0) options.engine.max_bytes = FUZZ_DEFAULT_MAX_BYTES;
+  if (options.memory_limit != 0) {
+    struct rlimit limit;
+    limit.rlim_cur = options.memory_limit * 1024 * 1024;
+    limit.rlim_max = limit.rlim_cur;
+    setrlimit(RLIMIT_AS, &limit);
+  }
+
+  // the time every run takes, whatever the regex
+  FuzzSummary summary;
+  summary.baseline = time_run("a", options).seconds;
+  for (int i = 0; i < 4; i++) {
+    summary.baseline = min(summary.baseline, time_run("a", options).seconds);
+  }
+
+  RegexGrammar grammar(options.seed);
+  vector <FuzzFinding> &top = summary.top;
+  for (unsigned int n = 0; n < options.count; n++) {
+    FuzzFinding finding;
+    finding.regex = grammar.generate();
+    summary.generated++;
+
+    FuzzRun run = time_run(finding.regex, options);
+    if (run.error) {
+      summary.invalid++;
+      continue;
+    }
+    if (run.out_of_memory) summary.out_of_memory++;
+    if (run.stopped != "") summary.limited++;
+    finding.seconds = run.seconds;
+    finding.cost = max(0.0, run.seconds - summary.baseline) / finding.regex.length();
+    finding.stopped = run.out_of_memory ? "Out of memory" : run.stopped;
+
+    // keep the most costly (ties go to the first found)
+    if (top.size() == options.top && (top.empty() || finding.cost <= top.back().cost)) continue;
+    vector <FuzzFinding>::iterator it = top.begin();
+    while (it != top.end() && it->cost >= finding.cost) it++;
+    top.insert(it, finding);
+    if (top.size() > options.top) top.pop_back();
+  }
+
+  // a regex no slower than the baseline is left as it is, since removing
+  // parts of it would only follow noise in the timings
+  for (unsigned int i = 0; i < top.size(); i++) {
+    if (top[i].cost == 0) {
+      top[i].minimized = top[i].regex;
+      top[i].minimized_seconds = top[i].seconds;
+    }
+    else {
+      top[i].minimized = minimize(top[i].regex, top[i].seconds, options, top[i].minimized_seconds);
+    }
+  }
+  return summary;
+}
@@ -0,0 +1,131 @@
+/*  Fuzzer.h: finds regexes that make the engine slow
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// The fuzzer makes random regexes from the grammar in ParseTree.h and runs
+// the engine on each one under a time limit and a limit on the bytes of
+// test strings (and optionally the process memory).  The cost of a regex
+// is the time its run took beyond that of a trivial regex, per byte of the
+// regex, so a short regex that takes long ranks above a long regex that
+// takes as long.  The most costly regexes are minimized: parts of the
+// regex are removed for as long as it still parses and its run still takes
+// at least half as long, which leaves a small reproducer.
+
+#ifndef FUZZER_H
+#define FUZZER_H
+
+#include <random>
+#include <string>
+#include <vector>
+#include "egret.h"
+using namespace std;
+
+// deepest nesting of groups in a generated regex
+#define FUZZ_MAX_DEPTH 3
+
+// time limit for a run if none is given (seconds)
+#define FUZZ_DEFAULT_TIMEOUT 2.0
+
+// limit on the bytes of test strings for a run if none is given
+#define FUZZ_DEFAULT_MAX_BYTES (16 * 1024 * 1024)
+
+// a reproducer must take at least this fraction of the original time
+#define FUZZ_KEEP_RATIO 0.5
+
+// most runs spent minimizing one regex
+#define FUZZ_MINIMIZE_RUNS 300
+
+// options for a fuzzing run
+struct FuzzOptions
+{
+  FuzzOptions() {
+    base_substring = "evil";
+    count = 1000;
+    seed = 1;
+    top = 5;
+    memory_limit = 0;
+  }
+
+  string base_substring;	// base substring for every regex
+  EngineOptions engine;		// options for each engine run
+  unsigned int count;		// regexes to generate
+  unsigned long seed;		// seed for the random regexes
+  unsigned int top;		// most costly regexes to keep and minimize
+  unsigned long memory_limit;	// limit on the process memory in MB (0 if none)
+};
+
+// a costly regex
+struct FuzzFinding
+{
+  string regex;			// generated regex
+  double seconds;		// time its run took
+  double cost;			// seconds beyond a trivial run per byte of the regex
+  string stopped;		// warning if the run hit a limit ("" if not)
+  string minimized;		// smallest regex found that is still slow
+  double minimized_seconds;	// time the minimized regex's run took
+};
+
+// counts for a fuzzing run
+struct FuzzSummary
+{
+  FuzzSummary() { generated = 0; invalid = 0; limited = 0; out_of_memory = 0; baseline = 0; }
+
+  unsigned int generated;	// regexes generated
+  unsigned int invalid;		// regexes the engine could not parse
+  unsigned int limited;		// runs stopped by the time or string limit
+  unsigned int out_of_memory;	// runs stopped by the memory limit
+  double baseline;		// time of a run on a trivial regex
+  vector <FuzzFinding> top;	// most costly regexes (most costly first)
+};
+
+// RegexGrammar: makes random regexes from the grammar in ParseTree.h
+class RegexGrammar {
+
+public:
+
+  RegexGrammar(unsigned long seed) : random(seed) { groups = 0; }
+
+  // returns a random regex
+  string generate();
+
+private:
+
+  mt19937 random;		// random number generator
+  unsigned int groups;		// named groups in the current regex
+
+  // returns a random number from 0 to n - 1
+  unsigned int pick(unsigned int n) { return random() % n; }
+
+  // generate each part of the grammar
+  string expr(int depth);
+  string concat(int depth);
+  string rep(int depth);
+  string atom(int depth);
+  string group(int depth);
+  string character();
+  string char_class();
+  string char_set();
+};
+
+// generates and runs the regexes, returns the counts and the most costly
+// regexes (minimized)
+FuzzSummary run_fuzzer(const FuzzOptions &options);
+
+#endif // FUZZER_H
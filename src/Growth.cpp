@@ -0,0 +1,93 @@
+/*  Growth.cpp: measures how fast matching slows down as an input grows
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include "Deadline.h"
+#include "Growth.h"
+#include "Matcher.h"
+using namespace std;
+
+string
+growth_class_name(GrowthClass growth)
+{
+  switch (growth) {
+  case LINEAR_GROWTH:		return "linear";
+  case QUADRATIC_GROWTH:	return "quadratic";
+  case CUBIC_GROWTH:		return "cubic";
+  case EXPONENTIAL_GROWTH:	return "exponential";
+  }
+  return "unknown";
+}
+
+void
+classify_growth(GrowthResult &result, const vector <unsigned int> &pumps,
+                const vector <double> &values)
+{
+  result.measured = true;
+  result.growth = LINEAR_GROWTH;
+  result.exponent = 1.0;
+  if (pumps.size() < 2) return;
+
+  // compare the last value with the last one at half the pumps or fewer
+  unsigned int j = pumps.size() - 1;
+  unsigned int i = 0;
+  for (unsigned int k = 0; k < j; k++) {
+    if (2 * pumps[k] <= pumps[j]) i = k;
+  }
+  if (values[i] <= 0 || values[j] <= values[i]) return;
+
+  double growth = log(values[j] / values[i]);
+  double ratio = exp(growth / (pumps[j] - pumps[i]));
+  result.exponent = growth / log((double) pumps[j] / pumps[i]);
+  if (ratio >= GROWTH_EXPONENTIAL_RATIO)
+    result.growth = EXPONENTIAL_GROWTH;
+  else if (result.exponent >= 2.5)
+    result.growth = CUBIC_GROWTH;
+  else if (result.exponent >= 1.5)
+    result.growth = QUADRATIC_GROWTH;
+}
+
+GrowthResult
+GrowthMeter::measure(const string &prefix, const string &pump, const string &suffix,
+                     Deadline *deadline)
+{
+  // pump counts 1, 2, 3, 4, 6, 9, 13, ... (about half again each time)
+  GrowthResult result;
+  vector <double> values;
+  for (unsigned int k = 1; k <= GROWTH_MAX_PUMPS; k = k < 4 ? k + 1 : k + k / 2) {
+    if (deadline && deadline->expired("measuring backtracking growth")) break;
+    string input = prefix;
+    for (unsigned int i = 0; i < k; i++) input += pump;
+    input += suffix;
+    matcher.full_match(input);
+    if (matcher.gave_up()) break;
+    result.pumps.push_back(k);
+    result.steps.push_back(matcher.get_steps());
+    values.push_back(matcher.get_steps());
+  }
+  classify_growth(result, result.pumps, values);
+
+  // giving up on the first inputs means the steps blow up at once
+  if (result.pumps.size() < 2 && matcher.gave_up()) result.growth = EXPONENTIAL_GROWTH;
+  return result;
+}
@@ -0,0 +1,91 @@
+/*  Growth.h: measures how fast matching slows down as an input grows
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// An ambiguous loop found by the ReDoS analysis (see Redos.h) comes with
+// an attack string: a prefix, a pump, and a suffix.  The meter matches
+// prefix + pump * k + suffix with the backtracking matcher (see Matcher.h)
+// for a growing number of pumps k, counting the steps, until the matcher
+// gives up or k reaches a limit.  The growth is taken from the last two
+// counts with k at least doubled: the per pump ratio tells exponential
+// growth apart, otherwise the exponent of k gives the degree.
+
+#ifndef GROWTH_H
+#define GROWTH_H
+
+#include <string>
+#include <vector>
+#include "Deadline.h"
+#include "Matcher.h"
+#include "ParseTree.h"
+using namespace std;
+
+// step limit for one input of the family
+#define GROWTH_STEP_LIMIT 1000000
+
+// most pumps in an input
+#define GROWTH_MAX_PUMPS 256
+
+// smallest per pump ratio taken as exponential growth
+#define GROWTH_EXPONENTIAL_RATIO 1.5
+
+typedef enum {
+  LINEAR_GROWTH,
+  QUADRATIC_GROWTH,
+  CUBIC_GROWTH,		// degree three or higher
+  EXPONENTIAL_GROWTH
+} GrowthClass;
+
+// returns the name of a growth class
+string growth_class_name(GrowthClass growth);
+
+struct GrowthResult {
+  GrowthResult() { growth = LINEAR_GROWTH; exponent = 1.0; measured = false; }
+
+  bool measured;		// set once the family was matched
+  GrowthClass growth;		// growth class
+  double exponent;		// exponent of the pump count (for polynomial growth)
+  vector <unsigned int> pumps;	// pump count of each input matched
+  vector <unsigned long> steps;	// steps taken for each input
+};
+
+// classifies growth from the values (steps or times) measured at each
+// pump count (in increasing order)
+void classify_growth(GrowthResult &result, const vector <unsigned int> &pumps,
+                     const vector <double> &values);
+
+class GrowthMeter {
+
+public:
+
+  // the tree must outlive the meter
+  GrowthMeter(ParseNode *root) : matcher(root, GROWTH_STEP_LIMIT) {}
+
+  // matches the family of inputs for an attack string (stops early if the
+  // deadline passes)
+  GrowthResult measure(const string &prefix, const string &pump, const string &suffix,
+                       Deadline *deadline = NULL);
+
+private:
+
+  Matcher matcher;		// matcher that counts the steps
+};
+
+#endif // GROWTH_H
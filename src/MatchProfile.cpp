@@ -0,0 +1,103 @@
+/*  MatchProfile.cpp: backtracking cost of the test strings
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "MatchProfile.h"
+#include "Matcher.h"
+#include "ParseTree.h"
+using namespace std;
+
+MatchProfile::MatchProfile(ParseNode *root, string _regex) : matcher(root)
+{
+  regex = _regex;
+  total_steps = 0;
+  matcher.count_node_steps();
+}
+
+void
+MatchProfile::add(const string &s)
+{
+  StringCost cost;
+  cost.str = s;
+  cost.accepted = matcher.full_match(s);
+  cost.steps = matcher.get_steps();
+  cost.gave_up = matcher.gave_up();
+  costs.push_back(cost);
+  total_steps += cost.steps;
+}
+
+void
+MatchProfile::print()
+{
+  const int WIDTH = 30;
+  unsigned int accepted = 0;
+  unsigned int gave_up = 0;
+  for (unsigned int i = 0; i < costs.size(); i++) {
+    if (costs[i].accepted) accepted++;
+    if (costs[i].gave_up) gave_up++;
+  }
+  cout << "Backtracking profile (Python re semantics):" << endl;
+  cout << left << setw(WIDTH) << "Strings matched" << "| " << costs.size() << endl;
+  cout << left << setw(WIDTH) << "Strings accepted" << "| " << accepted << endl;
+  cout << left << setw(WIDTH) << "Strings over step/depth limit" << "| " << gave_up << endl;
+  cout << left << setw(WIDTH) << "Total steps" << "| " << total_steps << endl;
+
+  // the strings with the most steps (the first generated on a tie)
+  vector <StringCost> top(costs);
+  stable_sort(top.begin(), top.end(), [](const StringCost &a, const StringCost &b) {
+    return a.steps > b.steps;
+  });
+  if (top.size() > PROFILE_TOP) top.resize(PROFILE_TOP);
+  cout << "Most expensive strings:" << endl;
+  for (unsigned int i = 0; i < top.size(); i++) {
+    cout << right << setw(10) << top[i].steps << "  "
+         << (top[i].gave_up ? "gave up " : top[i].accepted ? "accepts " : "rejects ")
+         << top[i].str << endl;
+  }
+
+  // the nodes with the most steps, shown as the part of the regex they
+  // came from (and where it starts)
+  vector <pair <unsigned long, ParseNode *> > nodes;
+  const unordered_map <ParseNode *, unsigned long> &node_steps = matcher.get_node_steps();
+  unordered_map <ParseNode *, unsigned long>::const_iterator it;
+  for (it = node_steps.begin(); it != node_steps.end(); it++) {
+    if (it->first->regex_end > it->first->regex_start) nodes.push_back(make_pair(it->second, it->first));
+  }
+  sort(nodes.begin(), nodes.end(), [](const pair <unsigned long, ParseNode *> &a,
+                                      const pair <unsigned long, ParseNode *> &b) {
+    if (a.first != b.first) return a.first > b.first;
+    if (a.second->regex_start != b.second->regex_start)
+      return a.second->regex_start < b.second->regex_start;
+    return a.second->regex_end > b.second->regex_end;
+  });
+  if (nodes.size() > PROFILE_TOP) nodes.resize(PROFILE_TOP);
+  cout << "Most expensive sub-expressions:" << endl;
+  for (unsigned int i = 0; i < nodes.size(); i++) {
+    ParseNode *node = nodes[i].second;
+    cout << right << setw(10) << nodes[i].first << "  at " << left << setw(5) << node->regex_start
+         << regex.substr(node->regex_start, node->regex_end - node->regex_start) << endl;
+  }
+}
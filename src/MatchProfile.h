@@ -0,0 +1,69 @@
+/*  MatchProfile.h: backtracking cost of the test strings
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// The profile runs each test string through the backtracking matcher (see
+// Matcher.h), which follows Python's re, and counts the steps.  It reports
+// the strings that took the most steps and the parts of the regex where
+// the steps were taken, to find the parts of a regex that backtrack the
+// most without timing a real engine.
+
+#ifndef MATCH_PROFILE_H
+#define MATCH_PROFILE_H
+
+#include <string>
+#include <vector>
+#include "Matcher.h"
+#include "ParseTree.h"
+using namespace std;
+
+// number of strings and sub-expressions reported
+#define PROFILE_TOP 10
+
+class MatchProfile {
+
+public:
+
+  // the tree must outlive the profile
+  MatchProfile(ParseNode *root, string _regex);
+
+  // matches a test string and records its steps
+  void add(const string &s);
+
+  // prints the totals and the most expensive strings and sub-expressions
+  void print();
+
+private:
+
+  // steps taken to match a test string
+  struct StringCost {
+    string str;			// test string
+    unsigned long steps;	// steps taken
+    bool accepted;		// set if the regex matched the string
+    bool gave_up;		// set if the match reached the step or depth limit
+  };
+
+  Matcher matcher;		// matcher that counts steps at each node
+  string regex;			// regex the tree was built from
+  vector <StringCost> costs;	// cost of each string
+  unsigned long total_steps;	// steps taken for all strings
+};
+
+#endif // MATCH_PROFILE_H
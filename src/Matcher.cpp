@@ -0,0 +1,204 @@
+/*  Matcher.cpp: backtracking matcher for parse trees
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string>
+#include <vector>
+#include "CharSet.h"
+#include "Matcher.h"
+#include "ParseTree.h"
+#include "Utf8.h"
+#include "error.h"
+using namespace std;
+
+Matcher::Matcher(ParseNode *_root, unsigned long _max_steps)
+{
+  root = _root;
+  max_steps = _max_steps;
+  steps = 0;
+  depth = 0;
+  stopped = false;
+  counting = false;
+  int groups = max_group(root);
+  group_start.resize(groups + 1, -1);
+  group_end.resize(groups + 1, -1);
+}
+
+bool
+Matcher::full_match(const string &s)
+{
+  text.clear();
+  unsigned int idx = 0;
+  unsigned int cp;
+  while (idx < s.length()) {
+    if (!utf8_decode(s, idx, cp)) {
+      cp = (unsigned char) s[idx];
+      idx++;
+    }
+    text.push_back(cp);
+  }
+  for (unsigned int i = 0; i < group_start.size(); i++) {
+    group_start[i] = -1;
+    group_end[i] = -1;
+  }
+
+  unsigned int length = text.size();
+  steps = 0;
+  depth = 0;
+  stopped = false;
+  try {
+    return match(root, 0, [length](unsigned int end) { return end == length; });
+  }
+  catch (StepLimit const &) {
+    stopped = true;
+    return false;
+  }
+}
+
+bool
+Matcher::match(ParseNode *node, unsigned int pos, const Continuation &next)
+{
+  if (node == NULL) return next(pos);
+  steps++;
+  if (max_steps != 0 && steps > max_steps) throw StepLimit();
+
+  // the match recurses for each character it consumes, so a long string
+  // gives up before it runs out of stack
+  DepthGuard guard(depth);
+  if (depth > MATCH_DEPTH_LIMIT) throw StepLimit();
+  if (counting) node_steps[node]++;
+
+  switch (node->type) {
+
+  case ALTERNATION_NODE:
+    return match(node->left, pos, next) || match(node->right, pos, next);
+
+  case CONCAT_NODE:
+    return match(node->left, pos, [this, node, &next](unsigned int end) {
+      return match(node->right, end, next);
+    });
+
+  case REPEAT_NODE:
+    return match_repeat(node, 0, pos, false, next);
+
+  case GROUP_NODE:
+  {
+    int num = node->group_num;
+    if (num <= 0) return match(node->left, pos, next);
+
+    // the group is captured while the rest of the regex is matched, and
+    // restored if that fails
+    int old_start = group_start[num];
+    int old_end = group_end[num];
+    bool matched = match(node->left, pos, [this, num, pos, &next](unsigned int end) {
+      int prev_start = group_start[num];
+      int prev_end = group_end[num];
+      group_start[num] = pos;
+      group_end[num] = end;
+      if (next(end)) return true;
+      group_start[num] = prev_start;
+      group_end[num] = prev_end;
+      return false;
+    });
+    if (!matched) {
+      group_start[num] = old_start;
+      group_end[num] = old_end;
+    }
+    return matched;
+  }
+
+  case BACKREFERENCE_NODE:
+  {
+    // a reference to a group that has not matched fails (as in Python)
+    int num = node->backref_value;
+    if (num <= 0 || num >= (int) group_start.size() || group_start[num] < 0) return false;
+    unsigned int length = group_end[num] - group_start[num];
+    if (pos + length > text.size()) return false;
+    for (unsigned int i = 0; i < length; i++) {
+      if (text[pos + i] != text[group_start[num] + i]) return false;
+    }
+    return next(pos + length);
+  }
+
+  case CHARACTER_NODE:
+    if (pos < text.size() && text[pos] == (unsigned char) node->character)
+      return next(pos + 1);
+    return false;
+
+  case CHAR_SET_NODE:
+    if (pos < text.size() && node->char_set->contains(text[pos]))
+      return next(pos + 1);
+    return false;
+
+  case CARET_NODE:
+    return pos == 0 && next(pos);
+
+  case DOLLAR_NODE:
+    // $ also matches before a newline that ends the string
+    if (pos == text.size() || (pos + 1 == text.size() && text[pos] == '\n'))
+      return next(pos);
+    return false;
+
+  case IGNORED_NODE:
+    return next(pos);
+
+  default:
+    throw EgretException("ERROR (internal): Invalid node type in parse tree");
+  }
+}
+
+bool
+Matcher::match_repeat(ParseNode *node, unsigned int count, unsigned int pos, bool empty,
+                      const Continuation &next)
+{
+  int lower = node->repeat_lower;
+  int upper = node->repeat_upper;
+  Continuation iterate = [this, node, count, pos, &next](unsigned int end) {
+    return match_repeat(node, count + 1, end, end == pos, next);
+  };
+
+  if ((int) count < lower) return match(node->left, pos, iterate);
+  bool more = (upper == -1 || (int) count < upper) && !empty;
+
+  // lazy: try the rest of the regex first, then another iteration
+  if (node->lazy) {
+    if (next(pos)) return true;
+    return more && match(node->left, pos, iterate);
+  }
+
+  // greedy: try another iteration first, unless the last one matched the
+  // empty string (it would repeat forever), as Python's re does
+  if (more) {
+    if (match(node->left, pos, iterate)) return true;
+  }
+  return next(pos);
+}
+
+int
+Matcher::max_group(ParseNode *node)
+{
+  if (node == NULL) return 0;
+  int num = node->type == GROUP_NODE ? node->group_num : 0;
+  int left = max_group(node->left);
+  int right = max_group(node->right);
+  if (left > num) num = left;
+  if (right > num) num = right;
+  return num;
+}
@@ -0,0 +1,113 @@
+/*  Matcher.h: backtracking matcher for parse trees
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// The matcher decides whether a parse tree matches a whole string, trying
+// alternatives in order and repetitions greedily (or lazily, fewest first)
+// as Python's re module does.  It matches code points, so the string is
+// decoded from UTF-8 (a byte that is not valid UTF-8 is matched as the code
+// point of the same value).  Constructs the parser ignores (such as
+// lookarounds and word boundaries) match the empty string.  Nested
+// quantifiers can make a backtracking match take exponential time, so a
+// match gives up after a limit on the number of steps (nodes tried).  The
+// match recurses for each character, so it also gives up on a string too
+// long for the stack.  The steps can also be counted for each node, to find
+// the parts of a regex that make it slow.
+
+#ifndef MATCHER_H
+#define MATCHER_H
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ParseTree.h"
+using namespace std;
+
+// default limit on the steps for one match
+#define MATCH_STEP_LIMIT 1000000
+
+// limit on the nesting of node matches (each character consumed nests one
+// more, and each level takes several hundred bytes of stack)
+#define MATCH_DEPTH_LIMIT 4000
+
+class Matcher {
+
+public:
+
+  // the tree must outlive the matcher (a step limit of 0 means no limit)
+  Matcher(ParseNode *_root, unsigned long _max_steps = MATCH_STEP_LIMIT);
+
+  // returns true if the regex matches all of s (false if the match gave up
+  // at the step or depth limit)
+  bool full_match(const string &s);
+
+  // returns true if the last match gave up at the step or depth limit
+  bool gave_up() { return stopped; }
+
+  // returns the steps taken by the last match
+  unsigned long get_steps() { return steps; }
+
+  // turns on counting the steps taken at each node (over all matches)
+  void count_node_steps() { counting = true; }
+
+  // returns the steps taken at each node that was tried
+  const unordered_map <ParseNode *, unsigned long> &get_node_steps() { return node_steps; }
+
+private:
+
+  // called with the position reached by a match, returns true if the
+  // rest of the regex matches from there
+  typedef function <bool (unsigned int)> Continuation;
+
+  ParseNode *root;		// root of the parse tree
+  vector <unsigned int> text;	// code points of the string being matched
+  vector <int> group_start;	// start of each captured group (-1 if unset)
+  vector <int> group_end;	// end of each captured group
+  unsigned long max_steps;	// step limit for a match (0 if none)
+  unsigned long steps;		// steps taken by the current match
+  unsigned int depth;		// nesting of the node being matched
+  bool stopped;			// set if the last match gave up
+  bool counting;		// set if steps are counted for each node
+  unordered_map <ParseNode *, unsigned long> node_steps;	// steps taken at each node
+
+  // thrown to unwind a match that reached the step or depth limit
+  struct StepLimit {};
+
+  // counts a level of nesting while a node is matched
+  struct DepthGuard {
+    unsigned int &depth;
+    DepthGuard(unsigned int &_depth) : depth(_depth) { depth++; }
+    ~DepthGuard() { depth--; }
+  };
+
+  // matches node at pos, then calls next with the end of the match
+  bool match(ParseNode *node, unsigned int pos, const Continuation &next);
+
+  // matches further iterations of a repeat node after count iterations
+  // (empty is set if the last iteration matched the empty string)
+  bool match_repeat(ParseNode *node, unsigned int count, unsigned int pos, bool empty,
+                    const Continuation &next);
+
+  // returns the highest group number in the tree
+  static int max_group(ParseNode *node);
+};
+
+#endif // MATCHER_H
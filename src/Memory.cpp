@@ -0,0 +1,120 @@
+/*  Memory.cpp: heap and resident memory accounting
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <sys/resource.h>
+#include "Memory.h"
+using namespace std;
+
+#ifdef EGRET_MEMORY
+
+static atomic <unsigned long> allocations(0);
+static atomic <unsigned long> allocated_bytes(0);
+
+static void *
+counted_alloc(size_t size)
+{
+  allocations.fetch_add(1, memory_order_relaxed);
+  allocated_bytes.fetch_add(size, memory_order_relaxed);
+  if (size == 0) size = 1;
+  for (;;) {
+    void *p = malloc(size);
+    if (p != NULL) return p;
+    new_handler handler = get_new_handler();
+    if (handler == NULL) return NULL;
+    handler();
+  }
+}
+
+void *
+operator new(size_t size)
+{
+  void *p = counted_alloc(size);
+  if (p == NULL) throw bad_alloc();
+  return p;
+}
+
+void *
+operator new[](size_t size)
+{
+  void *p = counted_alloc(size);
+  if (p == NULL) throw bad_alloc();
+  return p;
+}
+
+void *
+operator new(size_t size, const nothrow_t &) noexcept
+{
+  try {
+    return counted_alloc(size);
+  }
+  catch (...) {
+    return NULL;
+  }
+}
+
+void *
+operator new[](size_t size, const nothrow_t &) noexcept
+{
+  try {
+    return counted_alloc(size);
+  }
+  catch (...) {
+    return NULL;
+  }
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, const nothrow_t &) noexcept { free(p); }
+void operator delete[](void *p, const nothrow_t &) noexcept { free(p); }
+
+#endif // EGRET_MEMORY
+
+MemoryUsage
+get_memory_usage()
+{
+  MemoryUsage usage;
+#ifdef EGRET_MEMORY
+  usage.allocations = allocations.load(memory_order_relaxed);
+  usage.bytes = allocated_bytes.load(memory_order_relaxed);
+#else
+  usage.allocations = 0;
+  usage.bytes = 0;
+#endif
+
+  // ru_maxrss is in KB on Linux
+  struct rusage ru;
+  usage.peak_rss = getrusage(RUSAGE_SELF, &ru) == 0 ? ru.ru_maxrss : 0;
+  return usage;
+}
+
+bool
+counting_allocations()
+{
+#ifdef EGRET_MEMORY
+  return true;
+#else
+  return false;
+#endif
+}
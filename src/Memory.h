@@ -0,0 +1,44 @@
+/*  Memory.h: heap and resident memory accounting
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// When EGRET_MEMORY is defined (make MEMORY=1), the global operator new
+// and delete are replaced with versions that count the allocations and
+// the bytes allocated.  The replacement is linked into any program or
+// extension built with libegret.a, and counts every C++ allocation in the
+// process (not only the engine's).  The peak resident set size is read
+// from the operating system and is always available.
+
+#ifndef MEMORY_H
+#define MEMORY_H
+
+struct MemoryUsage {
+  unsigned long allocations;	// allocations made (0 without the hook)
+  unsigned long bytes;		// bytes allocated (0 without the hook)
+  long peak_rss;		// peak resident set size in KB
+};
+
+// returns the memory used so far by the process
+MemoryUsage get_memory_usage();
+
+// returns true if allocations are counted
+bool counting_allocations();
+
+#endif // MEMORY_H
@@ -22,9 +22,11 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <vector>
+#include "Counters.h"
 #include "Edge.h"
 #include "NFA.h"
 #include "ParseTree.h"
@@ -35,6 +37,8 @@ static Edge EPSILON = Edge(EPSILON_EDGE);
 
 NFA::NFA(unsigned int _size, unsigned int _initial, unsigned int  _final)
 {
+  deadline = NULL;
+  contracted = 0;
   size = _size;
   initial = _initial;
   final = _final;
@@ -51,10 +55,24 @@ NFA::NFA(unsigned int _size, unsigned int _initial, unsigned int  _final)
 
 NFA::NFA(const NFA &other)
 {
+  COUNT(NFA_COPIES);
   size = other.size;
   initial = other.initial;
   final = other.final;
   edge_table = other.edge_table;
+  deadline = other.deadline;
+  contracted = other.contracted;
+  storage = other.storage;
+}
+
+NFA::Storage::~Storage()
+{
+  vector <Edge *>::iterator e;
+  for (e = edges.begin(); e != edges.end(); e++) delete *e;
+  vector <RegexLoop *>::iterator l;
+  for (l = loops.begin(); l != loops.end(); l++) delete *l;
+  vector <RegexString *>::iterator r;
+  for (r = strings.begin(); r != strings.end(); r++) delete *r;
 }
 
 NFA &
@@ -63,31 +81,49 @@ NFA::operator=(const NFA & other)
   if (this == &other)
     return *this;
 
+  COUNT(NFA_COPIES);
   initial = other.initial;
   final = other.final;
   size = other.size;
   edge_table = other.edge_table;
+  deadline = other.deadline;
+  contracted = other.contracted;
+  storage = other.storage;
 
   return *this;
 }
 
 void
-NFA::build(ParseTree &tree)
+NFA::build(ParseTree &tree, Deadline *_deadline)
+{
+  build(tree.get_root(), _deadline);
+}
+
+void
+NFA::build(ParseNode *root, Deadline *_deadline)
 {
+  deadline = _deadline;
+  storage = make_shared<Storage>();
+
   // Build NFA
-  NFA nfa = build_nfa_from_tree(tree.get_root());
+  NFA nfa = build_nfa_from_tree(root);
 
-  // Copy NFA
+  // Move NFA
   initial = nfa.initial;
   final = nfa.final;
   size = nfa.size;
-  edge_table = nfa.edge_table;
+  edge_table = move(nfa.edge_table);
+  contracted = 0;
+
+  // Remove the epsilon edges that join the parts
+  contract_epsilon_chains();
 }
 
 NFA
 NFA::build_nfa_from_tree(ParseNode *tree)
 {
   assert(tree);
+  if (deadline) deadline->check("building NFA");
 
   switch (tree->type) {
 
@@ -146,15 +182,17 @@ NFA::build_nfa_alternation(NFA nfa1, NFA nfa2)
   // make room for nfa1
   nfa2.shift_states(nfa1.size);
 
-  // create a new nfa and initialize it with (the shifted) nfa2
-  NFA new_nfa(nfa2);
+  // create a new nfa from (the shifted) nfa2
+  unsigned int initial2 = nfa2.initial;
+  unsigned int final2 = nfa2.final;
+  NFA new_nfa(move(nfa2));
 
   // nfa1's states take their places in new_nfa
   new_nfa.fill_states(nfa1);
 
   // Set new initial state and the edges from it
   new_nfa.add_edge(0, nfa1.initial, &EPSILON);
-  new_nfa.add_edge(0, nfa2.initial, &EPSILON);
+  new_nfa.add_edge(0, initial2, &EPSILON);
   new_nfa.initial = 0;
 
   // Make up space for the new final state
@@ -163,7 +201,7 @@ NFA::build_nfa_alternation(NFA nfa1, NFA nfa2)
   // Set new final state
   new_nfa.final = new_nfa.size - 1;
   new_nfa.add_edge(nfa1.final, new_nfa.final, &EPSILON);
-  new_nfa.add_edge(nfa2.final, new_nfa.final, &EPSILON);
+  new_nfa.add_edge(final2, new_nfa.final, &EPSILON);
 
   return new_nfa;
 }
@@ -177,8 +215,8 @@ NFA::build_nfa_concat(NFA nfa1, NFA nfa2)
   // make room for nfa1
   nfa2.shift_states(nfa1.size);
 
-  // create a new nfa and initialize it with (the shifted) nfa2
-  NFA new_nfa(nfa2);
+  // create a new nfa from (the shifted) nfa2
+  NFA new_nfa(move(nfa2));
 
   // nfa1's states take their places in new_nfa
   new_nfa.fill_states(nfa1);
@@ -203,12 +241,12 @@ NFA::build_nfa_repeat(NFA nfa, int repeat_lower, int repeat_upper)
   nfa.append_empty_state();
 
   // create new loop
-  RegexLoop *regex_loop = new RegexLoop(repeat_lower, repeat_upper);
+  RegexLoop *regex_loop = store(new RegexLoop(repeat_lower, repeat_upper));
 
   // add new edges
-  Edge *edge = new Edge(BEGIN_LOOP_EDGE, regex_loop);
+  Edge *edge = store(new Edge(BEGIN_LOOP_EDGE, regex_loop));
   nfa.add_edge(0, nfa.initial, edge);	   // new initial to old initial
-  edge = new Edge(END_LOOP_EDGE, regex_loop);
+  edge = store(new Edge(END_LOOP_EDGE, regex_loop));
   nfa.add_edge(nfa.final, nfa.size - 1, edge); // old final to new final
 
   // update states
@@ -222,8 +260,8 @@ NFA
 NFA::build_nfa_string(ParseNode *node, int repeat_lower, int repeat_upper)
 {
   NFA nfa(2, 0, 1);
-  RegexString *regex_str = new RegexString(node->char_set, repeat_lower, repeat_upper);
-  Edge *edge = new Edge(STRING_EDGE, regex_str);
+  RegexString *regex_str = store(new RegexString(node->char_set, repeat_lower, repeat_upper));
+  Edge *edge = store(new Edge(STRING_EDGE, regex_str));
   nfa.add_edge(0, 1, edge);
 
   return nfa;
@@ -234,25 +272,22 @@ NFA::build_nfa_group(NFA nfa, string name, int num)
 {
   
   NFA nfa1(2, 0, 1);
-  Edge *begin_edge = new Edge(BEGIN_GROUP_EDGE, name, num);
+  Edge *begin_edge = store(new Edge(BEGIN_GROUP_EDGE, name, num));
   nfa1.add_edge(0, 1, begin_edge);
 
   NFA nfa2(2, 0, 1);
-  Edge *end_edge = new Edge(END_GROUP_EDGE, name, num);
+  Edge *end_edge = store(new Edge(END_GROUP_EDGE, name, num));
   nfa2.add_edge(0, 1, end_edge);
 
-  NFA ret(nfa.size+2, 0, nfa.size+1);
-  ret = build_nfa_concat(nfa1, nfa);
-  ret = build_nfa_concat(ret, nfa2);
-  
-  return ret;
+  NFA ret = build_nfa_concat(move(nfa1), move(nfa));
+  return build_nfa_concat(move(ret), move(nfa2));
 }
 
 NFA
 NFA::build_nfa_backreference(string name, int num, int id)
 {
   NFA nfa(2, 0, 1);     // size = 2, initial = 0, final = 1
-  Edge *edge = new Edge(BACKREFERENCE_EDGE, name, num, id);
+  Edge *edge = store(new Edge(BACKREFERENCE_EDGE, name, num, id));
   nfa.add_edge(0, 1, edge);
   return nfa;
 }
@@ -261,7 +296,7 @@ NFA
 NFA::build_nfa_character(char character)
 {
   NFA nfa(2, 0, 1);	// size = 2, initial = 0 , final = 1
-  Edge *edge = new Edge(CHARACTER_EDGE, character);
+  Edge *edge = store(new Edge(CHARACTER_EDGE, character));
   nfa.add_edge(0, 1, edge);
   return nfa;
 }
@@ -270,7 +305,7 @@ NFA
 NFA::build_nfa_caret()
 {
   NFA nfa(2, 0, 1);	// size = 2, initial = 0 , final = 1
-  Edge *edge = new Edge(CARET_EDGE);
+  Edge *edge = store(new Edge(CARET_EDGE));
   nfa.add_edge(0, 1, edge);
   return nfa;
 }
@@ -279,7 +314,7 @@ NFA
 NFA::build_nfa_dollar()
 {
   NFA nfa(2, 0, 1);	// size = 2, initial = 0 , final = 1
-  Edge *edge = new Edge(DOLLAR_EDGE);
+  Edge *edge = store(new Edge(DOLLAR_EDGE));
   nfa.add_edge(0, 1, edge);
   return nfa;
 }
@@ -296,7 +331,7 @@ NFA
 NFA::build_nfa_char_set(CharSet *char_set)
 {
   NFA nfa(2, 0, 1);     // size = 2, initial = 0, final = 1
-  Edge *edge = new Edge(CHAR_SET_EDGE, char_set);
+  Edge *edge = store(new Edge(CHAR_SET_EDGE, char_set));
   nfa.add_edge(0, 1, edge);
   return nfa;
 }
@@ -332,7 +367,7 @@ NFA::shift_states(unsigned int shift)
   size = new_size;
   initial += shift;
   final += shift;
-  edge_table = new_edge_table;
+  edge_table.swap(new_edge_table);
 }
 
 // fills states from other's states
@@ -361,6 +396,66 @@ NFA::append_empty_state()
   size += 1;
 }
 
+// Concatenation joins the final state of one part to the initial state of
+// the next with an epsilon edge.  Such an edge is the only way out of its
+// source and the only way into its target, so every path through one of
+// the states goes through both, and the target can be folded into the
+// source.  The states keep their order, so each state's adjacent states
+// (and the paths found from them) come in the same order as before.  The
+// states of a part of the regex are still numbered in one block, with a
+// loop body between its begin and end edges.
+void
+NFA::contract_epsilon_chains()
+{
+  vector <unsigned int> in_count(size, 0);
+  vector <unsigned int> out_count(size, 0);
+  for (unsigned int from = 0; from < size; from++) {
+    for (unsigned int to = 0; to < size; to++) {
+      if (edge_table[from][to] == NULL) continue;
+      out_count[from]++;
+      in_count[to]++;
+    }
+  }
+
+  // fold each chain of such edges into its first state
+  vector <bool> removed(size, false);
+  for (unsigned int from = 0; from < size; from++) {
+    if (removed[from]) continue;
+    while (out_count[from] == 1) {
+      unsigned int to = 0;
+      while (edge_table[from][to] == NULL) to++;
+      if (edge_table[from][to]->getType() != EPSILON_EDGE || in_count[to] != 1) break;
+
+      edge_table[from].swap(edge_table[to]);
+      edge_table[to].assign(size, NULL);
+      out_count[from] = out_count[to];
+      removed[to] = true;
+      if (to == final) final = from;
+      contracted++;
+    }
+  }
+  if (contracted == 0) return;
+
+  // number the remaining states in order
+  vector <unsigned int> number(size);
+  unsigned int new_size = 0;
+  for (unsigned int state = 0; state < size; state++) {
+    number[state] = new_size;
+    if (!removed[state]) new_size++;
+  }
+  vector <vector <Edge *> > new_edge_table(new_size, vector <Edge *>(new_size, NULL));
+  for (unsigned int from = 0; from < size; from++) {
+    if (removed[from]) continue;
+    for (unsigned int to = 0; to < size; to++) {
+      if (edge_table[from][to] != NULL) new_edge_table[number[from]][number[to]] = edge_table[from][to];
+    }
+  }
+  initial = number[initial];
+  final = number[final];
+  size = new_size;
+  edge_table.swap(new_edge_table);
+}
+
 bool
 NFA::is_regex_string(ParseNode *node, int repeat_lower, int repeat_upper)
 {
@@ -377,46 +472,378 @@ NFA::is_regex_string(ParseNode *node, int repeat_lower, int repeat_upper)
   return true;
 }
 
+// The basis paths come from a depth first traversal that stops following
+// more than the first edge out of a state once a path through that state
+// has reached the final state.  Which states are visited depends on the
+// branches explored before, so a branch explored on another thread is run
+// ahead of time against a prediction of the visited states: the first path
+// out of each earlier sibling branch (which the traversal is sure to find)
+// is taken as visited.  The traversal records each state it read before
+// writing it along with the value seen, and when the earlier branches are
+// done those values are checked against the states actually visited.  A
+// branch whose check fails is traversed again, so the paths (and their
+// order) are always those of a traversal on one thread.
+struct NFA::Traversal {
+
+  Traversal(const vector <vector <unsigned int> > *n, const vector <unsigned int> *w,
+            const vector <char> &v, Deadline *d) {
+    next_states = n;
+    weights = w;
+    deadline = d;
+    visited = v;
+    touched.assign(v.size(), 0);
+  }
+
+  const vector <vector <unsigned int> > *next_states;	// adjacent states of each state
+  const vector <unsigned int> *weights;	// rough size of the traversal from each state
+  Deadline *deadline;			// deadline for the traversal (NULL if none)
+  vector <char> visited;		// visited states as seen by this traversal
+  vector <char> touched;		// set once a state has been read or written
+  vector <pair <unsigned int, char> > reads;	// states read before written, with the value seen
+  vector <unsigned int> writes;		// states written
+  vector <Path> paths;			// paths found
+
+  // returns true if a state has been visited
+  bool is_visited(unsigned int state) {
+    if (!touched[state]) {
+      touched[state] = 1;
+      reads.push_back(make_pair(state, visited[state]));
+    }
+    return visited[state];
+  }
+
+  // marks a state as visited
+  void mark(unsigned int state) {
+    touched[state] = 1;
+    if (!visited[state]) {
+      visited[state] = 1;
+      writes.push_back(state);
+    }
+  }
+
+  // adds the results of a later branch traversed ahead of time, returns
+  // false (adding no paths) if it saw different visited states
+  bool merge(Traversal &branch) {
+    vector <pair <unsigned int, char> >::iterator r;
+    for (r = branch.reads.begin(); r != branch.reads.end(); r++) {
+      if (is_visited(r->first) != r->second) return false;
+    }
+    vector <unsigned int>::iterator w;
+    for (w = branch.writes.begin(); w != branch.writes.end(); w++) {
+      mark(*w);
+    }
+    paths.insert(paths.end(), branch.paths.begin(), branch.paths.end());
+    return true;
+  }
+};
+
+// smallest branch worth running ahead of time (see weights)
+#define MIN_BRANCH_WEIGHT 32
+
 vector <Path>
-NFA::find_basis_paths()
+NFA::find_basis_paths(Deadline *_deadline, ThreadPool *pool) const
 {
-  Path path(initial);
-  vector <Path> paths;
-  bool *visited = new bool[size];
-  for (unsigned int i = 0; i < size; i++)
-    visited[i] = false;
+  if (pool != NULL && pool->size() < 2) pool = NULL;
 
-  traverse(initial, path, paths, visited);
+  // adjacent states of each state, in order
+  vector <vector <unsigned int> > next_states(size);
+  for (unsigned int from = 0; from < size; from++) {
+    for (unsigned int to = 0; to < size; to++) {
+      if (edge_table[from][to] != NULL) next_states[from].push_back(to);
+    }
+  }
 
-  delete visited;
+  // weight of a state: the number of states reachable from it, counting
+  // shared states once per way of reaching them (capped at the NFA size)
+  vector <unsigned int> weights(size, 1);
+  if (pool != NULL) {
+    vector <bool> done(size, false);
+    vector <unsigned int> stack(1, initial);
+    while (!stack.empty()) {
+      unsigned int state = stack.back();
+      if (done[state]) {
+        stack.pop_back();
+        continue;
+      }
+      bool ready = true;
+      vector <unsigned int>::iterator it;
+      for (it = next_states[state].begin(); it != next_states[state].end(); it++) {
+        if (!done[*it]) {
+          stack.push_back(*it);
+          ready = false;
+        }
+      }
+      if (!ready) continue;
+      stack.pop_back();
+      for (it = next_states[state].begin(); it != next_states[state].end(); it++) {
+        weights[state] = min(size, weights[state] + weights[*it]);
+      }
+      done[state] = true;
+    }
+  }
 
-  return paths;
+  Traversal t(&next_states, &weights, vector <char>(size, 0), _deadline);
+  Path path(initial);
+  traverse(t, initial, path, pool);
+  return t.paths;
 }
 
 void
-NFA::traverse(unsigned int curr_state, Path path, vector <Path> &paths, bool *visited)
+NFA::traverse(Traversal &t, unsigned int curr_state, Path &path, ThreadPool *pool) const
 {
+  // stop if time has run out (paths found so far are kept)
+  if (t.deadline && t.deadline->expired("enumerating paths")) return;
+
   // stop if you already have been here
-  bool been_here = visited[curr_state];
+  COUNT(TRAVERSE_VISITS);
+  bool been_here = t.is_visited(curr_state);
 
   // final state --> process the path and stop the traversal
   if (curr_state == final) {
-    path.mark_path_visited(visited);
-    paths.push_back(path);
+    const vector <unsigned int> &states = path.get_states();
+    for (unsigned int i = 0; i < states.size(); i++) {
+      t.mark(states[i]);
+    }
+    t.paths.push_back(path);
     return;
   }
 
+  // start the later branches on the pool, predicting that the path so far
+  // and the first path out of every earlier branch have been visited
+  const vector <unsigned int> &next = (*t.next_states)[curr_state];
+  vector <future <shared_ptr <Traversal> > > ahead(next.size());
+  vector <bool> is_ahead(next.size(), false);
+  if (pool != NULL && !been_here && next.size() > 1) {
+    vector <char> predicted = t.visited;
+    const vector <unsigned int> &states = path.get_states();
+    for (unsigned int i = 0; i < states.size(); i++) {
+      predicted[states[i]] = 1;
+    }
+    for (unsigned int i = 1; i < next.size(); i++) {
+      unsigned int state = next[i - 1];
+      predicted[state] = 1;
+      while (state != final && !(*t.next_states)[state].empty()) {
+        state = (*t.next_states)[state][0];
+        predicted[state] = 1;
+      }
+      if ((*t.weights)[next[i]] < MIN_BRANCH_WEIGHT) continue;
+
+      shared_ptr <Traversal> branch =
+        make_shared <Traversal>(t.next_states, t.weights, predicted, t.deadline);
+      Path branch_path = path;
+      unsigned int branch_state = next[i];
+      branch_path.append(edge_table[curr_state][branch_state], branch_state);
+      ahead[i] = pool->submit(function <shared_ptr <Traversal> ()>(
+        [this, branch, branch_path, branch_state, pool]() mutable {
+          traverse(*branch, branch_state, branch_path, pool);
+          return branch;
+        }));
+      is_ahead[i] = true;
+    }
+  }
+
   // for each adjacent state, find all paths 
-  for (unsigned int next_state = 0; next_state < size; next_state++) {
-    Edge *edge = edge_table[curr_state][next_state];
-    if (edge == NULL) continue;
-    path.append(edge, next_state);
-    traverse(next_state, path, paths, visited);
+  for (unsigned int i = 0; i < next.size(); i++) {
+    if (is_ahead[i]) {
+      shared_ptr <Traversal> branch = pool->wait(ahead[i]);
+      if (t.merge(*branch)) continue;
+    }
+    path.append(edge_table[curr_state][next[i]], next[i]);
+    traverse(t, next[i], path, pool);
     path.remove_last();
     if (been_here) break;
   }
 }
 
+vector <Path>
+NFA::find_paths(PathStrategy strategy, Deadline *_deadline, ThreadPool *pool) const
+{
+  if (strategy == EDGE_COVER_PATHS)
+    return find_edge_cover_paths(_deadline);
+  return find_basis_paths(_deadline, pool);
+}
+
+// The edge cover is found as a flow from the initial state to the final
+// state where every edge carries at least one unit (each unit is a path).
+// A greedy pass gives a cover of at most one path per edge, then the flow
+// is reduced to the minimum by pushing units back from the final state to
+// the initial state while every edge keeps at least one unit.
+vector <Path>
+NFA::find_edge_cover_paths(Deadline *_deadline) const
+{
+
+  // number the edges
+  vector <CoverEdge> edges;
+  vector <vector <unsigned int> > out_edges(size);
+  vector <vector <unsigned int> > in_edges(size);
+  for (unsigned int from = 0; from < size; from++) {
+    for (unsigned int to = 0; to < size; to++) {
+      if (edge_table[from][to] == NULL) continue;
+      CoverEdge edge;
+      edge.from = from;
+      edge.to = to;
+      out_edges[from].push_back(edges.size());
+      in_edges[to].push_back(edges.size());
+      edges.push_back(edge);
+    }
+  }
+
+  vector <unsigned int> flow(edges.size(), 0);
+  vector <unsigned int> order = topological_order(edges, out_edges);
+  find_cover_flow(edges, out_edges, order, flow, _deadline);
+  reduce_cover_flow(edges, out_edges, in_edges, flow, _deadline);
+
+  // split the flow into paths
+  vector <Path> paths;
+  while (true) {
+    unsigned int curr_state = initial;
+    Path path(initial);
+    while (curr_state != final) {
+      vector <unsigned int>::iterator it;
+      for (it = out_edges[curr_state].begin(); it != out_edges[curr_state].end(); it++) {
+        if (flow[*it] > 0) break;
+      }
+      if (it == out_edges[curr_state].end()) break;
+      flow[*it]--;
+      curr_state = edges[*it].to;
+      path.append(edge_table[edges[*it].from][curr_state], curr_state);
+    }
+    if (curr_state != final) break;
+    paths.push_back(path);
+  }
+
+  return paths;
+}
+
+vector <unsigned int>
+NFA::topological_order(const vector <CoverEdge> &edges,
+                       const vector <vector <unsigned int> > &out_edges) const
+{
+  vector <unsigned int> in_degree(size, 0);
+  vector <CoverEdge>::const_iterator e;
+  for (e = edges.begin(); e != edges.end(); e++) {
+    in_degree[e->to]++;
+  }
+
+  vector <unsigned int> order;
+  for (unsigned int state = 0; state < size; state++) {
+    if (in_degree[state] == 0) order.push_back(state);
+  }
+  for (unsigned int i = 0; i < order.size(); i++) {
+    vector <unsigned int>::const_iterator it;
+    for (it = out_edges[order[i]].begin(); it != out_edges[order[i]].end(); it++) {
+      if (--in_degree[edges[*it].to] == 0) order.push_back(edges[*it].to);
+    }
+  }
+
+  // loops are begin/end edges, so the NFA has no cycles
+  if (order.size() != size) {
+    throw EgretException("ERROR (internal): NFA has a cycle");
+  }
+  return order;
+}
+
+void
+NFA::find_cover_flow(const vector <CoverEdge> &edges,
+                     const vector <vector <unsigned int> > &out_edges,
+                     const vector <unsigned int> &order, vector <unsigned int> &flow,
+                     Deadline *_deadline) const
+{
+  vector <int> gain(size);		// uncovered edges on the best path to final
+  vector <int> best_edge(size);		// first edge of that path
+  unsigned int uncovered = edges.size();
+
+  while (uncovered > 0) {
+    if (_deadline && _deadline->expired("enumerating paths")) return;
+
+    // find the path from each state through the most uncovered edges
+    for (int i = size - 1; i >= 0; i--) {
+      unsigned int state = order[i];
+      gain[state] = (state == final) ? 0 : -1;
+      best_edge[state] = -1;
+      vector <unsigned int>::const_iterator it;
+      for (it = out_edges[state].begin(); it != out_edges[state].end(); it++) {
+        int next_gain = gain[edges[*it].to];
+        if (next_gain < 0) continue;
+        if (flow[*it] == 0) next_gain++;
+        if (next_gain > gain[state]) {
+          gain[state] = next_gain;
+          best_edge[state] = *it;
+        }
+      }
+    }
+
+    // stop if the remaining edges are not on a path to the final state
+    if (gain[initial] <= 0) return;
+
+    unsigned int state = initial;
+    while (state != final) {
+      unsigned int e = best_edge[state];
+      if (flow[e] == 0) uncovered--;
+      flow[e]++;
+      state = edges[e].to;
+    }
+  }
+}
+
+void
+NFA::reduce_cover_flow(const vector <CoverEdge> &edges,
+                       const vector <vector <unsigned int> > &out_edges,
+                       const vector <vector <unsigned int> > &in_edges,
+                       vector <unsigned int> &flow, Deadline *_deadline) const
+{
+  // pred_edge[state] is the edge used to reach state, pred_back[state] is
+  // set if the edge is followed backwards (taking a unit off the edge)
+  vector <int> pred_edge(size);
+  vector <bool> pred_back(size);
+  vector <bool> seen(size);
+
+  while (true) {
+    if (_deadline && _deadline->expired("enumerating paths")) return;
+
+    // breadth first search from final to initial
+    fill(seen.begin(), seen.end(), false);
+    vector <unsigned int> queue;
+    queue.push_back(final);
+    seen[final] = true;
+    for (unsigned int i = 0; i < queue.size() && !seen[initial]; i++) {
+      unsigned int state = queue[i];
+      vector <unsigned int>::const_iterator it;
+      for (it = in_edges[state].begin(); it != in_edges[state].end(); it++) {
+        unsigned int next_state = edges[*it].from;
+        if (seen[next_state] || flow[*it] <= 1) continue;
+        seen[next_state] = true;
+        pred_edge[next_state] = *it;
+        pred_back[next_state] = true;
+        queue.push_back(next_state);
+      }
+      for (it = out_edges[state].begin(); it != out_edges[state].end(); it++) {
+        unsigned int next_state = edges[*it].to;
+        if (seen[next_state]) continue;
+        seen[next_state] = true;
+        pred_edge[next_state] = *it;
+        pred_back[next_state] = false;
+        queue.push_back(next_state);
+      }
+    }
+    if (!seen[initial]) return;
+
+    // move one unit back along the search path (one less path)
+    unsigned int state = initial;
+    while (state != final) {
+      unsigned int e = pred_edge[state];
+      if (pred_back[state]) {
+        flow[e]--;
+        state = edges[e].to;
+      }
+      else {
+        flow[e]++;
+        state = edges[e].from;
+      }
+    }
+  }
+}
+
 void
 NFA::print()
 {
@@ -514,4 +941,12 @@ NFA::add_stats(Stats &stats)
   stats.add("NFA", "NFA backreference edges", backreference_count);
   stats.add("NFA", "NFA begin group edges", begin_group_count);
   stats.add("NFA", "NFA end group edges", end_group_count);
+  stats.add("NFA", "NFA epsilon edges contracted", contracted);
+
+  long table_bytes = edge_table.capacity() * sizeof(vector <Edge *>);
+  for (unsigned int from = 0; from < edge_table.size(); from++) {
+    table_bytes += edge_table[from].capacity() * sizeof(Edge *);
+  }
+  stats.add("NFA", "NFA edge table bytes", table_bytes);
+  stats.add("NFA", "NFA edge bytes", edge_count * sizeof(Edge));
 }
@@ -25,28 +25,46 @@
 #ifndef NFA_H
 #define NFA_H
 
+#include <memory>
 #include <vector>
 #include "Edge.h"
 #include "CharSet.h"
+#include "Deadline.h"
 #include "ParseTree.h"
 #include "Path.h"
+#include "PathStrategy.h"
 #include "Stats.h"
+#include "ThreadPool.h"
 using namespace std;
 
 class NFA {
 
 public:
 
-  NFA() {}
+  NFA() { deadline = NULL; contracted = 0; }
   NFA(unsigned int _size, unsigned int _initial, unsigned int _final);
   NFA(const NFA &other);
+  NFA(NFA &&other) = default;
   NFA &operator= (const NFA &other);
+  NFA &operator= (NFA &&other) = default;
 
   // build an NFA from the parse tree
-  void build(ParseTree &tree);
+  void build(ParseTree &tree, Deadline *_deadline = NULL);
 
-  // create a set of basis paths
-  vector <Path> find_basis_paths();
+  // build an NFA from a parse tree given by its root
+  void build(ParseNode *root, Deadline *_deadline = NULL);
+
+  // create a set of basis paths (stops early if the deadline passes), with a
+  // pool branches are explored on several threads (the paths are the same)
+  vector <Path> find_basis_paths(Deadline *_deadline = NULL, ThreadPool *pool = NULL) const;
+
+  // create a small set of paths that covers every edge, there are never
+  // more paths than edges (stops early if the deadline passes)
+  vector <Path> find_edge_cover_paths(Deadline *_deadline = NULL) const;
+
+  // create paths using the given strategy
+  vector <Path> find_paths(PathStrategy strategy, Deadline *_deadline = NULL,
+                           ThreadPool *pool = NULL) const;
 
   // print out the NFA
   void print();
@@ -56,10 +74,28 @@ public:
 
 private:
 
+  friend class RedosAnalyzer;
+
   unsigned int size;			// number of states
   unsigned int initial;			// initial state
   unsigned int final;			// final state
   vector <vector <Edge *> > edge_table;	// edge table
+  Deadline *deadline;			// deadline for building (NULL if none)
+  unsigned int contracted;		// epsilon edges removed after building
+
+  // edges and edge data allocated while building, released with the last copy
+  struct Storage {
+    ~Storage();
+    vector <Edge *> edges;
+    vector <RegexLoop *> loops;
+    vector <RegexString *> strings;
+  };
+  shared_ptr <Storage> storage;
+
+  // record allocations so they can be released with the NFA
+  Edge *store(Edge *edge) { storage->edges.push_back(edge); return edge; }
+  RegexLoop *store(RegexLoop *loop) { storage->loops.push_back(loop); return loop; }
+  RegexString *store(RegexString *str) { storage->strings.push_back(str); return str; }
   
   // builds an NFA from tree
   NFA build_nfa_from_tree(ParseNode *tree);
@@ -109,11 +145,44 @@ private:
   // appends a new empty state to the NFA
   void append_empty_state();
 
+  // removes each epsilon edge that is the only edge out of its source and
+  // the only edge into its target, merging the two states (the paths and
+  // their order stay the same)
+  void contract_epsilon_chains();
+
   // returns true if repeat quantifier represents a string
   bool is_regex_string(ParseNode *node, int repeat_lower, int repeat_upper);
 
+  // a traversal of part of the NFA (see NFA.cpp)
+  struct Traversal;
+
   // utility function to find all paths through the NFA
-  void traverse(unsigned int curr_state, Path path, vector <Path> &paths, bool *visited);
+  void traverse(Traversal &t, unsigned int curr_state, Path &path, ThreadPool *pool) const;
+
+  // an edge, numbered for the edge cover
+  struct CoverEdge {
+    unsigned int from;
+    unsigned int to;
+  };
+
+  // returns the states in topological order
+  vector <unsigned int> topological_order(const vector <CoverEdge> &edges,
+                                          const vector <vector <unsigned int> > &out_edges) const;
+
+  // adds paths from the initial state to the final state to flow, each one
+  // through as many uncovered edges as possible, until every edge is covered
+  // (or the deadline passes)
+  void find_cover_flow(const vector <CoverEdge> &edges,
+                       const vector <vector <unsigned int> > &out_edges,
+                       const vector <unsigned int> &order, vector <unsigned int> &flow,
+                       Deadline *_deadline) const;
+
+  // reduces flow to the fewest paths that still cover every edge (stops
+  // early if the deadline passes)
+  void reduce_cover_flow(const vector <CoverEdge> &edges,
+                         const vector <vector <unsigned int> > &out_edges,
+                         const vector <vector <unsigned int> > &in_edges,
+                         vector <unsigned int> &flow, Deadline *_deadline) const;
 };
 
 #endif // NFA_H
@@ -42,15 +42,28 @@ using namespace std;
 // RD Parser
 //=============================================================
 
+ParseTree::~ParseTree()
+{
+  vector <ParseNode *>::iterator it;
+  for (it = nodes.begin(); it != nodes.end(); it++) {
+    delete *it;
+  }
+  vector <CharSet *>::iterator cs;
+  for (cs = char_sets.begin(); cs != char_sets.end(); cs++) {
+    delete *cs;
+  }
+}
+
 void
-ParseTree::build(Scanner &_scanner)
+ParseTree::build(Scanner &_scanner, Deadline *_deadline)
 {
-  scanner = _scanner;
+  scanner = &_scanner;
+  deadline = _deadline;
   root = expr();
   
-  if (scanner.get_type() != ERR) {
+  if (scanner->get_type() != ERR) {
     stringstream s;
-    s << "ERROR: Parse error - expected end of regex but received " << scanner.get_type_str();
+    s << "ERROR: Parse error - expected end of regex but received " << scanner->get_type_str();
     throw EgretException(s.str());
   }
   count_groups();
@@ -66,24 +79,25 @@ ParseNode *
 ParseTree::expr()
 {
   ParseNode *left, *right;
+  unsigned int start = scanner->get_start();
 
   // check for alternation without a "left"
-  if (scanner.get_type() == ALTERNATION) {
+  if (scanner->get_type() == ALTERNATION) {
     left = NULL;
   } else {
     left = concat();
   }
 
   // check for lack of alternation
-  if (scanner.get_type() != ALTERNATION) {
-    return left;
+  if (scanner->get_type() != ALTERNATION) {
+    return mark(left, start);
   }
 
   // advance past alternation token
-  scanner.advance();
+  scanner->advance();
 
   // check for lacking right
-  if (scanner.get_type() == RIGHT_PAREN || scanner.get_type() == ERR) {
+  if (scanner->get_type() == RIGHT_PAREN || scanner->get_type() == ERR) {
     right = NULL;
   } else {
     right = expr();
@@ -96,18 +110,18 @@ ParseTree::expr()
   }
   // left empty: return right?
   else if (left == NULL) {
-    ParseNode *expr_node = new ParseNode(REPEAT_NODE, right, 0, 1);
-    return expr_node;
+    ParseNode *expr_node = add_node(new ParseNode(REPEAT_NODE, right, 0, 1));
+    return mark(expr_node, start);
   }
   // right empty: return left?
   else if (right == NULL) {
-    ParseNode *expr_node = new ParseNode(REPEAT_NODE, left, 0, 1);
-    return expr_node;
+    ParseNode *expr_node = add_node(new ParseNode(REPEAT_NODE, left, 0, 1));
+    return mark(expr_node, start);
   }
   
   // otherwise return left | right
-  ParseNode *expr_node = new ParseNode(ALTERNATION_NODE, left, right);
-  return expr_node;
+  ParseNode *expr_node = add_node(new ParseNode(ALTERNATION_NODE, left, right));
+  return mark(expr_node, start);
 }
 
 // concat ::= rep concat
@@ -117,13 +131,14 @@ ParseNode *
 ParseTree::concat()
 {
   // always a repetition node to the left
+  unsigned int start = scanner->get_start();
   ParseNode *left = rep();
 
   // check for concatenation
-  if (scanner.is_concat()) {
+  if (scanner->is_concat()) {
     ParseNode *right = concat();
-    ParseNode *concat_node = new ParseNode(CONCAT_NODE, left, right);
-    return concat_node;
+    ParseNode *concat_node = add_node(new ParseNode(CONCAT_NODE, left, right));
+    return mark(concat_node, start);
   } else {
     return left;
   }
@@ -139,31 +154,38 @@ ParseTree::concat()
 ParseNode *
 ParseTree::rep()
 {
+  if (deadline) deadline->check("parsing regex");
+
   // first is always atom node
+  unsigned int start = scanner->get_start();
   ParseNode *atom_node = atom();
 
   // then check for repetition character
-  if (scanner.get_type() == STAR) {
-    scanner.advance();
-    ParseNode *rep_node = new ParseNode(REPEAT_NODE, atom_node, 0, -1);
-    return rep_node;
-  }
-  else if (scanner.get_type() == PLUS) {
-    scanner.advance();
-    ParseNode *rep_node = new ParseNode(REPEAT_NODE, atom_node, 1, -1);
-    return rep_node;
-  }
-  else if (scanner.get_type() == QUESTION) {
-    scanner.advance();
-    ParseNode *rep_node = new ParseNode(REPEAT_NODE, atom_node, 0, 1);
-    return rep_node;
-  }
-  else if (scanner.get_type() == REPEAT) {
-    int lower = scanner.get_repeat_lower();
-    int upper = scanner.get_repeat_upper();
-    scanner.advance();
-    ParseNode *rep_node = new ParseNode(REPEAT_NODE, atom_node, lower, upper);
-    return rep_node;
+  if (scanner->get_type() == STAR) {
+    bool lazy = scanner->is_lazy();
+    scanner->advance();
+    ParseNode *rep_node = add_node(new ParseNode(REPEAT_NODE, atom_node, 0, -1, lazy));
+    return mark(rep_node, start);
+  }
+  else if (scanner->get_type() == PLUS) {
+    bool lazy = scanner->is_lazy();
+    scanner->advance();
+    ParseNode *rep_node = add_node(new ParseNode(REPEAT_NODE, atom_node, 1, -1, lazy));
+    return mark(rep_node, start);
+  }
+  else if (scanner->get_type() == QUESTION) {
+    bool lazy = scanner->is_lazy();
+    scanner->advance();
+    ParseNode *rep_node = add_node(new ParseNode(REPEAT_NODE, atom_node, 0, 1, lazy));
+    return mark(rep_node, start);
+  }
+  else if (scanner->get_type() == REPEAT) {
+    int lower = scanner->get_repeat_lower();
+    int upper = scanner->get_repeat_upper();
+    bool lazy = scanner->is_lazy();
+    scanner->advance();
+    ParseNode *rep_node = add_node(new ParseNode(REPEAT_NODE, atom_node, lower, upper, lazy));
+    return mark(rep_node, start);
   }
   else {
     return atom_node;
@@ -179,19 +201,20 @@ ParseNode *
 ParseTree::atom()
 {
   ParseNode *atom_node;
+  unsigned int start = scanner->get_start();
 
   // check for group
-  if (scanner.get_type() == LEFT_PAREN) {
+  if (scanner->get_type() == LEFT_PAREN) {
     atom_node = group();
   }
 
   // check for character set
-  else if (scanner.get_type() == LEFT_BRACKET) {
+  else if (scanner->get_type() == LEFT_BRACKET) {
     atom_node = char_set();
   }
 
   // check for character class
-  else if (scanner.get_type() == CHAR_CLASS) {
+  else if (scanner->get_type() == CHAR_CLASS) {
     atom_node = char_class();
   }
 
@@ -200,7 +223,17 @@ ParseTree::atom()
     atom_node = character();
   }
 
-  return atom_node;
+  return mark(atom_node, start);
+}
+
+ParseNode *
+ParseTree::mark(ParseNode *node, unsigned int start)
+{
+  if (node != NULL) {
+    node->regex_start = start;
+    node->regex_end = scanner->get_prev_end();
+  }
+  return node;
 }
 
 // group ::= '(' expr ')'
@@ -218,45 +251,45 @@ ParseTree::group()
   string name = "";
   int group_num = 0;
 
-  if (scanner.get_type() != LEFT_PAREN) {
+  if (scanner->get_type() != LEFT_PAREN) {
     stringstream s;
-    s << "ERROR: Parse error - expected '(' but received " << scanner.get_type_str();
+    s << "ERROR: Parse error - expected '(' but received " << scanner->get_type_str();
     throw EgretException(s.str());
   }
-  scanner.advance();
+  scanner->advance();
 
   if (false) {
   } else {
-    if (scanner.get_type() == NO_GROUP_EXT) {
+    if (scanner->get_type() == NO_GROUP_EXT) {
       group_num = -1;
-      scanner.advance();
+      scanner->advance();
     }
-    if (scanner.get_type() == NAMED_GROUP_EXT) {
-      name = scanner.get_name();
-      scanner.advance();
+    if (scanner->get_type() == NAMED_GROUP_EXT) {
+      name = scanner->get_name();
+      scanner->advance();
     }
-    if (scanner.get_type() == IGNORED_EXT) {
-      scanner.advance();
+    if (scanner->get_type() == IGNORED_EXT) {
+      scanner->advance();
       ignored_group = true;
     }
 
-    if (!ignored_group || scanner.get_type() != RIGHT_PAREN) {
+    if (!ignored_group || scanner->get_type() != RIGHT_PAREN) {
       left = expr();
     }
 
     if (ignored_group) {
-      group_node = new ParseNode(IGNORED_NODE, NULL, NULL);
+      group_node = add_node(new ParseNode(IGNORED_NODE, NULL, NULL));
     }
     else {
-      group_node = new ParseNode(GROUP_NODE, name, group_num, left, NULL);
+      group_node = add_node(new ParseNode(GROUP_NODE, name, group_num, left, NULL));
     }
 
-    if (scanner.get_type() != RIGHT_PAREN) {
+    if (scanner->get_type() != RIGHT_PAREN) {
       stringstream s;
-      s << "ERROR: Parse error - expected ')' but received " << scanner.get_type_str();
+      s << "ERROR: Parse error - expected ')' but received " << scanner->get_type_str();
       throw EgretException(s.str());
     }
-    scanner.advance();
+    scanner->advance();
   }
 
   return group_node;
@@ -273,38 +306,46 @@ ParseTree::character()
 {
   ParseNode *character_node;
 
-  if (scanner.get_type() == CHARACTER) {
-    char c = scanner.get_character();
-    scanner.advance();
-    character_node =  new ParseNode(CHARACTER_NODE, c);
+  if (scanner->get_type() == CHARACTER && scanner->get_code_point() >= 0x80) {
+    // characters outside ASCII are one-character sets so that they stay a
+    // single unit (several UTF-8 bytes) under repetition
+    CharSetItem char_set_item = character_item();
+    CharSet *char_set = add_char_set(new CharSet());
+    char_set->add_item(char_set_item);
+    return add_node(new ParseNode(CHAR_SET_NODE, char_set));
+  }
+  else if (scanner->get_type() == CHARACTER) {
+    char c = scanner->get_character();
+    scanner->advance();
+    character_node =  add_node(new ParseNode(CHARACTER_NODE, c));
   }
-  else if (scanner.get_type() == CARET) {
-    scanner.advance();
-    return new ParseNode(CARET_NODE, NULL, NULL);
+  else if (scanner->get_type() == CARET) {
+    scanner->advance();
+    return add_node(new ParseNode(CARET_NODE, NULL, NULL));
   }
-  else if (scanner.get_type() == DOLLAR) {
-    scanner.advance();
-    return new ParseNode(DOLLAR_NODE, NULL, NULL);
+  else if (scanner->get_type() == DOLLAR) {
+    scanner->advance();
+    return add_node(new ParseNode(DOLLAR_NODE, NULL, NULL));
   }
-  else if (scanner.get_type() == HYPHEN) {
-    scanner.advance();
-    character_node =  new ParseNode(CHARACTER_NODE, '-');
+  else if (scanner->get_type() == HYPHEN) {
+    scanner->advance();
+    character_node =  add_node(new ParseNode(CHARACTER_NODE, '-'));
   }
-  else if (scanner.get_type() == WORD_BOUNDARY) {
-    scanner.advance();
-    return new ParseNode(IGNORED_NODE, NULL, NULL);
+  else if (scanner->get_type() == WORD_BOUNDARY) {
+    scanner->advance();
+    return add_node(new ParseNode(IGNORED_NODE, NULL, NULL));
   }
-  else if (scanner.get_type() == BACKREFERENCE) {
-    character_node = new ParseNode(BACKREFERENCE_NODE, scanner.get_backref_value(), scanner.get_name());
-    scanner.advance();
+  else if (scanner->get_type() == BACKREFERENCE) {
+    character_node = add_node(new ParseNode(BACKREFERENCE_NODE, scanner->get_backref_value(), scanner->get_name()));
+    scanner->advance();
   }
   else {
     stringstream s;
-    s << "ERROR: Parse error - expected character type but received " << scanner.get_type_str();
+    s << "ERROR: Parse error - expected character type but received " << scanner->get_type_str();
     throw EgretException(s.str());
   }
 
-  if(scanner.get_type() != BACKREFERENCE) {
+  if (character_node->type != BACKREFERENCE_NODE) {
     char c = character_node->character;
     if (ispunct(c)) {
       if (punct_marks.find(c) == punct_marks.end()) {
@@ -321,17 +362,10 @@ ParseTree::character()
 ParseNode *
 ParseTree::char_class()
 {
-  char c = scanner.get_character();
-  scanner.advance();
-
-  CharSet *char_set = new CharSet();
+  CharSet *char_set = add_char_set(new CharSet());
+  char_set->add_item(char_class_item());
 
-  CharSetItem char_set_item;
-  char_set_item.type = CHAR_CLASS_ITEM;
-  char_set_item.character = c;
-  char_set->add_item(char_set_item);
-
-  ParseNode *char_set_node = new ParseNode(CHAR_SET_NODE, char_set);
+  ParseNode *char_set_node = add_node(new ParseNode(CHAR_SET_NODE, char_set));
   return char_set_node;
 }
 
@@ -344,27 +378,27 @@ ParseTree::char_set()
   ParseNode *char_set_node;
   bool is_complement = false;
 
-  if (scanner.get_type() != LEFT_BRACKET) {
+  if (scanner->get_type() != LEFT_BRACKET) {
     stringstream s;
-    s << "ERROR: Parse error - expected '[' but received " << scanner.get_type_str();
+    s << "ERROR: Parse error - expected '[' but received " << scanner->get_type_str();
     throw EgretException(s.str());
   }
-  scanner.advance();
+  scanner->advance();
 
-  if (scanner.get_type() == CARET) {
+  if (scanner->get_type() == CARET) {
     is_complement = true;
-    scanner.advance();
+    scanner->advance();
   }
 
   char_set_node = char_list();
   if (is_complement) char_set_node->char_set->set_complement(true);
 
-  if (scanner.get_type() != RIGHT_BRACKET) {
+  if (scanner->get_type() != RIGHT_BRACKET) {
     stringstream s;
-    s << "ERROR: Parse error - expected ']' but received " << scanner.get_type_str();
+    s << "ERROR: Parse error - expected ']' but received " << scanner->get_type_str();
     throw EgretException(s.str());
   }
-  scanner.advance();
+  scanner->advance();
 
   return char_set_node;
 }
@@ -379,8 +413,8 @@ ParseTree::char_list()
   ParseNode *char_set_node;
   
   // Check for end of list
-  if (scanner.get_type() == RIGHT_BRACKET) {
-    char_set_node = new ParseNode(CHAR_SET_NODE, new CharSet());
+  if (scanner->get_type() == RIGHT_BRACKET) {
+    char_set_node = add_node(new ParseNode(CHAR_SET_NODE, add_char_set(new CharSet())));
   }
   else {
     char_set_node = char_list();
@@ -398,10 +432,10 @@ ParseTree::char_list()
 CharSetItem
 ParseTree::list_item()
 {
-  if (scanner.is_char_range()) {
+  if (scanner->is_char_range()) {
     return char_range_item();
   }
-  else if (scanner.get_type() == CHAR_CLASS) {
+  else if (scanner->get_type() == CHAR_CLASS) {
     return char_class_item();
   }
   else {
@@ -420,26 +454,33 @@ ParseTree::character_item()
   CharSetItem char_set_item;
   char_set_item.type = CHARACTER_ITEM;
 
-  if (scanner.get_type() == CHARACTER) {
-    char c = scanner.get_character();
-    scanner.advance();
+  if (scanner->get_type() == CHARACTER && scanner->get_code_point() >= 0x80) {
+    char_set_item.type = CODE_POINT_ITEM;
+    char_set_item.cp_start = scanner->get_code_point();
+    char_set_item.cp_end = char_set_item.cp_start;
+    scanner->advance();
+    return char_set_item;
+  }
+  else if (scanner->get_type() == CHARACTER) {
+    char c = scanner->get_character();
+    scanner->advance();
     char_set_item.character = c;
   }
-  else if (scanner.get_type() == CARET) {
-    scanner.advance();
+  else if (scanner->get_type() == CARET) {
+    scanner->advance();
     char_set_item.character = '^';
   }
-  else if (scanner.get_type() == DOLLAR) {
-    scanner.advance();
+  else if (scanner->get_type() == DOLLAR) {
+    scanner->advance();
     char_set_item.character = '$';
   }
-  else if (scanner.get_type() == HYPHEN) {
-    scanner.advance();
+  else if (scanner->get_type() == HYPHEN) {
+    scanner->advance();
     char_set_item.character = '-';
   }
   else {
     stringstream s;
-    s << "ERROR: Parse error - expected character type but received " << scanner.get_type_str();
+    s << "ERROR: Parse error - expected character type but received " << scanner->get_type_str();
     throw EgretException(s.str());
   }
   char c = char_set_item.character;
@@ -458,8 +499,12 @@ ParseTree::char_class_item()
 {
   CharSetItem char_set_item;
   char_set_item.type = CHAR_CLASS_ITEM;
-  char_set_item.character = scanner.get_character();
-  scanner.advance();
+  char_set_item.character = scanner->get_character();
+  if (char_set_item.character == 'p' || char_set_item.character == 'P') {
+    char_set_item.type = PROPERTY_ITEM;
+    char_set_item.property = scanner->get_name();
+  }
+  scanner->advance();
   return char_set_item;
 }
 
@@ -471,28 +516,38 @@ ParseTree::char_range_item()
   CharSetItem char_set_item;
   char_set_item.type = CHAR_RANGE_ITEM;
 
-  if (scanner.get_type() != CHARACTER) {
+  if (scanner->get_type() != CHARACTER) {
     stringstream s;
-    s << "ERROR: Parse error - expected character type but received " << scanner.get_type_str();
+    s << "ERROR: Parse error - expected character type but received " << scanner->get_type_str();
     throw EgretException(s.str());
   }
-  char start = scanner.get_character();
-  scanner.advance();
+  char start = scanner->get_character();
+  unsigned int cp_start = scanner->get_code_point();
+  scanner->advance();
 
-  if (scanner.get_type() != HYPHEN) {
+  if (scanner->get_type() != HYPHEN) {
     stringstream s;
-    s << "ERROR: Parse error - expected hyphen but received " << scanner.get_type_str();
+    s << "ERROR: Parse error - expected hyphen but received " << scanner->get_type_str();
     throw EgretException(s.str());
   }
-  scanner.advance();
+  scanner->advance();
 
-  if (scanner.get_type() != CHARACTER) {
+  if (scanner->get_type() != CHARACTER) {
     stringstream s;
-    s << "ERROR: Parse error - expected character type but received " << scanner.get_type_str();
+    s << "ERROR: Parse error - expected character type but received " << scanner->get_type_str();
     throw EgretException(s.str());
   }
-  char end = scanner.get_character();
-  scanner.advance();
+  char end = scanner->get_character();
+  unsigned int cp_end = scanner->get_code_point();
+  scanner->advance();
+
+  // ranges that go outside ASCII are code point ranges
+  if (cp_end >= 0x80) {
+    char_set_item.type = CODE_POINT_ITEM;
+    char_set_item.cp_start = cp_start;
+    char_set_item.cp_end = cp_end;
+    return char_set_item;
+  }
 
   bool good_range = false;
   if (start >= 'a' && end <= 'z') good_range = true;
@@ -606,6 +661,15 @@ int ParseTree::count_g(ParseNode *node, unsigned offset, int count)
   return count;
 }
 
+void
+ParseTree::prepare_char_sets()
+{
+  vector <CharSet *>::iterator it;
+  for (it = char_sets.begin(); it != char_sets.end(); it++) {
+    (*it)->prepare(punct_marks);
+  }
+}
+
 void
 ParseTree::add_stats(Stats &stats)
 {
@@ -622,6 +686,13 @@ ParseTree::add_stats(Stats &stats)
   stats.add("PARSE_TREE", "Character set nodes (not ^)", tree_stats.normal_char_set_nodes);
   stats.add("PARSE_TREE", "Character set nodes (^)", tree_stats.complement_char_set_nodes);
   stats.add("PARSE_TREE", "Ignored nodes", tree_stats.ignored_nodes);
+
+  long nodes = tree_stats.alternation_nodes + tree_stats.concat_nodes + tree_stats.repeat_nodes
+    + tree_stats.group_nodes + tree_stats.backreference_nodes + tree_stats.caret_nodes
+    + tree_stats.dollar_nodes + tree_stats.character_nodes + tree_stats.normal_char_set_nodes
+    + tree_stats.complement_char_set_nodes + tree_stats.ignored_nodes;
+  long char_sets = tree_stats.normal_char_set_nodes + tree_stats.complement_char_set_nodes;
+  stats.add("PARSE_TREE", "Node bytes", nodes * sizeof(ParseNode) + char_sets * sizeof(CharSet));
 }
 
 void
@@ -87,6 +87,7 @@
 #include <unordered_map>
 #include "Scanner.h"
 #include "CharSet.h"
+#include "Deadline.h"
 #include "Stats.h"
 using namespace std;
 
@@ -108,6 +109,8 @@ struct ParseNode
 {
   ParseNode(NodeType t, ParseNode *l, ParseNode *r) {
     type = t;
+    regex_start = 0;
+    regex_end = 0;
     left = l;
     right = r;
     char_set = NULL;
@@ -116,6 +119,8 @@ struct ParseNode
   ParseNode(NodeType t, string _name, int _num, ParseNode *l, ParseNode *r) {
     assert(t == GROUP_NODE);
     type = t;
+    regex_start = 0;
+    regex_end = 0;
     name = _name;
     group_num = _num;
     left = l;
@@ -126,6 +131,8 @@ struct ParseNode
   ParseNode(NodeType t, CharSet *c) {
     assert(t == CHAR_SET_NODE);
     type = t;
+    regex_start = 0;
+    regex_end = 0;
     left = NULL;
     right = NULL;
     char_set = c;
@@ -134,6 +141,8 @@ struct ParseNode
   ParseNode(NodeType t, char c) {
     assert(t == CHARACTER_NODE);
     type = t;
+    regex_start = 0;
+    regex_end = 0;
     left = NULL;
     right = NULL;
     char_set = NULL;
@@ -143,6 +152,8 @@ struct ParseNode
   ParseNode(NodeType t, int _backref_value, string _name) {
     assert(t == BACKREFERENCE_NODE);
     type = t;
+    regex_start = 0;
+    regex_end = 0;
     left = NULL;
     right = NULL;
     backref_value = _backref_value;
@@ -150,14 +161,17 @@ struct ParseNode
     backref_id = 0;
   }
 
-  ParseNode(NodeType t, ParseNode *l, int lower, int upper) {
+  ParseNode(NodeType t, ParseNode *l, int lower, int upper, bool _lazy = false) {
     assert(t == REPEAT_NODE);
     type = t;
+    regex_start = 0;
+    regex_end = 0;
     left = l;
     right = NULL;
     char_set = NULL;
     repeat_lower = lower;
     repeat_upper = upper;
+    lazy = _lazy;
   }
 
   NodeType type;
@@ -167,24 +181,35 @@ struct ParseNode
   char character;	// For CHARACTER_NODE
   int repeat_lower;	// For REPEAT_NODE
   int repeat_upper;	// For REPEAT_NODE (-1 for no limit)
+  bool lazy;		// For REPEAT_NODE (set if the fewest repetitions are tried first)
   int backref_value;  // For BACKREFERENCE_NODE
   int backref_id;  // For BACKREFERENCE_NODE
   int group_num;  // For BACKREFERENCE_NODE and GROUP_NODE
   string name;  // For BACKREFERENCE_NODE
+  unsigned int regex_start;	// start of the part of the regex the node was built from
+  unsigned int regex_end;	// end of that part (same as the start if unknown)
 };
 
 class ParseTree {
 
 public:
 
-  // build parse tree using regex stored in scanner
-  void build(Scanner &_scanner);
+  ParseTree() { root = NULL; scanner = NULL; deadline = NULL; }
+  ~ParseTree();
+
+  // build parse tree using regex stored in scanner (the scanner is advanced
+  // through its tokens rather than copied)
+  void build(Scanner &_scanner, Deadline *_deadline = NULL);
 
   // get root of the tree
   ParseNode *get_root() { return root; }
 
   // get set of punctuation marks
-  set<char> get_punct_marks() { return punct_marks; }
+  const set<char> &get_punct_marks() { return punct_marks; }
+
+  // computes the cached parts of every character set, after which runs
+  // on the tree only read it (see CharSet::prepare)
+  void prepare_char_sets();
 
   // prints the tree
   void print();
@@ -195,11 +220,26 @@ public:
 private:
 
   ParseNode *root;		// root of parse tree
-  Scanner scanner;		// scanner
+  Scanner *scanner;		// scanner (only used while building)
+  Deadline *deadline;		// deadline for building the tree (NULL if none)
+  vector <ParseNode *> nodes;	// all nodes allocated for the tree
+  vector <CharSet *> char_sets;	// all character sets allocated for the tree
   set<char> punct_marks;	// set of punctuation marks
   unordered_map<string, int> group_names {};  // set of group names and corresponding group numbers
   int backreference_count; // number of backreferences encountered
 
+  // the tree owns its nodes and character sets
+  ParseTree(const ParseTree &other);
+  ParseTree &operator= (const ParseTree &other);
+
+  // record allocations so they can be released with the tree
+  ParseNode *add_node(ParseNode *node) { nodes.push_back(node); return node; }
+  CharSet *add_char_set(CharSet *char_set) { char_sets.push_back(char_set); return char_set; }
+
+  // records the part of the regex from start to the previous token as
+  // the source of the node
+  ParseNode *mark(ParseNode *node, unsigned int start);
+
   // creation functions
   ParseNode *expr();
   ParseNode *concat();
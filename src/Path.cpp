@@ -19,6 +19,7 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <map>
 #include <set>
 #include <sstream>
 #include <string>
@@ -44,35 +45,73 @@ Path::remove_last()
   states.pop_back();
 }
 
-void
-Path::mark_path_visited(bool *visited)
-{
-  vector <unsigned int>::iterator it;
-  for (it = states.begin(); it != states.end(); it++) {
-    visited[*it] = true;
-  }
-}
-
 StringPath
-Path::gen_initial_string(StringPath base_substring)
+Path::gen_initial_string(const StringPath &base_substring, EdgeRecords &records)
 {
+  vector <unsigned int> loop_starts;	// path string length when each open loop began
+
   path_string.clear();
   for (unsigned int i = 0; i < edges.size(); i++) {
-    bool process_edge = edges[i]->process_edge_in_path(path_string, base_substring);
-    if (process_edge) {
+    // only the first path to visit an edge uses it for evil strings
+    EdgeType type = edges[i]->getType();
+    bool first = edges[i]->is_evil_edge() && records.first.find(edges[i]) == records.first.end();
+
+    // the prefix is only copied out of the path string for a recorded visit
+    EdgeVisit visit;
+    unsigned int prefix_length = path_string.path.size();
+    switch (type) {
+      case BEGIN_LOOP_EDGE:
+        loop_starts.push_back(path_string.path.size());
+        break;
+      case END_LOOP_EDGE:
+        // the loop iteration is everything added since the loop began
+        prefix_length = 0;
+        if (!loop_starts.empty()) {
+          prefix_length = loop_starts.back();
+          loop_starts.pop_back();
+        }
+        visit.substring.path.assign(path_string.path.begin() + prefix_length,
+                                    path_string.path.end());
+        break;
+      case STRING_EDGE:
+        if (first) visit.substring = base_substring;
+        break;
+      default:
+        ;
+    }
+    if (first) {
+      visit.prefix.path.assign(path_string.path.begin(),
+                               path_string.path.begin() + prefix_length);
+    }
+
+    if (type == STRING_EDGE) {
+      path_string.add_path(base_substring);
+    }
+    else {
+      path_string.add_path(edges[i]->get_substring(visit));
+    }
+    if (first) {
+      records.first[edges[i]] = move(visit);
       evil_edges.push_back(i);
     }
-    path_string.add_path(edges[i]->get_substring());
+    else if (type == END_LOOP_EDGE) {
+      records.last[edges[i]] = move(visit);
+    }
   }
   return path_string;
 }
 
 StringPath
-Path::gen_min_iter_string()
+Path::gen_min_iter_string(const EdgeRecords &records)
 {
+  static const EdgeVisit none;
   StringPath min_iter_string;
   for (unsigned int i = 0; i < edges.size(); i++) {
-    edges[i]->process_min_iter_string(&min_iter_string);
+    map <Edge *, EdgeVisit>::const_iterator first = records.first.find(edges[i]);
+    map <Edge *, EdgeVisit>::const_iterator last = records.last.find(edges[i]);
+    const EdgeVisit &first_visit = first == records.first.end() ? none : first->second;
+    edges[i]->process_min_iter_string(&min_iter_string, first_visit,
+                                      last == records.last.end() ? first_visit : last->second);
   }
   return min_iter_string;
 }
@@ -94,7 +133,7 @@ Path::has_leading_caret()
 bool
 Path::has_trailing_dollar()
 {
-  for (unsigned int i = edges.size() - 1; i > 0; i--) {
+  for (unsigned int i = edges.size(); i-- > 0; ) {
     if (edges[i]->getType() == DOLLAR_EDGE) {
       return true;
     }
@@ -176,23 +215,30 @@ Path::check_anchor_middle()
   }
 }
 
-set <StringPath, spcompare>
-Path::gen_evil_strings(const set <char> &punct_marks)
+vector <StringPath>
+Path::gen_evil_strings(const EdgeRecords &records, const set <char> &punct_marks)
 {
-  set <StringPath, spcompare> evil_strings;
+  // string where each repeat quantifier is zero (if allowed)
+  StringPath min_iter_string = gen_min_iter_string(records);
 
-  // add string where each repeat quantifier is zero (if allowed)
-  evil_strings.insert(gen_min_iter_string());
-  // add strings for interesting edges (char sets, strings, and loops)
+  // strings for interesting edges (char sets, strings, and loops)
+  vector <vector <StringPath> > edge_strings(evil_edges.size());
   for (unsigned int i = 0; i < evil_edges.size(); i++) {
     int index = evil_edges[i];
-    set <StringPath, spcompare> new_strings = edges[index]->gen_evil_strings(path_string, punct_marks);
-    set <StringPath, spcompare>::iterator si;
-    for(si = new_strings.begin(); si != new_strings.end(); si++) {
-      StringPath s = *si;
-      evil_strings.insert(s);
+    const EdgeVisit &visit = records.first.at(edges[index]);
+    edge_strings[i] = edges[index]->gen_evil_strings(visit, path_string, punct_marks);
+  }
+
+  // the strings of the last edge are output first, the minimum iteration
+  // string last
+  vector <StringPath> evil_strings;
+  for (unsigned int i = edge_strings.size(); i-- > 0; ) {
+    vector <StringPath>::iterator si;
+    for(si = edge_strings[i].begin(); si != edge_strings[i].end(); si++) {
+      evil_strings.push_back(move(*si));
     }
   }
+  evil_strings.push_back(move(min_iter_string));
   return evil_strings;
 }
 
@@ -229,6 +275,13 @@ Path::check_for_duplicate_character_sets()
   return found_duplicate;
 }
 
+unsigned long
+Path::get_memory() const
+{
+  return states.capacity() * sizeof(unsigned int) + edges.capacity() * sizeof(Edge *)
+    + evil_edges.capacity() * sizeof(unsigned int) + path_string.get_memory();
+}
+
 void
 Path::print()
 {
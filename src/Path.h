@@ -22,6 +22,7 @@
 #ifndef PATH_H
 #define PATH_H
 
+#include <map>
 #include <set>
 #include <string>
 #include <vector>
@@ -29,6 +30,15 @@
 #include "StringPath.h"
 using namespace std;
 
+// Edge visits recorded as the initial strings are generated, one path at a
+// time.  The first path to visit an edge generates its evil strings.  Once
+// the initial strings are done the records are only read, so evil strings
+// for different paths can be generated at the same time.
+struct EdgeRecords {
+  map <Edge *, EdgeVisit> first;	// first visit to each evil edge
+  map <Edge *, EdgeVisit> last;		// most recent later visit to each loop end (substring only)
+};
+
 class Path {
 
 public:
@@ -42,14 +52,14 @@ public:
   // removes the last edge and state
   void remove_last();
 
-  // marks the states in the path as visited
-  void mark_path_visited(bool *visited);
+  // returns the states in the path
+  const vector <unsigned int> &get_states() { return states; }
 
-  // generates the initial test string for the path
-  StringPath gen_initial_string(StringPath base_substring);
+  // generates the initial test string for the path, recording the edge visits
+  StringPath gen_initial_string(const StringPath &base_substring, EdgeRecords &records);
 
   // generates a string with minimum iterations for repeating constructs
-  StringPath gen_min_iter_string();
+  StringPath gen_min_iter_string(const EdgeRecords &records);
 
   // returns true if path has a leading caret
   bool has_leading_caret();
@@ -61,11 +71,15 @@ public:
   // middle of the path, returns an empty string otherwise
   string check_anchor_middle();
 
-  // generates evil strings for the path
-  set <StringPath, spcompare> gen_evil_strings(const set <char> &punct_marks);
+  // generates evil strings for the path in the order they are output (does
+  // not change the path or records)
+  vector <StringPath> gen_evil_strings(const EdgeRecords &records, const set <char> &punct_marks);
 
   bool check_for_duplicate_character_sets();
 
+  // returns the bytes held by the path (beyond the Path itself)
+  unsigned long get_memory() const;
+
   void print();
 
 private:
@@ -0,0 +1,45 @@
+/*  PathStrategy.h: strategies for choosing paths through the NFA
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PATH_STRATEGY_H
+#define PATH_STRATEGY_H
+
+#include <string>
+using namespace std;
+
+// how paths through the NFA are chosen
+typedef enum {
+  BASIS_PATHS,			// depth first traversal (stops at visited states)
+  EDGE_COVER_PATHS		// small set of paths that covers every edge
+} PathStrategy;
+
+// gets the strategy with the given name (basis or cover), returns false if
+// there is no such strategy
+inline bool
+parse_path_strategy(const string &name, PathStrategy &strategy)
+{
+  if (name == "basis") strategy = BASIS_PATHS;
+  else if (name == "cover") strategy = EDGE_COVER_PATHS;
+  else return false;
+  return true;
+}
+
+#endif // PATH_STRATEGY_H
@@ -0,0 +1,988 @@
+/*  Redos.cpp: finds regexes that make a backtracking matcher slow
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "CharSet.h"
+#include "Edge.h"
+#include "NFA.h"
+#include "Redos.h"
+#include "error.h"
+using namespace std;
+
+static unsigned int find_components(const vector <vector <unsigned int> > &adj,
+                                    vector <unsigned int> &comp);
+static bool pick_char(const CharBitmap &chars, char &c);
+static bool pick_suffix_char(unsigned int i, char &c);
+static CharBitmap ascii_chars(CharSet *char_set);
+static string quote(const string &s);
+static bool out_of_time(Deadline *deadline);
+
+void
+RedosAnalyzer::analyze(NFA &nfa, Deadline *deadline)
+{
+  build(nfa, deadline);
+  if (gave_up || out_of_time(deadline)) return;
+
+  // find the components and the ones with a cycle
+  vector <vector <unsigned int> > adj(accepting.size());
+  for (unsigned int i = 0; i < transitions.size(); i++) {
+    adj[transitions[i].from].push_back(transitions[i].to);
+  }
+  unsigned int count = find_components(adj, component);
+  members.assign(count, vector <unsigned int>());
+  cyclic.assign(count, false);
+  exponential.assign(count, false);
+  for (unsigned int s = 0; s < component.size(); s++) {
+    members[component[s]].push_back(s);
+  }
+  for (unsigned int i = 0; i < transitions.size(); i++) {
+    if (component[transitions[i].from] == component[transitions[i].to]) {
+      cyclic[component[transitions[i].from]] = true;
+    }
+  }
+
+  // exponential ambiguity within each component
+  for (unsigned int c = 0; c < count && !gave_up; c++) {
+    if (out_of_time(deadline)) return;
+    if (cyclic[c]) find_exponential(c, deadline);
+  }
+
+  // polynomial ambiguity between two components, a component can reach
+  // only later components (they are in topological order)
+  struct Link {
+    unsigned int to;		// component reached
+    unsigned int state;		// state the pump starts from
+    unsigned int end;		// state the pump leads to (in the component reached)
+    string pump;		// pump
+  };
+  vector <vector <Link> > links(count);
+  vector <bool> linked_to(count, false);
+  vector <bool> reaches(count);
+  for (unsigned int c1 = 0; c1 < count && !gave_up; c1++) {
+    if (!cyclic[c1] || exponential[c1]) continue;
+
+    // the components reached from this one (a search of the states, so
+    // the work is linear in the size of the automaton)
+    fill(reaches.begin(), reaches.end(), false);
+    vector <bool> seen(accepting.size(), false);
+    vector <unsigned int> todo(members[c1]);
+    for (unsigned int i = 0; i < todo.size(); i++) seen[todo[i]] = true;
+    while (!todo.empty()) {
+      unsigned int state = todo.back();
+      todo.pop_back();
+      reaches[component[state]] = true;
+      if (!count_work(out[state].size() + 1)) return;
+      vector <unsigned int>::iterator t;
+      for (t = out[state].begin(); t != out[state].end(); t++) {
+        if (seen[transitions[*t].to]) continue;
+        seen[transitions[*t].to] = true;
+        todo.push_back(transitions[*t].to);
+      }
+    }
+
+    for (unsigned int c2 = c1 + 1; c2 < count && !gave_up; c2++) {
+      if (!cyclic[c2] || exponential[c2] || !reaches[c2]) continue;
+      if (out_of_time(deadline)) return;
+      Link link;
+      if (find_polynomial(c1, c2, link.state, link.end, link.pump, deadline)) {
+        link.to = c2;
+        links[c1].push_back(link);
+        linked_to[c2] = true;
+      }
+    }
+  }
+
+  // the degree for a component is the longest chain of linked loops that
+  // starts there, a finding is made where a chain starts
+  vector <unsigned int> degree(count, 1);
+  vector <int> best(count, -1);
+  for (unsigned int c = count; c-- > 0; ) {
+    for (unsigned int i = 0; i < links[c].size(); i++) {
+      if (degree[links[c][i].to] + 1 > degree[c]) {
+        degree[c] = degree[links[c][i].to] + 1;
+        best[c] = i;
+      }
+    }
+  }
+  for (unsigned int c = 0; c < count; c++) {
+    if (best[c] < 0 || linked_to[c]) continue;
+    const Link &first = links[c][best[c]];
+    RedosFinding finding;
+    finding.kind = POLYNOMIAL_REDOS;
+    finding.prefix = find_string(start, first.state);
+
+    // a pump of one link only takes its two loops together, so the pumps
+    // along the chain are joined (with the strings from where each one ends
+    // to where the next starts), the join that reaches the highest degree
+    // is kept (the shortest if several do)
+    string chain = first.pump;
+    finding.degree = 0;
+    for (const Link *link = &first; ; ) {
+      unsigned int reached = min(pump_degree(finding.prefix, chain), degree[c]);
+      if (reached > finding.degree) {
+        finding.degree = reached;
+        finding.pump = chain;
+      }
+      if (best[link->to] < 0 || gave_up) break;
+      const Link &next = links[link->to][best[link->to]];
+      chain += find_string(link->end, next.state) + next.pump;
+      link = &next;
+    }
+    if (finding.degree > 1 && find_suffix(finding.prefix, finding.pump, finding.suffix)) {
+      findings.push_back(finding);
+    }
+  }
+
+  // the copies of a loop body give the same finding more than once
+  vector <RedosFinding> unique;
+  for (unsigned int i = 0; i < findings.size(); i++) {
+    bool same = false;
+    for (unsigned int j = 0; j < unique.size() && !same; j++) {
+      same = findings[i].kind == unique[j].kind && findings[i].degree == unique[j].degree
+        && findings[i].pump == unique[j].pump;
+    }
+    if (!same) unique.push_back(findings[i]);
+  }
+  findings.swap(unique);
+}
+
+void
+RedosAnalyzer::build(NFA &nfa, Deadline *deadline)
+{
+  // find the edges that begin and end each loop
+  Graph g;
+  for (unsigned int from = 0; from < nfa.size; from++) {
+    for (unsigned int to = 0; to < nfa.size; to++) {
+      Edge *edge = nfa.edge_table[from][to];
+      if (edge == NULL) continue;
+      if (edge->getType() == BEGIN_LOOP_EDGE)
+        g.loop_begin[edge->get_regex_loop()] = make_pair(from, to);
+      else if (edge->getType() == END_LOOP_EDGE)
+        g.loop_end[edge->get_regex_loop()] = make_pair(from, to);
+    }
+  }
+
+  unsigned int first, last;
+  if (!copy_part(nfa, g, nfa.initial, nfa.final, first, last)) return;
+  unsigned int size = g.epsilon.size();
+  vector <vector <unsigned int> > &epsilon = g.epsilon;
+  vector <Transition> &char_edges = g.char_edges;
+  vector <vector <unsigned int> > &char_out = g.char_out;
+
+  // the states kept are the initial state and the targets of character edges
+  vector <int> index(size, -1);
+  vector <unsigned int> kept;
+  index[first] = 0;
+  kept.push_back(first);
+  for (unsigned int i = 0; i < char_edges.size(); i++) {
+    if (index[char_edges[i].to] < 0) {
+      index[char_edges[i].to] = kept.size();
+      kept.push_back(char_edges[i].to);
+    }
+  }
+  start = 0;
+  accepting.assign(kept.size(), false);
+  out.assign(kept.size(), vector <unsigned int>());
+
+  // remove the epsilon edges, counting the simple epsilon paths from each
+  // kept state to each state (a state is expanded the first two times it
+  // is reached, which is enough to tell one path from more than one), only
+  // the states reached are visited and reset
+  struct Frame {
+    unsigned int state;
+    unsigned int next;
+  };
+  vector <unsigned int> paths(size, 0);
+  vector <bool> on_path(size, false);
+  vector <unsigned int> reached;
+  vector <Frame> stack;
+  for (unsigned int k = 0; k < kept.size(); k++) {
+    if (out_of_time(deadline)) return;
+    for (unsigned int i = 0; i < reached.size(); i++) paths[reached[i]] = 0;
+    reached.clear();
+    Frame first = { kept[k], 0 };
+    stack.push_back(first);
+    on_path[kept[k]] = true;
+    paths[kept[k]] = 1;
+    reached.push_back(kept[k]);
+    while (!stack.empty()) {
+      Frame &f = stack.back();
+      if (f.next == epsilon[f.state].size()) {
+        on_path[f.state] = false;
+        stack.pop_back();
+        continue;
+      }
+      unsigned int next = epsilon[f.state][f.next++];
+      if (on_path[next]) continue;
+      if (!count_work()) return;
+      if (paths[next] == 0) reached.push_back(next);
+      if (paths[next] < 3) paths[next]++;
+      if (paths[next] > 2) continue;
+      on_path[next] = true;
+      Frame frame = { next, 0 };
+      stack.push_back(frame);
+    }
+
+    accepting[k] = paths[last] > 0;
+    sort(reached.begin(), reached.end());
+    for (unsigned int i = 0; i < reached.size(); i++) {
+      unsigned int s = reached[i];
+      if (!count_work(char_out[s].size() + 1)) return;
+      vector <unsigned int>::iterator it;
+      for (it = char_out[s].begin(); it != char_out[s].end(); it++) {
+        Transition t = char_edges[*it];
+        t.from = k;
+        t.to = index[t.to];
+        t.count = min(paths[s], 2U);
+        out[k].push_back(transitions.size());
+        transitions.push_back(t);
+      }
+    }
+  }
+
+  merge_states(deadline);
+}
+
+unsigned int
+RedosAnalyzer::Graph::add_state()
+{
+  epsilon.push_back(vector <unsigned int>());
+  char_out.push_back(vector <unsigned int>());
+  return epsilon.size() - 1;
+}
+
+void
+RedosAnalyzer::Graph::add_char_edge(unsigned int from, unsigned int to, const CharBitmap &chars)
+{
+  Transition t;
+  t.from = from;
+  t.to = to;
+  t.chars = chars;
+  t.count = 1;
+  char_out[from].push_back(char_edges.size());
+  char_edges.push_back(t);
+}
+
+bool
+RedosAnalyzer::copy_part(NFA &nfa, Graph &g, unsigned int first, unsigned int last,
+                         unsigned int &copy_first, unsigned int &copy_last)
+{
+  if (!count_work(last - first + 1)) return false;
+  if (g.epsilon.size() + last - first + 1 > REDOS_MAX_STATES) {
+    gave_up = true;
+    return false;
+  }
+  vector <unsigned int> copy(last - first + 1);
+  for (unsigned int s = first; s <= last; s++) {
+    copy[s - first] = g.add_state();
+  }
+  copy_first = copy[0];
+  copy_last = copy[last - first];
+
+  // the edges from the last state leave the part
+  unsigned int s = first;
+  while (s < last) {
+    unsigned int next = s + 1;
+    for (unsigned int to = first; to <= last; to++) {
+      Edge *edge = nfa.edge_table[s][to];
+      if (edge == NULL) continue;
+      if (!count_work()) return false;
+
+      switch (edge->getType()) {
+      case CHARACTER_EDGE:
+      {
+        CharBitmap chars;
+        chars.add(edge->get_character());
+        g.add_char_edge(copy[s - first], copy[to - first], chars);
+        break;
+      }
+      case CHAR_SET_EDGE:
+        g.add_char_edge(copy[s - first], copy[to - first], ascii_chars(edge->get_char_set()));
+        break;
+      case STRING_EDGE:
+      {
+        // a string gets a state of its own with an edge back to itself
+        RegexString *regex_str = edge->get_regex_string();
+        CharBitmap chars = ascii_chars(regex_str->get_char_set());
+        unsigned int middle = g.add_state();
+        g.add_char_edge(copy[s - first], middle, chars);
+        g.add_char_edge(middle, middle, chars);
+        g.epsilon[middle].push_back(copy[to - first]);
+        if (regex_str->get_lower() == 0) g.epsilon[copy[s - first]].push_back(copy[to - first]);
+        break;
+      }
+      case BEGIN_LOOP_EDGE:
+      {
+        // the loop body is the states from the begin edge to the end edge
+        RegexLoop *loop = edge->get_regex_loop();
+        pair <unsigned int, unsigned int> end = g.loop_end[loop];
+        if (!copy_loop(nfa, g, loop, to, end.first, copy[s - first], copy[end.second - first]))
+          return false;
+        next = end.second;
+        break;
+      }
+      default:
+        g.epsilon[copy[s - first]].push_back(copy[to - first]);
+        break;
+      }
+    }
+    s = next;
+  }
+  return true;
+}
+
+bool
+RedosAnalyzer::copy_loop(NFA &nfa, Graph &g, RegexLoop *loop, unsigned int first,
+                         unsigned int last, unsigned int from, unsigned int to)
+{
+  int lower = min(loop->get_lower(), REDOS_MAX_COPIES);
+  int upper = loop->get_upper();
+  bool unbounded = upper == -1 || upper > REDOS_MAX_COPIES;
+  unsigned int curr = from;
+  unsigned int body_first, body_last;
+
+  // the iterations that are needed
+  for (int i = 0; i < lower; i++) {
+    if (!copy_part(nfa, g, first, last, body_first, body_last)) return false;
+    g.epsilon[curr].push_back(body_first);
+    curr = body_last;
+  }
+
+  // an unbounded loop repeats its last iteration (adding one if there
+  // were none), a bounded one has optional iterations
+  if (unbounded) {
+    if (lower == 0) {
+      if (!copy_part(nfa, g, first, last, body_first, body_last)) return false;
+      g.epsilon[curr].push_back(body_first);
+      g.epsilon[curr].push_back(to);
+      curr = body_last;
+    }
+    g.epsilon[curr].push_back(body_first);
+  }
+  else {
+    for (int i = lower; i < upper; i++) {
+      if (!copy_part(nfa, g, first, last, body_first, body_last)) return false;
+      g.epsilon[curr].push_back(body_first);
+      g.epsilon[curr].push_back(to);
+      curr = body_last;
+    }
+  }
+  g.epsilon[curr].push_back(to);
+  return true;
+}
+
+void
+RedosAnalyzer::merge_states(Deadline *deadline)
+{
+  vector <bool> gone(out.size(), false);
+  bool merged = true;
+  while (merged) {
+    if (out_of_time(deadline)) return;
+    if (!count_work(out.size() + transitions.size())) return;
+    merged = false;
+
+    // the signature of a state is whether it accepts and its edges
+    map <string, unsigned int> first_with;
+    vector <unsigned int> rep(out.size());
+    for (unsigned int s = 0; s < out.size(); s++) {
+      rep[s] = s;
+      if (gone[s]) continue;
+      vector <string> keys;
+      for (unsigned int i = 0; i < out[s].size(); i++) {
+        const Transition &t = transitions[out[s][i]];
+        stringstream key;
+        key << t.to << ':' << t.count;
+        for (unsigned int w = 0; w < 4; w++) key << ':' << t.chars.get_words()[w];
+        keys.push_back(key.str());
+      }
+      sort(keys.begin(), keys.end());
+      string signature = accepting[s] ? "A" : "N";
+      for (unsigned int i = 0; i < keys.size(); i++) signature += "," + keys[i];
+      if (!count_work(keys.size() + 1)) return;
+
+      map <string, unsigned int>::iterator same = first_with.find(signature);
+      if (same == first_with.end() || s == start) {
+        first_with.insert(make_pair(signature, s));
+      }
+      else {
+        rep[s] = same->second;
+        out[s].clear();
+        gone[s] = true;
+        merged = true;
+      }
+    }
+    for (unsigned int i = 0; i < transitions.size(); i++) {
+      transitions[i].to = rep[transitions[i].to];
+    }
+  }
+}
+
+void
+RedosAnalyzer::find_exponential(unsigned int comp, Deadline *deadline)
+{
+  // number the pairs of states in the component
+  const vector <unsigned int> &states = members[comp];
+  unsigned int n = states.size();
+  if (!count_work((unsigned long) n * n)) return;
+  map <unsigned int, unsigned int> local;
+  for (unsigned int i = 0; i < n; i++) local[states[i]] = i;
+
+  // edges of the product within the component, an edge is ambiguous if it
+  // takes two different edges, or one edge reached along two paths
+  struct PairEdge {
+    unsigned int from;
+    unsigned int to;
+    char c;
+    bool ambiguous;
+  };
+  vector <PairEdge> edges;
+  vector <vector <unsigned int> > adj(n * n);
+  for (unsigned int a = 0; a < n; a++) {
+    if (out_of_time(deadline)) return;
+    for (unsigned int b = 0; b < n; b++) {
+      vector <unsigned int>::iterator t1, t2;
+      for (t1 = out[states[a]].begin(); t1 != out[states[a]].end(); t1++) {
+        if (component[transitions[*t1].to] != comp) continue;
+        for (t2 = out[states[b]].begin(); t2 != out[states[b]].end(); t2++) {
+          if (component[transitions[*t2].to] != comp) continue;
+          if (!count_work()) return;
+          PairEdge e;
+          if (!pick_char(transitions[*t1].chars.intersection(transitions[*t2].chars), e.c))
+            continue;
+          e.from = a * n + b;
+          e.to = local[transitions[*t1].to] * n + local[transitions[*t2].to];
+          e.ambiguous = *t1 != *t2 || transitions[*t1].count > 1;
+          adj[e.from].push_back(edges.size());
+          edges.push_back(e);
+        }
+      }
+    }
+  }
+
+  // an ambiguous edge inside a product component with a pair (q, q)
+  vector <vector <unsigned int> > next(n * n);
+  for (unsigned int i = 0; i < edges.size(); i++) {
+    next[edges[i].from].push_back(edges[i].to);
+  }
+  vector <unsigned int> pair_comp;
+  find_components(next, pair_comp);
+  vector <bool> has_diagonal(n * n, false);
+  for (unsigned int q = 0; q < n; q++) {
+    has_diagonal[pair_comp[q * n + q]] = true;
+  }
+
+  // returns the shortest string within the product component from a pair
+  // to a pair that satisfies done, and sets end to that pair
+  auto walk = [&](unsigned int from, function <bool (unsigned int)> done, unsigned int &end) {
+    vector <int> via(n * n, -1);
+    vector <bool> seen(n * n, false);
+    vector <unsigned int> queue(1, from);
+    seen[from] = true;
+    end = from;
+    for (unsigned int i = 0; !done(end); end = queue[++i]) {
+      vector <unsigned int>::iterator e;
+      for (e = adj[queue[i]].begin(); e != adj[queue[i]].end(); e++) {
+        unsigned int to = edges[*e].to;
+        if (seen[to] || pair_comp[to] != pair_comp[from]) continue;
+        seen[to] = true;
+        via[to] = *e;
+        queue.push_back(to);
+      }
+      count_work(adj[queue[i]].size());
+    }
+    string part;
+    for (unsigned int p = end; p != from; p = edges[via[p]].from) {
+      part += edges[via[p]].c;
+    }
+    reverse(part.begin(), part.end());
+    return part;
+  };
+
+  // the pump goes from the ambiguous edge to the nearest pair (q, q) and
+  // back to the edge, the shortest one from a few edges is kept
+  string pump;
+  unsigned int q = 0;
+  unsigned int tried = 0;
+  for (unsigned int i = 0; i < edges.size() && tried < REDOS_PUMP_TRIES && !gave_up; i++) {
+    if (out_of_time(deadline)) return;
+    unsigned int c = pair_comp[edges[i].from];
+    if (!edges[i].ambiguous || pair_comp[edges[i].to] != c || !has_diagonal[c]) continue;
+    tried++;
+
+    unsigned int home, end;
+    string back = walk(edges[i].to, [n](unsigned int p) { return p / n == p % n; }, home);
+    unsigned int from = edges[i].from;
+    string ahead = walk(home, [from](unsigned int p) { return p == from; }, end);
+    string candidate = ahead + edges[i].c + back;
+    if (pump == "" || candidate.length() < pump.length()) {
+      pump = candidate;
+      q = home / n;
+    }
+  }
+  if (pump == "") return;
+
+  RedosFinding finding;
+  finding.kind = EXPONENTIAL_REDOS;
+  finding.degree = 0;
+  finding.prefix = find_string(start, states[q]);
+  finding.pump = pump;
+  if (find_suffix(finding.prefix, finding.pump, finding.suffix)) {
+    findings.push_back(finding);
+    exponential[comp] = true;
+  }
+}
+
+bool
+RedosAnalyzer::find_polynomial(unsigned int comp1, unsigned int comp2, unsigned int &p,
+                               unsigned int &q, string &pump, Deadline *deadline)
+{
+  const vector <unsigned int> &states1 = members[comp1];
+  const vector <unsigned int> &states2 = members[comp2];
+  unsigned int n1 = states1.size();
+  unsigned int n2 = states2.size();
+  unsigned int n = accepting.size();
+  map <unsigned int, unsigned int> local1, local2;
+  for (unsigned int i = 0; i < n1; i++) local1[states1[i]] = i;
+  for (unsigned int i = 0; i < n2; i++) local2[states2[i]] = i;
+
+  // search the product of three copies from (p, p, q) for (p, q, q): the
+  // first copy stays in the first component, the third in the second
+  for (unsigned int i = 0; i < n1; i++) {
+    for (unsigned int j = 0; j < n2; j++) {
+      if (out_of_time(deadline)) return false;
+      unordered_map <unsigned long, pair <unsigned long, char> > via;
+      unsigned long from = ((unsigned long) i * n + states1[i]) * n2 + j;
+      unsigned long goal = ((unsigned long) i * n + states2[j]) * n2 + j;
+      vector <unsigned long> queue(1, from);
+      via[from] = make_pair(from, 0);
+      for (unsigned int k = 0; k < queue.size() && via.count(goal) == 0; k++) {
+        unsigned int a = queue[k] / ((unsigned long) n * n2);
+        unsigned int b = queue[k] / n2 % n;
+        unsigned int c = queue[k] % n2;
+        vector <unsigned int>::iterator t1, t2, t3;
+        for (t1 = out[states1[a]].begin(); t1 != out[states1[a]].end(); t1++) {
+          if (component[transitions[*t1].to] != comp1) continue;
+          for (t3 = out[states2[c]].begin(); t3 != out[states2[c]].end(); t3++) {
+            if (component[transitions[*t3].to] != comp2) continue;
+            CharBitmap both = transitions[*t1].chars.intersection(transitions[*t3].chars);
+            if (both.empty()) continue;
+            for (t2 = out[b].begin(); t2 != out[b].end(); t2++) {
+              if (!count_work()) return false;
+              char ch;
+              if (!pick_char(both.intersection(transitions[*t2].chars), ch)) continue;
+              unsigned long to = ((unsigned long) local1[transitions[*t1].to] * n
+                                  + transitions[*t2].to) * n2 + local2[transitions[*t3].to];
+              if (via.count(to) != 0) continue;
+              via[to] = make_pair(queue[k], ch);
+              queue.push_back(to);
+            }
+          }
+        }
+      }
+      if (via.count(goal) == 0) continue;
+
+      pump = "";
+      for (unsigned long s = goal; s != from; s = via[s].first) {
+        pump += via[s].second;
+      }
+      reverse(pump.begin(), pump.end());
+      p = states1[i];
+      q = states2[j];
+      return true;
+    }
+  }
+  return false;
+}
+
+string
+RedosAnalyzer::find_string(unsigned int from, unsigned int state)
+{
+  vector <int> via(accepting.size(), -1);
+  vector <bool> seen(accepting.size(), false);
+  vector <unsigned int> queue(1, from);
+  seen[from] = true;
+  for (unsigned int i = 0; i < queue.size() && !seen[state]; i++) {
+    vector <unsigned int>::iterator t;
+    for (t = out[queue[i]].begin(); t != out[queue[i]].end(); t++) {
+      unsigned int to = transitions[*t].to;
+      if (seen[to]) continue;
+      seen[to] = true;
+      via[to] = *t;
+      queue.push_back(to);
+    }
+  }
+
+  string part;
+  if (!seen[state]) return part;
+  for (unsigned int s = state; s != from; s = transitions[via[s]].from) {
+    char c;
+    pick_char(transitions[via[s]].chars, c);
+    part += c;
+  }
+  reverse(part.begin(), part.end());
+  return part;
+}
+
+unsigned int
+RedosAnalyzer::pump_degree(const string &prefix, const string &pump)
+{
+  // the number of runs (counting an edge reached along two epsilon paths
+  // twice) over the prefix and n pumps, a backtracking matcher that fails
+  // tries each of them for each n, so their growth is one less than the
+  // degree of the matching time
+  vector <double> runs(accepting.size(), 0);
+  runs[start] = 1;
+  auto advance = [&](char c) {
+    vector <double> next(accepting.size(), 0);
+    for (unsigned int s = 0; s < runs.size(); s++) {
+      if (runs[s] == 0) continue;
+      count_work(out[s].size() + 1);
+      vector <unsigned int>::iterator t;
+      for (t = out[s].begin(); t != out[s].end(); t++) {
+        if (transitions[*t].chars.contains(c))
+          next[transitions[*t].to] += runs[s] * transitions[*t].count;
+      }
+    }
+    runs.swap(next);
+  };
+  auto total = [&]() {
+    double sum = 0;
+    for (unsigned int s = 0; s < runs.size(); s++) sum += runs[s];
+    return sum;
+  };
+
+  for (unsigned int i = 0; i < prefix.length(); i++) advance(prefix[i]);
+  double half = 0;
+  for (unsigned int n = 1; n <= REDOS_DEGREE_PUMPS && !gave_up; n++) {
+    for (unsigned int i = 0; i < pump.length(); i++) advance(pump[i]);
+    if (n == REDOS_DEGREE_PUMPS / 2) half = total();
+  }
+  double full = total();
+  if (gave_up) return 0;
+  if (half == 0 || full == 0) return 0;
+  if (full > 1e300) return UINT_MAX;
+
+  // runs grow as n^k, so doubling n multiplies them by 2^k
+  return (unsigned int) floor(log2(full / half) + 0.5) + 1;
+}
+
+bool
+RedosAnalyzer::find_suffix(const string &prefix, const string &pump, string &suffix)
+{
+  vector <unsigned int> states(1, start);
+  string s = prefix + pump + pump;
+  for (unsigned int i = 0; i < s.length(); i++) {
+    states = step(states, s[i]);
+  }
+
+  // a character that fails (one that is not in the pump is tried first,
+  // since a backtracking matcher tries every split of the pumps before it
+  // fails), or else no suffix if the string already fails
+  for (unsigned int i = 0; ; i++) {
+    char c;
+    if (!pick_suffix_char(i, c)) break;
+    if (pump.find(c) != string::npos) continue;
+    vector <unsigned int> next = step(states, c);
+    bool accepted = false;
+    for (unsigned int j = 0; j < next.size(); j++) {
+      if (accepting[next[j]]) accepted = true;
+    }
+    if (!accepted) {
+      suffix = string(1, c);
+      return true;
+    }
+  }
+  for (unsigned int j = 0; j < states.size(); j++) {
+    if (accepting[states[j]]) return false;
+  }
+  suffix = "";
+  return true;
+}
+
+vector <unsigned int>
+RedosAnalyzer::step(const vector <unsigned int> &states, char c)
+{
+  vector <bool> seen(accepting.size(), false);
+  vector <unsigned int> next;
+  for (unsigned int i = 0; i < states.size(); i++) {
+    vector <unsigned int>::iterator t;
+    for (t = out[states[i]].begin(); t != out[states[i]].end(); t++) {
+      unsigned int to = transitions[*t].to;
+      if (!seen[to] && transitions[*t].chars.contains(c)) {
+        seen[to] = true;
+        next.push_back(to);
+      }
+    }
+  }
+  return next;
+}
+
+bool
+RedosAnalyzer::count_work(unsigned long steps)
+{
+  work += steps;
+  if (work > REDOS_WORK_LIMIT) gave_up = true;
+  return !gave_up;
+}
+
+void
+RedosAnalyzer::measure_growth(ParseNode *root, Deadline *deadline)
+{
+  GrowthMeter meter(root);
+  vector <RedosFinding>::iterator it;
+  for (it = findings.begin(); it != findings.end(); it++) {
+    if (deadline && deadline->expired("measuring backtracking growth")) return;
+    it->growth = meter.measure(it->prefix, it->pump, it->suffix, deadline);
+  }
+}
+
+GrowthClass
+RedosAnalyzer::get_growth()
+{
+  GrowthClass growth = LINEAR_GROWTH;
+  vector <RedosFinding>::iterator it;
+  for (it = findings.begin(); it != findings.end(); it++) {
+    if (it->growth.measured && it->growth.growth > growth) growth = it->growth.growth;
+  }
+  return growth;
+}
+
+void
+RedosAnalyzer::add_warnings()
+{
+  bool measured = false;
+  vector <RedosFinding>::iterator it;
+  for (it = findings.begin(); it != findings.end(); it++) {
+    stringstream s;
+    if (it->kind == EXPONENTIAL_REDOS) {
+      s << "REDOS WARNING: Backtracking can take exponential time (nested or overlapping repetition)\n";
+    }
+    else {
+      s << "REDOS WARNING: Backtracking can take polynomial time of degree " << it->degree
+        << " (repetitions in sequence that overlap)\n";
+    }
+    s << "...Prefix: " << quote(it->prefix) << "\n";
+    s << "...Pump:   " << quote(it->pump) << "\n";
+    s << "...Suffix: " << quote(it->suffix);
+    const GrowthResult &growth = it->growth;
+    if (growth.measured) {
+      measured = true;
+      s << "\n...Growth: " << growth_class_name(growth.growth) << " (";
+      if (growth.growth != EXPONENTIAL_GROWTH)
+        s << "pumps^" << fixed << setprecision(1) << growth.exponent << ", ";
+      if (growth.pumps.empty())
+        s << "over " << GROWTH_STEP_LIMIT << " steps for 1 pump)";
+      else
+        s << growth.steps.front() << " to " << growth.steps.back() << " steps for "
+          << growth.pumps.front() << " to " << growth.pumps.back() << " pumps)";
+    }
+    addWarning(s.str());
+  }
+
+  if (gave_up) {
+    addWarning("REDOS WARNING: Backtracking check reached its work limit, "
+               "the regex was only partly checked");
+  }
+
+  // one line with the fastest growth, to check a regex against
+  GrowthClass growth = get_growth();
+  if (measured && growth != LINEAR_GROWTH) {
+    addWarning("GROWTH WARNING: Growth of matching steps with the input length is "
+               + growth_class_name(growth));
+  }
+}
+
+void
+RedosAnalyzer::add_stats(Stats &stats)
+{
+  int exponential_count = 0;
+  int polynomial_count = 0;
+  vector <RedosFinding>::iterator it;
+  for (it = findings.begin(); it != findings.end(); it++) {
+    if (it->kind == EXPONENTIAL_REDOS)
+      exponential_count++;
+    else
+      polynomial_count++;
+  }
+  stats.add("REDOS", "Analysis states", accepting.size());
+  stats.add("REDOS", "Analysis edges", transitions.size());
+  stats.add("REDOS", "Exponential findings", exponential_count);
+  stats.add("REDOS", "Polynomial findings", polynomial_count);
+  stats.add("REDOS", "Work limit reached", gave_up);
+}
+
+// finds the strongly connected components of a graph, numbered so that
+// every edge between components goes to a higher number, returns the
+// number of components
+static unsigned int
+find_components(const vector <vector <unsigned int> > &adj, vector <unsigned int> &comp)
+{
+  unsigned int n = adj.size();
+  vector <vector <unsigned int> > rev(n);
+  for (unsigned int s = 0; s < n; s++) {
+    for (unsigned int i = 0; i < adj[s].size(); i++) rev[adj[s][i]].push_back(s);
+  }
+
+  // order the states by finishing time
+  vector <unsigned int> order;
+  vector <bool> seen(n, false);
+  vector <pair <unsigned int, unsigned int> > stack;
+  for (unsigned int s = 0; s < n; s++) {
+    if (seen[s]) continue;
+    seen[s] = true;
+    stack.push_back(make_pair(s, 0));
+    while (!stack.empty()) {
+      pair <unsigned int, unsigned int> &top = stack.back();
+      if (top.second == adj[top.first].size()) {
+        order.push_back(top.first);
+        stack.pop_back();
+        continue;
+      }
+      unsigned int next = adj[top.first][top.second++];
+      if (!seen[next]) {
+        seen[next] = true;
+        stack.push_back(make_pair(next, 0));
+      }
+    }
+  }
+
+  // each search of the reversed graph in reverse finishing order finds a
+  // component, and the components come out in topological order
+  unsigned int count = 0;
+  comp.assign(n, n);
+  for (unsigned int i = n; i-- > 0; ) {
+    unsigned int s = order[i];
+    if (comp[s] != n) continue;
+    vector <unsigned int> todo(1, s);
+    comp[s] = count;
+    while (!todo.empty()) {
+      unsigned int state = todo.back();
+      todo.pop_back();
+      for (unsigned int j = 0; j < rev[state].size(); j++) {
+        if (comp[rev[state][j]] == n) {
+          comp[rev[state][j]] = count;
+          todo.push_back(rev[state][j]);
+        }
+      }
+    }
+    count++;
+  }
+  return count;
+}
+
+// order in which characters are picked: letters, digits, space,
+// punctuation, then the rest
+static const char *PICK_ORDER =
+  "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 "
+  "!\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
+
+// picks a character from a set, returns false if it is empty
+static bool
+pick_char(const CharBitmap &chars, char &c)
+{
+  for (const char *p = PICK_ORDER; *p; p++) {
+    if (chars.contains(*p)) {
+      c = *p;
+      return true;
+    }
+  }
+  for (unsigned int i = 0; i < 256; i++) {
+    if (chars.contains((char) i)) {
+      c = (char) i;
+      return true;
+    }
+  }
+  return false;
+}
+
+// returns the ith character to try as a suffix: a few that rarely match,
+// then the characters in pick order (no other whitespace, since \s is
+// taken as a space but matches any whitespace in a real matcher)
+static bool
+pick_suffix_char(unsigned int i, char &c)
+{
+  static const char *first = "! ";
+  unsigned int n = strlen(first);
+  if (i < n) {
+    c = first[i];
+    return true;
+  }
+  i -= n;
+  if (i >= strlen(PICK_ORDER)) return false;
+  c = PICK_ORDER[i];
+  return true;
+}
+
+// returns the ASCII characters in a character set
+static CharBitmap
+ascii_chars(CharSet *char_set)
+{
+  CharBitmap chars;
+  for (unsigned int c = 0; c < 128; c++) {
+    if (char_set->contains(c)) chars.add((char) c);
+  }
+  return chars;
+}
+
+// returns a string in quotes with special characters escaped
+static string
+quote(const string &s)
+{
+  string result = "\"";
+  for (unsigned int i = 0; i < s.length(); i++) {
+    unsigned char c = s[i];
+    switch (c) {
+    case '"':	result += "\\\""; break;
+    case '\\':	result += "\\\\"; break;
+    case '\n':	result += "\\n"; break;
+    case '\r':	result += "\\r"; break;
+    case '\t':	result += "\\t"; break;
+    default:
+      if (c < 0x20 || c >= 0x7f) {
+        char buf[8];
+        snprintf(buf, sizeof(buf), "\\x%02x", c);
+        result += buf;
+      }
+      else {
+        result += c;
+      }
+    }
+  }
+  return result + "\"";
+}
+
+// returns true once the deadline (if any) has passed
+static bool
+out_of_time(Deadline *deadline)
+{
+  return deadline && deadline->expired("checking for backtracking");
+}
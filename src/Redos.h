@@ -0,0 +1,203 @@
+/*  Redos.h: finds regexes that make a backtracking matcher slow
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// A backtracking matcher (such as Python's re) tries every way a string
+// can match before it fails, so an ambiguous regex can take exponential
+// or polynomial time on a string that almost matches.
+//
+// The analyzer turns the NFA into an automaton with cycles, where the body
+// of a loop is copied once for each iteration and an unbounded loop gets an
+// epsilon edge back to the start of its last copy, and removes the epsilon
+// edges.  A character edge reached by two epsilon paths is kept with a
+// count of two, since the matcher tries both paths.  States that differ
+// only in how they were reached are merged.  The automaton is then checked
+// for:
+//
+// - exponential ambiguity (EDA): a state that can return to itself on
+//   the same string along two different paths.  This is found with the
+//   product of the automaton with itself: a strongly connected component
+//   of the product that holds a pair (q, q) and is entered or left along
+//   two different edges.
+// - polynomial ambiguity (IDA): states p and q in different cycles and a
+//   string w that takes p to p, p to q, and q to q.  This is found with
+//   the product of three copies of the automaton.  A chain of k loops
+//   linked this way takes time of degree k.  The pump joins the pumps of
+//   the links, and the degree it reaches is found by counting the runs of
+//   the automaton over more and more pumps.
+//
+// Each finding comes with an attack string: a prefix that reaches the
+// ambiguous loop, a pump to repeat, and a suffix that makes the whole
+// string fail to match.  The growth of the matching time with the number of
+// pumps can then be measured (see Growth.h).  Characters are limited to
+// ASCII (and the bytes of literal characters), and the analysis stops after
+// a fixed amount of work so that large regexes do not slow down the run.
+
+#ifndef REDOS_H
+#define REDOS_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include "CharSet.h"
+#include "Deadline.h"
+#include "Growth.h"
+#include "NFA.h"
+#include "ParseTree.h"
+#include "Stats.h"
+using namespace std;
+
+// limit on the steps of an analysis
+#define REDOS_WORK_LIMIT 2000000
+
+// limit on the states built before epsilon edges are removed (each one
+// holds edge lists, so this bounds the memory of an analysis)
+#define REDOS_MAX_STATES 100000
+
+// most copies made of a loop body (a loop with a higher upper bound is
+// taken as unbounded)
+#define REDOS_MAX_COPIES 32
+
+// ambiguous edges tried for the shortest exponential pump
+#define REDOS_PUMP_TRIES 16
+
+// pumps used to find the degree a polynomial pump reaches (runs are
+// counted after half of them and after all of them)
+#define REDOS_DEGREE_PUMPS 32
+
+typedef enum {
+  EXPONENTIAL_REDOS,
+  POLYNOMIAL_REDOS
+} RedosKind;
+
+struct RedosFinding {
+  RedosKind kind;		// kind of ambiguity
+  unsigned int degree;		// degree of the polynomial (for POLYNOMIAL_REDOS)
+  string prefix;		// string that leads to the ambiguous loop
+  string pump;			// string repeated to increase the matching time
+  string suffix;		// string that makes the match fail
+  GrowthResult growth;		// measured growth (if measured)
+};
+
+class RedosAnalyzer {
+
+public:
+
+  RedosAnalyzer() { work = 0; gave_up = false; }
+
+  // analyzes the NFA (stops early if the deadline passes)
+  void analyze(NFA &nfa, Deadline *deadline = NULL);
+
+  // returns the findings
+  const vector <RedosFinding> &get_findings() { return findings; }
+
+  // measures the growth of each finding with the tree the NFA was built
+  // from (stops early if the deadline passes)
+  void measure_growth(ParseNode *root, Deadline *deadline = NULL);
+
+  // returns the fastest measured growth (linear if none was measured)
+  GrowthClass get_growth();
+
+  // adds a warning for each finding (and for the growth if measured)
+  void add_warnings();
+
+  // add analysis stats
+  void add_stats(Stats &stats);
+
+private:
+
+  // an edge of the automaton without epsilon edges
+  struct Transition {
+    unsigned int from;
+    unsigned int to;
+    CharBitmap chars;		// characters on the edge
+    unsigned int count;		// number of epsilon paths to the edge (at most 2)
+  };
+
+  // the automaton with cycles and epsilon edges
+  struct Graph {
+    vector <vector <unsigned int> > epsilon;	// epsilon edges from each state
+    vector <Transition> char_edges;		// character edges
+    vector <vector <unsigned int> > char_out;	// character edges from each state
+    map <RegexLoop *, pair <unsigned int, unsigned int> > loop_begin;	// begin edge of each loop
+    map <RegexLoop *, pair <unsigned int, unsigned int> > loop_end;	// end edge of each loop
+
+    unsigned int add_state();
+    void add_char_edge(unsigned int from, unsigned int to, const CharBitmap &chars);
+  };
+
+  unsigned int start;				// initial state
+  vector <bool> accepting;			// set for states that can reach the final state
+  vector <Transition> transitions;		// edges
+  vector <vector <unsigned int> > out;		// edges leaving each state
+  vector <unsigned int> component;		// strongly connected component of each state
+  vector <vector <unsigned int> > members;	// states in each component (in topological order)
+  vector <bool> cyclic;				// set for components with a cycle
+  vector <bool> exponential;			// set for components with an EDA finding
+  vector <RedosFinding> findings;		// findings
+  unsigned long work;				// steps taken
+  bool gave_up;					// set if the analysis hit the work limit
+
+  // builds the automaton from the NFA (stops early if the deadline passes)
+  void build(NFA &nfa, Deadline *deadline);
+
+  // copies the states first..last of the NFA (the part built from one
+  // node of the parse tree) into the graph, sets the copies of the first
+  // and last state (returns false at the work limit)
+  bool copy_part(NFA &nfa, Graph &g, unsigned int first, unsigned int last,
+                 unsigned int &copy_first, unsigned int &copy_last);
+
+  // adds iterations of a loop whose body is the states first..last between
+  // states from and to of the graph (returns false at the work limit)
+  bool copy_loop(NFA &nfa, Graph &g, RegexLoop *loop, unsigned int first, unsigned int last,
+                 unsigned int from, unsigned int to);
+
+  // merges states that accept the same way and have the same edges (the
+  // edges of a merged state are dropped)
+  void merge_states(Deadline *deadline);
+
+  // looks for exponential ambiguity in a component
+  void find_exponential(unsigned int comp, Deadline *deadline);
+
+  // looks for polynomial ambiguity between the states of two components,
+  // fills in the states (p in the first, q in the second) and pump if found
+  bool find_polynomial(unsigned int comp1, unsigned int comp2, unsigned int &p,
+                       unsigned int &q, string &pump, Deadline *deadline);
+
+  // returns a shortest string from one state to another ("" if there is none)
+  string find_string(unsigned int from, unsigned int state);
+
+  // returns the degree of the matching time that repeating the pump after
+  // the prefix reaches (0 if the pump fails, UINT_MAX if the time is
+  // exponential)
+  unsigned int pump_degree(const string &prefix, const string &pump);
+
+  // returns a suffix that makes prefix + pump + pump fail to match, returns
+  // false if none was found
+  bool find_suffix(const string &prefix, const string &pump, string &suffix);
+
+  // returns the states reached from states on a character
+  vector <unsigned int> step(const vector <unsigned int> &states, char c);
+
+  // counts a step, returns false once the work limit is reached
+  bool count_work(unsigned long steps = 1);
+};
+
+#endif // REDOS_H
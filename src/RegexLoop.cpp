@@ -27,26 +27,27 @@
 using namespace std;
 
 StringPath
-RegexLoop::get_substring()
+RegexLoop::get_substring(const StringPath &iteration)
 {
   // Adds the loop substring a sufficient number of times if the lower
   // bound is greater than 1.
   StringPath substring;
   for (int j = 1; j < repeat_lower; j++) {
-    substring.add_path(curr_substring);
+    substring.add_path(iteration);
   }
 
   return substring;
 }
 
 void
-RegexLoop::process_min_iter_string(StringPath *min_iter_string)
+RegexLoop::process_min_iter_string(StringPath *min_iter_string, const StringPath &first_iteration,
+                                   const StringPath &last_iteration)
 {
   if (repeat_lower != 0) {
-    min_iter_string->add_path(get_substring());
+    min_iter_string->add_path(get_substring(last_iteration));
   }
   else {
-    int max_keep = min_iter_string->path.size() - path_substring.path.size();
+    int max_keep = min_iter_string->path.size() - first_iteration.path.size();
     int num_to_remove = min_iter_string->path.size() - max_keep;
     
     for(int i = 0; i < num_to_remove; i++) {
@@ -57,39 +58,22 @@ RegexLoop::process_min_iter_string(StringPath *min_iter_string)
   }
 }
 
-void
-RegexLoop::process_begin_loop(StringPath prefix, bool processed)
-{
-  curr_prefix.clear();
-  curr_prefix = prefix;
-  if (!processed) path_prefix = prefix;
-}
-
-void
-RegexLoop::process_end_loop(StringPath prefix, bool processed)
-{
-  curr_substring.clear();
-  vector <StringPath>::iterator path_iter;
-
-  for (unsigned int i = curr_prefix.path.size(); i != prefix.path.size(); i++) {
-    curr_substring.path.push_back(prefix.path[i]);
-  }
-  if (!processed) path_substring = curr_substring;
-}
-
-set <StringPath, spcompare>
-RegexLoop::gen_evil_strings(StringPath path_string)
+vector <StringPath>
+RegexLoop::gen_evil_strings(const StringPath &path_prefix, const StringPath &path_substring,
+                            const StringPath &path_string)
 {
-  set <StringPath, spcompare> evil_strings;
+  vector <StringPath> evil_strings;
   StringPath path_suffix;
   int min = path_prefix.path.size() + path_substring.path.size();
   int max = path_string.path.size();
   for(int i = min; i < max; i++) {
     path_suffix.path.push_back(path_string.path[i]);
   }
-  StringPath one_less_string = path_prefix;
+  StringPath one_less_string;
+  one_less_string.add_path(path_prefix);
   one_less_string.add_path(path_suffix);
-  StringPath one_more_string = path_prefix;
+  StringPath one_more_string;
+  one_more_string.add_path(path_prefix);
   one_more_string.add_path(path_substring);
   one_more_string.add_path(path_substring);
   one_more_string.add_path(path_suffix);
@@ -98,13 +82,13 @@ RegexLoop::gen_evil_strings(StringPath path_string)
 
     // For cases like {n}, add strings for one less (n-1) and one more (n+1).
     if (repeat_lower == repeat_upper) {
-      evil_strings.insert(one_less_string);
-      evil_strings.insert(one_more_string);
+      evil_strings.push_back(move(one_less_string));
+      evil_strings.push_back(move(one_more_string));
     }
     else {
       // Handle one less on lower bound (note if lower bound is zero, the path
       // has one iteration so one less iteration will get us to zero iterations)
-      evil_strings.insert(one_less_string);
+      evil_strings.push_back(move(one_less_string));
 
       // Add enough path elements to get to the upper bound (note if lower bound
       // is zero, the path has one iteration so the starting point is bumped to one).
@@ -112,23 +96,26 @@ RegexLoop::gen_evil_strings(StringPath path_string)
       // has one substring less than lower bound.
       int base_iterations = repeat_lower;
       if (base_iterations == 0) base_iterations = 1;
-      StringPath path_elements = path_substring;
+      StringPath path_elements;
+      path_elements.add_path(path_substring);
       for (int i = base_iterations; i < repeat_upper; i++) {
         path_elements.add_path(path_substring);
       }
 
       // Add the upper bound string.
-      StringPath upper_bound_string = path_prefix;
+      StringPath upper_bound_string;
+      upper_bound_string.add_path(path_prefix);
       upper_bound_string.add_path(path_elements);
       upper_bound_string.add_path(path_suffix);
-      evil_strings.insert(upper_bound_string);
+      evil_strings.push_back(move(upper_bound_string));
 
       // Add the string with one more iteration past the upper bound.
-      StringPath past_bound_string = path_prefix;
+      StringPath past_bound_string;
+      past_bound_string.add_path(path_prefix);
       past_bound_string.add_path(path_elements);
       past_bound_string.add_path(path_substring);
       past_bound_string.add_path(path_suffix);
-      evil_strings.insert(past_bound_string);
+      evil_strings.push_back(move(past_bound_string));
     } 
   }
 
@@ -136,12 +123,12 @@ RegexLoop::gen_evil_strings(StringPath path_string)
     // If lower bound is 0 or 1, add one less (zero) and add one more (two).  Want
     // to have one case that has repeated (two) elements.
     if (repeat_lower == 0 || repeat_lower == 1) {
-      evil_strings.insert(one_less_string);
-      evil_strings.insert(one_more_string);
+      evil_strings.push_back(move(one_less_string));
+      evil_strings.push_back(move(one_more_string));
     }
     // Otherwise, only add the string with one less iteration than the lower bound.
     else {
-      evil_strings.insert(one_less_string);
+      evil_strings.push_back(move(one_less_string));
     }
   }
 
@@ -22,8 +22,8 @@
 #ifndef REGEX_LOOP_H
 #define REGEX_LOOP_H
 
-#include <set>
 #include <string>
+#include <vector>
 #include "StringPath.h"
 using namespace std;
 
@@ -36,20 +36,23 @@ public:
     repeat_upper = upper;
   }
 
-  // get substring - additional iterations for lower bounds greater than 1
-  StringPath get_substring();
+  int get_lower() { return repeat_lower; }
+  int get_upper() { return repeat_upper; }
 
-  // process minimum iterations string
-  void process_min_iter_string(StringPath *min_iter_string);
+  // get substring - additional iterations (of iteration) for lower bounds
+  // greater than 1
+  StringPath get_substring(const StringPath &iteration);
 
-  // process begin loop edge
-  void process_begin_loop(StringPath prefix, bool processed);
+  // process minimum iterations string (first_iteration is the iteration from
+  // the first path through the loop, last_iteration from the most recent)
+  void process_min_iter_string(StringPath *min_iter_string, const StringPath &first_iteration,
+                               const StringPath &last_iteration);
 
-  // process end loop edge
-  void process_end_loop(StringPath prefix, bool processed);
-
-  // generate evil strings
-  set <StringPath, spcompare> gen_evil_strings(StringPath path_string);
+  // generate evil strings from the path string before the loop and one
+  // iteration of the loop (in the order they are output)
+  vector <StringPath> gen_evil_strings(const StringPath &path_prefix,
+                                       const StringPath &path_substring,
+                                       const StringPath &path_string);
 
   // print the regex loop
   void print();
@@ -58,10 +61,6 @@ private:
 
   int repeat_lower;     	// lower bound for repeat quantifiers 
   int repeat_upper;     	// upper bound for repeat quantifiers (-1 if no bound)
-  StringPath path_prefix;           // path string up to visiting this node
-  StringPath path_substring;        // substring corresponding to this string
-  StringPath curr_prefix;           // current path string up to visiting this node
-  StringPath curr_substring;        // current substring corresponding to this string
 };
 
 #endif // REGEX_LOOP_H
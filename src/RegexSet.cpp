@@ -0,0 +1,210 @@
+/*  RegexSet.cpp: a set of regexes with their common prefixes factored
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "CharSet.h"
+#include "ParseTree.h"
+#include "RegexSet.h"
+#include "Scanner.h"
+#include "Stats.h"
+#include "error.h"
+using namespace std;
+
+RegexSet::~RegexSet()
+{
+  vector <Member>::iterator m;
+  for (m = members.begin(); m != members.end(); m++) {
+    delete m->tree;
+  }
+  vector <TrieNode *>::iterator t;
+  for (t = trie.begin(); t != trie.end(); t++) {
+    delete *t;
+  }
+  vector <ParseNode *>::iterator n;
+  for (n = nodes.begin(); n != nodes.end(); n++) {
+    delete *n;
+  }
+}
+
+void
+RegexSet::build(const vector <string> &regexes, Deadline *deadline)
+{
+  TrieNode *trie_root = new TrieNode();
+  trie_root->item = NULL;
+  trie_root->member_end = false;
+  trie.push_back(trie_root);
+  item_count = 0;
+  shared_count = 0;
+  int backref_id = 0;
+
+  for (unsigned int i = 0; i < regexes.size(); i++) {
+    if (deadline) deadline->check("building regex set");
+
+    // parse the member
+    Member member;
+    member.tree = new ParseTree();
+    try {
+      Scanner scanner;
+      scanner.init(regexes[i]);
+      member.tree->build(scanner, deadline);
+    }
+    catch (EgretException const &e) {
+      if (deadline && deadline->has_expired()) {
+        delete member.tree;
+        throw;
+      }
+      delete member.tree;
+      member.tree = NULL;
+      member.error = e.getError();
+    }
+    members.push_back(member);
+    if (member.tree == NULL) continue;
+
+    const set <char> &marks = member.tree->get_punct_marks();
+    punct_marks.insert(marks.begin(), marks.end());
+    backref_id += renumber_backreferences(member.tree->get_root(), backref_id);
+
+    // add the items of the top level concatenation to the trie
+    vector <ParseNode *> items;
+    ParseNode *node = member.tree->get_root();
+    while (node->type == CONCAT_NODE) {
+      items.push_back(node->left);
+      node = node->right;
+    }
+    items.push_back(node);
+    item_count += items.size();
+
+    TrieNode *t = trie_root;
+    vector <ParseNode *>::iterator it;
+    for (it = items.begin(); it != items.end(); it++) {
+      string key = node_key(*it);
+      map <string, TrieNode *>::iterator child = t->index.find(key);
+      if (child != t->index.end()) {
+        t = child->second;
+        shared_count++;
+        continue;
+      }
+      TrieNode *next = new TrieNode();
+      next->item = *it;
+      next->member_end = false;
+      trie.push_back(next);
+      t->children.push_back(next);
+      t->index[key] = next;
+      t = next;
+    }
+    t->member_end = true;
+  }
+
+  root = build_tree(trie_root);
+}
+
+ParseNode *
+RegexSet::build_tree(TrieNode *node)
+{
+  vector <ParseNode *> branches;
+  vector <TrieNode *>::iterator it;
+  for (it = node->children.begin(); it != node->children.end(); it++) {
+    ParseNode *rest = build_tree(*it);
+    if (rest == NULL)
+      branches.push_back((*it)->item);
+    else
+      branches.push_back(add_node(new ParseNode(CONCAT_NODE, (*it)->item, rest)));
+  }
+  if (branches.empty()) return NULL;
+
+  ParseNode *tree = build_alternation(branches, 0, branches.size());
+  if (node->member_end) {
+    tree = add_node(new ParseNode(REPEAT_NODE, tree, 0, 1));
+  }
+  return tree;
+}
+
+ParseNode *
+RegexSet::build_alternation(const vector <ParseNode *> &branches, unsigned int first,
+                            unsigned int last)
+{
+  if (last - first == 1) return branches[first];
+  unsigned int middle = first + (last - first) / 2;
+  return add_node(new ParseNode(ALTERNATION_NODE, build_alternation(branches, first, middle),
+                                build_alternation(branches, middle, last)));
+}
+
+string
+RegexSet::node_key(ParseNode *node)
+{
+  if (node == NULL) return "-";
+
+  stringstream s;
+  s << node->type;
+  switch (node->type) {
+  case CHARACTER_NODE:
+    s << ':' << (int) node->character;
+    break;
+  case CHAR_SET_NODE:
+    s << ':' << node->char_set->get_key();
+    break;
+  case REPEAT_NODE:
+    s << ':' << node->repeat_lower << ',' << node->repeat_upper;
+    break;
+  case GROUP_NODE:
+    s << ':' << node->group_num << ',' << node->name;
+    break;
+  case BACKREFERENCE_NODE:
+    s << ':' << node->backref_value;
+    break;
+  default:
+    break;
+  }
+  s << '(' << node_key(node->left) << ',' << node_key(node->right) << ')';
+  return s.str();
+}
+
+int
+RegexSet::renumber_backreferences(ParseNode *node, int first)
+{
+  if (node == NULL) return 0;
+  int count = 0;
+  if (node->type == BACKREFERENCE_NODE) {
+    node->backref_id += first;
+    count++;
+  }
+  count += renumber_backreferences(node->left, first);
+  count += renumber_backreferences(node->right, first);
+  return count;
+}
+
+void
+RegexSet::add_stats(Stats &stats)
+{
+  unsigned int parsed = 0;
+  for (unsigned int i = 0; i < members.size(); i++) {
+    if (members[i].tree != NULL) parsed++;
+  }
+  stats.add("REGEX_SET", "Members", members.size());
+  stats.add("REGEX_SET", "Members parsed", parsed);
+  stats.add("REGEX_SET", "Items", item_count);
+  stats.add("REGEX_SET", "Items shared", shared_count);
+  stats.add("REGEX_SET", "Trie nodes", trie.size() - 1);
+}
@@ -0,0 +1,125 @@
+/*  RegexSet.h: a set of regexes with their common prefixes factored
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Each member of the set is parsed on its own and split into the items of
+// its top level concatenation.  The item lists go into a trie, where an
+// item is shared with an earlier member if the two are structurally the
+// same, so members with a common prefix share the nodes of that prefix.
+// The trie is then turned into a single parse tree: the ways to continue
+// from a trie node become an alternation (optional if a member ends
+// there).  Building that tree into one NFA means a prefix shared by many
+// members is traversed, and gets its evil strings, once.
+//
+// Two members that accept a common string but no string that tells them
+// apart are given one, found by editing a character of a string that both
+// accept (see run_regex_set).
+
+#ifndef REGEX_SET_H
+#define REGEX_SET_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "Deadline.h"
+#include "ParseTree.h"
+#include "Stats.h"
+using namespace std;
+
+// limits on telling members apart: edited strings matched for each pair,
+// and matching steps taken for the whole set
+#define SET_EDIT_TRIES 200
+#define SET_EDIT_STEPS 2000000
+
+class RegexSet {
+
+public:
+
+  RegexSet() { root = NULL; }
+  ~RegexSet();
+
+  // parses the members and builds the combined tree, a member that does
+  // not parse is left out of the tree (its error is kept)
+  void build(const vector <string> &regexes, Deadline *deadline = NULL);
+
+  // returns the root of the combined tree (NULL if no member parsed)
+  ParseNode *get_root() { return root; }
+
+  // returns the punctuation marks of all members
+  const set <char> &get_punct_marks() { return punct_marks; }
+
+  // returns the number of members
+  unsigned int size() { return members.size(); }
+
+  // returns the parse tree of a member (NULL if it did not parse)
+  ParseTree *get_member_tree(unsigned int i) { return members[i].tree; }
+
+  // returns the parse error of a member ("" if it parsed)
+  string get_member_error(unsigned int i) { return members[i].error; }
+
+  // add regex set stats
+  void add_stats(Stats &stats);
+
+private:
+
+  struct Member {
+    ParseTree *tree;		// parse tree (NULL if the member did not parse)
+    string error;		// parse error
+  };
+
+  struct TrieNode {
+    ParseNode *item;			// item leading to this node (NULL at the root)
+    vector <TrieNode *> children;	// ways to continue, in the order first seen
+    map <string, TrieNode *> index;	// children by item key
+    bool member_end;			// set if a member ends here
+  };
+
+  vector <Member> members;		// members in the order given
+  vector <TrieNode *> trie;		// trie nodes (the first is the root)
+  vector <ParseNode *> nodes;		// nodes added to join the members
+  ParseNode *root;			// root of the combined tree
+  set <char> punct_marks;		// punctuation marks of all members
+  unsigned int item_count;		// items in all members
+  unsigned int shared_count;		// items shared with an earlier member
+
+  // builds the part of the combined tree that follows a trie node (NULL if
+  // only the empty string follows)
+  ParseNode *build_tree(TrieNode *node);
+
+  // returns an alternation of branches[first..last), balanced so that the
+  // NFA build copies each branch a logarithmic number of times
+  ParseNode *build_alternation(const vector <ParseNode *> &branches,
+                               unsigned int first, unsigned int last);
+
+  // returns a key that is the same for structurally identical subtrees
+  static string node_key(ParseNode *node);
+
+  // numbers the backreferences of a member from first (backreference ids
+  // must be unique in the combined tree), returns the next free id
+  static int renumber_backreferences(ParseNode *node, int first);
+
+  ParseNode *add_node(ParseNode *node) { nodes.push_back(node); return node; }
+
+  RegexSet(const RegexSet &other);
+  RegexSet &operator= (const RegexSet &other);
+};
+
+#endif // REGEX_SET_H
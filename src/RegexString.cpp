@@ -27,35 +27,36 @@
 using namespace std;
 
 void
-RegexString::process_min_iter_string(StringPath *min_iter_string)
+RegexString::process_min_iter_string(StringPath *min_iter_string, const StringPath &substring)
 {
   if (repeat_lower != 0) {
-    min_iter_string->add_path(get_substring());
+    min_iter_string->add_path(substring);
   }
 }
 
-set <StringPath, spcompare>
-RegexString::gen_evil_strings(StringPath path_string, const set <char> &punct_marks)
+vector <StringPath>
+RegexString::gen_evil_strings(const StringPath &path_prefix, const StringPath &substring,
+                              const StringPath &path_string, const set <char> &punct_marks)
 {
-  set <StringPath, spcompare> evil_substrings;
-  set <StringPath, spcompare> evil_strings;
+  vector <StringPath> evil_substrings;
+  vector <StringPath> evil_strings;
 
   // insert one letter strings
   StringPath a;
   a.add_string("");
-  evil_substrings.insert(a);
+  evil_substrings.push_back(move(a));
   StringPath b;
   b.add_string("_");
-  evil_substrings.insert(b);
+  evil_substrings.push_back(move(b));
   StringPath c;
   c.add_string("6");
-  evil_substrings.insert(c);
+  evil_substrings.push_back(move(c));
   StringPath d;
   d.add_string(" ");
-  evil_substrings.insert(d);
+  evil_substrings.push_back(move(d));
   StringPath e;
   e.add_path_item(substring.path[0]);
-  evil_substrings.insert(e);
+  evil_substrings.push_back(move(e));
 
   // insert strings with added digit, space, and underscore
   int half = substring.path.size() / 2;
@@ -69,17 +70,17 @@ RegexString::gen_evil_strings(StringPath path_string, const set <char> &punct_ma
   f.add_path(first_half);
   f.add_string("4");
   f.add_path(second_half);
-  evil_substrings.insert(f);
+  evil_substrings.push_back(move(f));
   StringPath g;
   g.add_path(first_half);
   g.add_string(" ");
   g.add_path(second_half);
-  evil_substrings.insert(g);
+  evil_substrings.push_back(move(g));
   StringPath h;
   h.add_path(first_half);
   h.add_string("_");
   h.add_path(second_half);
-  evil_substrings.insert(h);
+  evil_substrings.push_back(move(h));
 
   // insert all uppercase and all lowercase
   StringPath all_upper;
@@ -87,32 +88,39 @@ RegexString::gen_evil_strings(StringPath path_string, const set <char> &punct_ma
   for (unsigned int i = 0; i < substring.path.size(); i++) {
     all_upper.add_path_item(substring.path[i]);
     all_lower.add_path_item(substring.path[i]);
-    char s = substring.path[i].item;
-    s = std::toupper(s, std::locale());
-    all_upper.path[i].item = s;
-    s = std::tolower(s, std::locale());
-    all_lower.path[i].item = s;
+    unsigned int c = substring.path[i].item;
+    if (c < 0x80) {
+      char s = c;
+      s = std::toupper(s, std::locale());
+      all_upper.path[i].item = s;
+      s = std::tolower(s, std::locale());
+      all_lower.path[i].item = s;
+    }
   }
-  evil_substrings.insert(all_upper);
-  evil_substrings.insert(all_lower);
+  evil_substrings.push_back(move(all_upper));
+  evil_substrings.push_back(move(all_lower));
 
   // insert mixed case where first character is lowercase and second character
   // is uppercase
   StringPath first;
   first.add_path_item(substring.path[0]);
-  char s1 = first.path[0].item;
-  s1 = std::tolower(s1, std::locale());
-  first.path[0].item = s1;
+  if (first.path[0].item < 0x80) {
+    char s1 = first.path[0].item;
+    s1 = std::tolower(s1, std::locale());
+    first.path[0].item = s1;
+  }
   StringPath second;
   second.add_path_item(substring.path[1]);
-  char s2 = second.path[0].item;
-  s2 = std::toupper(s2, std::locale());
-  second.path[0].item = s2;
+  if (second.path[0].item < 0x80) {
+    char s2 = second.path[0].item;
+    s2 = std::toupper(s2, std::locale());
+    second.path[0].item = s2;
+  }
   StringPath mixed;
   mixed.add_path(first);
   mixed.add_path(second);
   for(unsigned int i = 2; i < substring.path.size(); i++) mixed.add_path_item(substring.path[i]);
-  evil_substrings.insert(mixed);  
+  evil_substrings.push_back(move(mixed));  
   
   if (char_set->allows_punctuation()) {
     set <char>::iterator it;
@@ -120,24 +128,24 @@ RegexString::gen_evil_strings(StringPath path_string, const set <char> &punct_ma
       StringPath p;
       string s = string(1, *it);
       p.add_string(s);
-      evil_substrings.insert(p);
+      evil_substrings.push_back(move(p));
     }
   }
 
-  // generate the new full strings
+  // generate the new full strings (the string for the last substring is
+  // output first)
   StringPath path_suffix;
   int start = path_prefix.path.size() + substring.path.size();
   int end = path_string.path.size();
   for(int i = start; i < end; i++) path_suffix.add_path_item(path_string.path[i]);
-  set <StringPath, spcompare>::iterator it;
+  vector <StringPath>::reverse_iterator it;
   
-  for (it = evil_substrings.begin(); it != evil_substrings.end(); it++) {
+  for (it = evil_substrings.rbegin(); it != evil_substrings.rend(); it++) {
     StringPath new_string;
     new_string.add_path(path_prefix);
-    StringPath ptr = *it;
-    new_string.add_path(ptr);
+    new_string.add_path(*it);
     new_string.add_path(path_suffix);
-    evil_strings.insert(new_string);
+    evil_strings.push_back(move(new_string));
   }
 
   return evil_strings;
@@ -24,6 +24,7 @@
 
 #include <set>
 #include <string>
+#include <vector>
 #include "CharSet.h"
 #include "StringPath.h"
 using namespace std;
@@ -38,15 +39,20 @@ public:
     repeat_upper = upper;
   }
 
-  void set_path_prefix(StringPath p) { path_prefix = p; }
-  void set_substring(StringPath s) { substring = s; }
-  StringPath get_substring() { return substring; }
+  CharSet *get_char_set() { return char_set; }
+  int get_lower() { return repeat_lower; }
+  int get_upper() { return repeat_upper; }
 
-  // process minimum iterations string
-  void process_min_iter_string(StringPath *min_iter_string);
+  // process minimum iterations string (substring is the string used for
+  // this regex string)
+  void process_min_iter_string(StringPath *min_iter_string, const StringPath &substring);
 
-  // generate evil strings
-  set <StringPath, spcompare> gen_evil_strings(StringPath path_string, const set <char> &punct_marks);
+  // generate evil strings from the path string before the regex string and
+  // the string used for it (in the order they are output)
+  vector <StringPath> gen_evil_strings(const StringPath &path_prefix,
+                                       const StringPath &substring,
+                                       const StringPath &path_string,
+                                       const set <char> &punct_marks);
 
   // print the regex string
   void print();
@@ -55,8 +61,6 @@ private:
   CharSet *char_set;		// corresponding character set
   int repeat_lower;     	// lower bound for string
   int repeat_upper;     	// upper bound for string
-  StringPath path_prefix;           // path string up to visiting this node
-  StringPath substring;             // substring corresponding to this string
 };
 
 #endif // REGEX_STRING_H
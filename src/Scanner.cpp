@@ -29,18 +29,29 @@
 #include <vector>
 #include "Scanner.h"
 #include "Stats.h"
+#include "UnicodeTables.h"
+#include "Utf8.h"
 #include "error.h"
 
 using namespace std;
 
+// returns the code point of a CHARACTER token
+static unsigned int
+token_code_point(const Token &token)
+{
+  if (token.code_point != 0) return token.code_point;
+  return (unsigned char) token.character;
+}
+
 void
-Scanner::init(string in)
+Scanner::init(const string &in)
 {
   unsigned int idx = 0;
   bool in_set = false;	// set to true when in the middle of set [] 
   while (idx < in.length()) {
 
     Token token;
+    unsigned int start = idx;
     switch (in[idx]) {
 
     case '\\':
@@ -88,7 +99,6 @@ Scanner::init(string in)
 	case 'r':
 	case 't':
 	case 'v':
-	case 'p':
 	{
 	  stringstream s;
 	  s << "ERROR: contains unsupported character \\" << c;
@@ -111,7 +121,13 @@ Scanner::init(string in)
 	  token = process_octal(in, idx, c);
 	  break;
 	case 'x':
-	  token = process_hex(in, idx, 2);
+	  // \x{...} has as many digits as the braces hold
+	  if (idx + 1 < in.length() && in[idx + 1] == '{') {
+	    token = process_hex(in, idx, 0);
+	  }
+	  else {
+	    token = process_hex(in, idx, 2);
+	  }
 	  break;
 	case 'u':
 	  token = process_hex(in, idx, 4);
@@ -119,10 +135,20 @@ Scanner::init(string in)
 	case 'U':
 	  token = process_hex(in, idx, 8);
 	  break;
+	// Unicode properties
+	case 'p':
+	case 'P':
+	  token = process_property(in, idx, c);
+	  break;
 	// Everything else is a character - used for \(, \$, etc. 
 	default:
-	  token.type = CHARACTER;
-	  token.character = c;
+	  if ((unsigned char) c >= 0x80) {
+	    token = process_utf8(in, idx);
+	  }
+	  else {
+	    token.type = CHARACTER;
+	    token.character = c;
+	  }
       }
       break;
     }
@@ -199,10 +225,10 @@ Scanner::init(string in)
         token.character = in[idx];
       }
       // check for lazy '*?' --> Kleene star
-      // (no distinction is made for lazy version)
       else if (!in_set && (idx + 1) < in.length() && in[idx + 1] == '?') {
 	idx++; // skip over the '?'
 	token.type = STAR;
+	token.lazy = true;
       }
       // otherwise --> Kleene star
       else {
@@ -217,10 +243,10 @@ Scanner::init(string in)
         token.character = in[idx];
       }
       // check for lazy '+?' --> plus
-      // (no distinction is made for lazy version)
       else if (!in_set && (idx + 1) < in.length() && in[idx + 1] == '?') {
 	idx++; // skip over the '?'
 	token.type = PLUS;
+	token.lazy = true;
       }
       // otherwise --> plus (1 or more repetition)
       else {
@@ -239,10 +265,10 @@ Scanner::init(string in)
         token.character = in[idx];
       }
       // check for lazy '??' --> optional operator
-      // (no distinction is made for lazy version)
       else if (!in_set && (idx + 1) < in.length() && in[idx + 1] == '?') {
 	idx++; // skip over the second '?'
 	token.type = QUESTION;
+	token.lazy = true;
       }
       // otherwise --> optional operator (matches 0 or 1)
       else {
@@ -299,6 +325,7 @@ Scanner::init(string in)
         // check for lazy repeat - skip over the '?' if present
         if (token.type != CHARACTER && (idx + 1) < in.length() && in[idx + 1] == '?') {
 	  idx++;
+	  token.lazy = true;
         }
       }
       break;
@@ -312,19 +339,27 @@ Scanner::init(string in)
       break;
 
     default:
-      token.type = CHARACTER;
-      token.character = in[idx];
+      if ((unsigned char) in[idx] >= 0x80) {
+	token = process_utf8(in, idx);
+      }
+      else {
+	token.type = CHARACTER;
+	token.character = in[idx];
+      }
     }
 
+    token.start = start;
+    token.end = idx + 1;
     tokens.push_back(token);
     idx++;
   }
   
+  length = in.length();
   index = 0;
 }
 
 char
-Scanner::get_next_char(string in, unsigned int &idx)
+Scanner::get_next_char(const string &in, unsigned int &idx)
 {
   idx++;
   if (idx >= in.length()) {
@@ -334,7 +369,7 @@ Scanner::get_next_char(string in, unsigned int &idx)
 }
 
 Token
-Scanner::process_octal(string in, unsigned int &idx, char first_digit)
+Scanner::process_octal(const string &in, unsigned int &idx, char first_digit)
 {
   bool octal_found = false;
   bool only_one_digit = false;
@@ -405,71 +440,111 @@ Scanner::process_octal(string in, unsigned int &idx, char first_digit)
 }
     
 Token
-Scanner::process_hex(string in, unsigned int &idx, int num_digits)
+Scanner::process_hex(const string &in, unsigned int &idx, int num_digits)
 {
-  // if number of digits is greater than 2, the extra (left) digits must be zero
-  // as no unicode (outside ascii) are supported.
-  for (int i = 2; i < num_digits; i++) {
-    char d = get_next_char(in, idx);
-    if (d != '0') {
+  // compute the hex value (in braces if there is no fixed number of digits)
+  bool braced = num_digits == 0;
+  if (braced) get_next_char(in, idx);
+  unsigned int hex_value = 0;
+  for (int i = 0; braced || i < num_digits; i++) {
+    char digit = get_next_char(in, idx);
+    if (braced && digit == '}' && i > 0) break;
+    if (hex_value > 0x10FFFF) {
+      stringstream s;
+      s << "ERROR: contains unsupported hex value " << hex_value;
+      throw EgretException(s.str());
+    }
+    if (digit >= '0' && digit <= '9') {
+      hex_value = hex_value * 16 + (digit - '0');
+    }
+    else if (digit >= 'A' && digit <= 'F') {
+      hex_value = hex_value * 16 + (digit - 'A' + 10);
+    }
+    else if (digit >= 'a' && digit <= 'f') {
+      hex_value = hex_value * 16 + (digit - 'a' + 10);
+    }
+    else {
       stringstream s;
-      s << "ERROR: Unsupported " << num_digits << "-digit hex number";
+      s << "ERROR: Invalid hex digit " << digit;
       throw EgretException(s.str());
     }
   }
 
-  // get the new two characters which must be hex digits
-  char first_digit = get_next_char(in, idx);
-  char second_digit = get_next_char(in, idx);
+  // check the validity of the hex value (no control characters)
+  if (hex_value < 32 || (hex_value >= 127 && hex_value < 160) || !is_valid_code_point(hex_value)) {
+    stringstream s;
+    s << "ERROR: contains unsupported hex value " << hex_value;
+    throw EgretException(s.str());
+  }
 
-  // compute the hex value
-  int hex_value;
-  if (first_digit >= '0' && first_digit <= '9') {
-    hex_value = (first_digit - '0') * 16;
+  // return the hex value
+  Token token;
+  token.type = CHARACTER;
+  if (hex_value < 0x80) {
+    token.character = hex_value;
   }
-  else if (first_digit >= 'A' && first_digit <= 'F') {
-    hex_value = (first_digit - 'A' + 10) * 16;
+  else {
+    token.character = 0;
+    token.code_point = hex_value;
   }
-  else if (first_digit >= 'a' && first_digit <= 'f') {
-    hex_value = (first_digit - 'a' + 10) * 16;
+
+  return token;
+}
+
+Token
+Scanner::process_utf8(const string &in, unsigned int &idx)
+{
+  unsigned int cp;
+  unsigned int next = idx;
+  if (!utf8_decode(in, next, cp)) {
+    throw EgretException("ERROR: Regex is not valid UTF-8");
   }
-  else {
+  if (cp < 160) {
     stringstream s;
-    s << "ERROR: Invalid hex digit " << first_digit;
+    s << "ERROR: contains unsupported character value " << cp;
     throw EgretException(s.str());
   }
-  if (second_digit >= '0' && second_digit <= '9') {
-    hex_value += (second_digit - '0');
-  }
-  else if (second_digit >= 'A' && second_digit <= 'F') {
-    hex_value += (second_digit - 'A' + 10);
-  }
-  else if (second_digit >= 'a' && second_digit <= 'f') {
-    hex_value += (second_digit - 'a' + 10);
+  idx = next - 1;	// idx is left on the last byte of the character
+
+  Token token;
+  token.type = CHARACTER;
+  token.character = 0;
+  token.code_point = cp;
+  return token;
+}
+
+Token
+Scanner::process_property(const string &in, unsigned int &idx, char c)
+{
+  // name is a single letter (\pL) or in braces (\p{Lu})
+  string name = "";
+  char next = get_next_char(in, idx);
+  if (next != '{') {
+    name += next;
   }
   else {
-    stringstream s;
-    s << "ERROR: Invalid hex digit " << second_digit;
-    throw EgretException(s.str());
+    next = get_next_char(in, idx);
+    while (next != '}') {
+      name += next;
+      next = get_next_char(in, idx);
+    }
   }
 
-  // check the validity of the hex value
-  if (hex_value < 32 || hex_value > 126) {
+  if (find_unicode_property(name) == NULL) {
     stringstream s;
-    s << "ERROR: contains unsupported hex value " << hex_value;
+    s << "ERROR: Unsupported Unicode property \\" << c << "{" << name << "}";
     throw EgretException(s.str());
   }
 
-  // return the hex value
   Token token;
-  token.type = CHARACTER;
-  token.character = hex_value;
-
+  token.type = CHAR_CLASS;
+  token.character = c;
+  token.name = name;
   return token;
 }
 
 Token
-Scanner::process_extension(string in, unsigned int &idx)
+Scanner::process_extension(const string &in, unsigned int &idx)
 {
   Token token;
 
@@ -553,7 +628,7 @@ Scanner::process_extension(string in, unsigned int &idx)
 }
 
 Token
-Scanner::process_repeat(string in, unsigned int &idx)
+Scanner::process_repeat(const string &in, unsigned int &idx)
 {
   // Based on execution of Python, the repeat quantifier must have one of these forms:
   // {n}  	: matches exactly n times
@@ -725,15 +800,51 @@ Scanner::get_character()
   return tokens[index].character;
 }
 
+unsigned int
+Scanner::get_code_point()
+{
+  TokenType type = get_type();
+  assert(type == CHARACTER);
+
+  return token_code_point(tokens[index]);
+}
+
 string
 Scanner::get_name()
 {
   TokenType type = get_type();
-  assert(type == BACKREFERENCE || type == NAMED_GROUP_EXT);
+  assert(type == BACKREFERENCE || type == NAMED_GROUP_EXT || type == CHAR_CLASS);
 
   return tokens[index].name;
 }
 
+bool
+Scanner::is_lazy()
+{
+  TokenType type = get_type();
+  assert(type == STAR || type == PLUS || type == QUESTION || type == REPEAT);
+
+  return tokens[index].lazy;
+}
+
+unsigned int
+Scanner::get_start()
+{
+  if (index < tokens.size())
+    return tokens[index].start;
+  else
+    return length;
+}
+
+unsigned int
+Scanner::get_prev_end()
+{
+  if (index > 0 && index <= tokens.size())
+    return tokens[index - 1].end;
+  else
+    return 0;
+}
+
 int
 Scanner::get_backref_value()
 {
@@ -791,11 +902,11 @@ Scanner::is_char_range()
 
   if (tokens[index].type == CHARACTER &&
       tokens[index+2].type == CHARACTER) {
-    if (tokens[index].character > tokens[index+2].character) {
+    if (token_code_point(tokens[index]) > token_code_point(tokens[index+2])) {
       stringstream s;
       s << "ERROR: Improperly formed range "
-        << tokens[index].character << "-"
-	<< tokens[index+2].character << endl;
+        << utf8_encode(token_code_point(tokens[index])) << "-"
+	<< utf8_encode(token_code_point(tokens[index+2])) << endl;
       throw EgretException(s.str());
     }
     return true;
@@ -824,8 +935,11 @@ Scanner::print()
     if (tokens[i].type == REPEAT) {
       cout << ":" << tokens[i].repeat_lower << "," << tokens[i].repeat_upper;
     }
-    if (tokens[i].type == CHARACTER || tokens[i].type == CHAR_CLASS) {
-      cout << ":" << tokens[i].character;
+    if (tokens[i].type == CHARACTER) {
+      cout << ":" << utf8_encode(token_code_point(tokens[i]));
+    }
+    if (tokens[i].type == CHAR_CLASS) {
+      cout << ":" << tokens[i].character << tokens[i].name;
     }
     cout << endl;
   }
@@ -865,4 +979,5 @@ void
 Scanner::add_stats(Stats &stats)
 {
   stats.add("SCANNER", "Tokens", tokens.size());
+  stats.add("SCANNER", "Token bytes", tokens.capacity() * sizeof(Token));
 }
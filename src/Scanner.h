@@ -57,12 +57,18 @@ typedef enum
 
 struct Token
 {
+  Token() { code_point = 0; lazy = false; start = 0; end = 0; }
+
   TokenType type;
   int repeat_lower;	// for REPEAT
   int repeat_upper;	// for REPEAT (-1 for no limit)
   char character;	// for CHARACTER and CHAR_CLASS
+  unsigned int code_point;	// for CHARACTER outside ASCII (0 otherwise)
   int backref_value;  // for BACKREFERENCE
-  string name;  // FOR BACKREFERENCE
+  string name;  // FOR BACKREFERENCE and Unicode property CHAR_CLASS (\p, \P)
+  bool lazy;		// for STAR, PLUS, QUESTION, and REPEAT (set for *?, +?, ??, {n,m}?)
+  unsigned int start;	// index in the regex where the token starts
+  unsigned int end;	// index in the regex just past the token
 };
 
 // A scanner class, encapsulates the input stream as a set of tokens
@@ -71,7 +77,7 @@ class Scanner {
 
 public:
   // scans through input string and creates a vector of tokens
-  void init(string in);
+  void init(const string &in);
 
   // returns type for current token
   TokenType get_type();
@@ -88,6 +94,19 @@ public:
   // returns character associated with current token
   char get_character();
 
+  // returns code point associated with current CHARACTER token
+  unsigned int get_code_point();
+
+  // returns true if the current repetition token is lazy
+  bool is_lazy();
+
+  // returns where the current token starts in the regex (the length of the
+  // regex at the end)
+  unsigned int get_start();
+
+  // returns where the previous token ends in the regex
+  unsigned int get_prev_end();
+
   // returns the backreference value (group number for referenced group)
   int get_backref_value();
 
@@ -113,21 +132,28 @@ private:
 
   vector <Token> tokens;	// stores the regular expression
   unsigned index;		// iterator
+  unsigned int length;		// length of the regex
 
   // get next character from input string
-  char get_next_char(string in, unsigned int &idx);
+  char get_next_char(const string &in, unsigned int &idx);
 
   // process octal character 
-  Token process_octal(string in, unsigned int &idx, char first_digit);
+  Token process_octal(const string &in, unsigned int &idx, char first_digit);
+
+  // process hexadecimal character (num_digits is 0 for the braced form)
+  Token process_hex(const string &in, unsigned int &idx, int num_digits);
+
+  // process a character outside ASCII (UTF-8 encoded)
+  Token process_utf8(const string &in, unsigned int &idx);
 
-  // process hexadecimal character 
-  Token process_hex(string in, unsigned int &idx, int num_digits);
+  // process Unicode property class \p{name} or \P{name}
+  Token process_property(const string &in, unsigned int &idx, char c);
 
   // processes Python extensions for regular expressions
-  Token process_extension(string in, unsigned int &idx);
+  Token process_extension(const string &in, unsigned int &idx);
 
   // process a repeat quantifier {}
-  Token process_repeat(string in, unsigned int &idx);
+  Token process_repeat(const string &in, unsigned int &idx);
 
   // returns string name of a token
   string token_type_to_str(TokenType type);
@@ -0,0 +1,42 @@
+/*  Sink.h: receiver for generated test strings
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SINK_H
+#define SINK_H
+
+#include <functional>
+#include <string>
+using namespace std;
+
+// A string sink is called once for each test string as it is generated.
+typedef function <void (const string &)> StringSink;
+
+// where a test string came from
+typedef enum {
+  FROM_INITIAL,			// initial string for a path
+  FROM_BACKREFERENCE,		// evil backreference string
+  FROM_EVIL			// evil string for a path
+} StringSource;
+
+// A source sink also receives where each test string came from.
+typedef function <void (const string &, StringSource)> SourceSink;
+
+#endif // SINK_H
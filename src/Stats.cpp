@@ -27,12 +27,18 @@
 using namespace std;
 
 void
-Stats::add(string tag, string name, int value)
+Stats::add(string tag, string name, long value)
 {
   Stat stat = { tag, name, value };
   statList.push_back(stat);
 }
 
+void
+Stats::add(const Stats &other)
+{
+  statList.insert(statList.end(), other.statList.begin(), other.statList.end());
+}
+
 void
 Stats::print()
 {
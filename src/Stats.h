@@ -22,6 +22,7 @@
 #ifndef STATS_H
 #define STATS_H
 
+#include <string>
 #include <vector>
 using namespace std;
 
@@ -29,19 +30,26 @@ class Stats
 {
 
 public:
+
+  struct Stat {
+    string tag;
+    string name;
+    long value;
+  };
+
   // adds a stat to the list of stats
-  void add(string tag, string name, int value);
+  void add(string tag, string name, long value);
+
+  // adds the stats of other (in their order)
+  void add(const Stats &other);
 
   // print the stats
   void print();
 
-private:
+  // returns the stats in the order they were added
+  const vector <Stat> &get_stats() const { return statList; }
 
-  struct Stat {
-    string tag;
-    string name;
-    int value;
-  };
+private:
 
   vector <Stat> statList;
 };
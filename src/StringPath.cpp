@@ -2,37 +2,33 @@
 #include <vector>
 #include <string>
 #include <unordered_map>
-#include <algorithm>
+#include <unordered_set>
 #include "StringPath.h"
+#include "Utf8.h"
 using namespace std;
 
 StringPath
-StringPath::path_from_string(string s)
+StringPath::path_from_string(const string &s)
 {
   StringPath p;
-  StringPathItem spi;
-  for(unsigned int i = 0; i < s.length(); i++) {
-    spi.item = s[i];
-    spi.type = CHAR;
-    p.path.push_back(spi);
-  }
+  p.add_string(s);
   return p;
 }
 
 string
-StringPath::get_string()
+StringPath::get_string() const
 {
   vector <int> groups;
   vector <int>::iterator git;
   unordered_map <int, string> group_strings {};  
   string s = "";
-  vector <StringPathItem>::iterator it;
+  vector <StringPathItem>::const_iterator it;
   
   for (it = path.begin(); it != path.end(); it++) {
     if(it->type == CHAR) {
-      s += it->item;
+      utf8_append(s, it->item);
       for(git = groups.begin(); git != groups.end(); git++) {
-        group_strings[*git] += it->item;
+        utf8_append(group_strings[*git], it->item);
       }
     }
     else if(it->type == BG) {
@@ -55,21 +51,27 @@ StringPath::get_string()
 }
 
 vector<string>
-StringPath::gen_evil_backreference_strings(vector <int> &backrefs_done)
+StringPath::gen_evil_backreference_strings(unordered_set <int> &backrefs_done)
 {
   vector <string> ret_strings;
-  vector <int> backrefs;
   vector <StringPathItem>::iterator it;
-  
-  // get list of group strings and of local backreferences
+
+  // one pass over the path collects the group strings and the position of
+  // each backreference in the path
   vector <int> groups;
   vector <int>::iterator git;
   unordered_map <int, string> group_strings {};
-  
+  vector <unsigned int> chars_before;	// characters before each backreference
+  vector <StringPathItem *> sites;	// backreferences in path order
+  vector <int> backrefs;		// backreferences to generate evilness for
+  unordered_map <int, vector <unsigned int> > sites_by_id;
+  string chars;				// the characters of the path
+
   for (it = path.begin(); it != path.end(); it++) {
     if(it->type == CHAR) {
+      utf8_append(chars, it->item);
       for(git = groups.begin(); git != groups.end(); git++) {
-	group_strings[*git] += it->item;
+	utf8_append(group_strings[*git], it->item);
       }
     }
     else if(it->type == BG) {
@@ -81,82 +83,90 @@ StringPath::gen_evil_backreference_strings(vector <int> &backrefs_done)
       }
     }
     else if(it->type == BR) {
-      if(!(std::find(backrefs_done.begin(), backrefs_done.end(), it->id) != backrefs_done.end())) {
+      if(backrefs_done.insert(it->id).second) {
 	backrefs.push_back(it->id);
-	backrefs_done.push_back(it->id);
       }
+      sites_by_id[it->id].push_back(sites.size());
+      chars_before.push_back(chars.length());
+      sites.push_back(&*it);
       for(git = groups.begin(); git != groups.end(); git++) {
 	group_strings[*git] += group_strings[it->num];
       }
     }
   }
+  if (backrefs.empty()) return ret_strings;
+
+  // every backreference is replaced by the final string of its group, so
+  // a variant is the characters of the path with those strings spliced in
+  // and the strings of one backreference edited
+  vector <string> expanded(sites.size());
+  for (unsigned int i = 0; i < sites.size(); i++) {
+    expanded[i] = group_strings[sites[i]->num];
+  }
 
-  // generate evilness
   vector <int>::iterator bit;
-  string add;
-  string remove;
-  string modify;
-  string temp;
   for (bit = backrefs.begin(); bit != backrefs.end(); bit++) {
-    add = "";
-    remove = "";
-    modify = "";
-    for (it = path.begin(); it != path.end(); it++) {
-      if(it->type == CHAR) {
-	temp = it->item;
-	add += temp;
-	remove += temp;
-	modify += temp;
+    vector <string> edits[3];	// add, remove, and modify for each site
+    const vector <unsigned int> &own = sites_by_id[*bit];
+    for (unsigned int k = 0; k < own.size(); k++) {
+      // work on code points so that UTF-8 characters stay whole
+      const string &temp = expanded[own[k]];
+      vector <unsigned int> cps;
+      if (!utf8_code_points(temp, cps) || cps.empty()) {
+	for (int e = 0; e < 3; e++) edits[e].push_back(temp);
+	continue;
       }
-      else if(it->type == BR) {
-	if(it->id == *bit) {
-	  // found backref to generate evilness for
-	  // add
-	  temp = group_strings[it->num];
-	  temp.push_back(temp.back());
-	  add += temp;
-	  // remove
-	  temp = group_strings[it->num];
-	  if(temp.length() > 0) {
-	    temp.pop_back();
-	  }
-	  remove += temp;
-	  // modify
-	  temp = group_strings[it->num];
-	  int edit = temp.length()/2;
-	  char c = temp[edit];
-	  c += 1;
-	  temp[edit] = c;
-	  modify += temp;
+      // add
+      vector <unsigned int> edited = cps;
+      edited.push_back(edited.back());
+      edits[0].push_back(utf8_encode(edited));
+      // remove
+      edited = cps;
+      edited.pop_back();
+      edits[1].push_back(utf8_encode(edited));
+      // modify
+      edited = cps;
+      int edit = edited.size()/2;
+      edited[edit] += 1;
+      if (!is_valid_code_point(edited[edit])) edited[edit] -= 2;
+      edits[2].push_back(utf8_encode(edited));
+    }
+
+    for (int e = 0; e < 3; e++) {
+      string variant;
+      unsigned int done = 0;	// characters of the path copied so far
+      unsigned int next_own = 0;
+      for (unsigned int i = 0; i < sites.size(); i++) {
+	variant.append(chars, done, chars_before[i] - done);
+	done = chars_before[i];
+	if (next_own < own.size() && own[next_own] == i) {
+	  variant += edits[e][next_own++];
 	}
 	else {
-	  // normal backref substitution
-	  temp = group_strings[it->num];
-	  add += temp;
-	  remove += temp;
-	  modify += temp;
+	  variant += expanded[i];
 	}
       }
+      variant.append(chars, done, string::npos);
+      ret_strings.push_back(variant);
     }
-    ret_strings.push_back(add);
-    ret_strings.push_back(remove);
-    ret_strings.push_back(modify);
   }
-  
+
   // return final list
   return ret_strings;
 }
 
 void
-StringPath::add_path(StringPath path2)
+StringPath::add_path(const StringPath &path2)
 {
+  COUNT(STRING_PATH_APPENDS);
+  if (path.size() + path2.path.size() > path.capacity()) COUNT(STRING_PATH_GROWTHS);
   path.insert(path.end(), path2.path.begin(), path2.path.end());
 }
 
 void
 StringPath::add_path_item(StringPathItem item)
 {
-  path.push_back(item);
+  append(item);
 }
 
 void StringPath::add_backreference(int _num, int _id)
@@ -165,7 +175,7 @@ void StringPath::add_backreference(int _num, int _id)
   spi.type = BR;
   spi.num = _num;
   spi.id = _id;
-  path.push_back(spi);
+  append(spi);
 }
 
 void StringPath::add_begin_group(int _num)
@@ -173,7 +183,7 @@ void StringPath::add_begin_group(int _num)
   StringPathItem spi;
   spi.type = BG;
   spi.num = _num;
-  path.push_back(spi);
+  append(spi);
 }
 
 void StringPath::add_end_group(int _num)
@@ -181,18 +191,23 @@ void StringPath::add_end_group(int _num)
   StringPathItem spi;
   spi.type = EG;
   spi.num = _num;
-  path.push_back(spi);
+  append(spi);
 }
 
 void
-StringPath::add_string(string s)
+StringPath::add_string(const string &s)
 {
+  // one item per character (a byte that is not valid UTF-8 is kept as is)
   StringPathItem spi;
-  for(unsigned int i = 0; i < s.length(); i++) {
-    spi.item = s[i];
+  unsigned int i = 0;
+  while (i < s.length()) {
+    if (!utf8_decode(s, i, spi.item)) {
+      spi.item = (unsigned char) s[i];
+      i++;
+    }
     spi.type = CHAR;
     spi.num = -1;
-    path.push_back(spi);
+    append(spi);
   }
 }
 
@@ -200,12 +215,12 @@ void
 StringPath::add_char(char c)
 {
   StringPathItem spi;
-  spi.item = c;
+  spi.item = (unsigned char) c;
   spi.type = CHAR;
   spi.num = -1;
   try
     {
-      path.push_back(spi);
+      append(spi);
     }
   catch (std::bad_alloc& ba)
     {
@@ -2,7 +2,9 @@
 #define STRING_PATH_H
 
 #include <string>
+#include <unordered_set>
 #include <vector>
+#include "Counters.h"
 using namespace std;
 // types are : CHAR - character, BG - begin group, EG - end group, BR -backreference
 typedef enum {
@@ -15,36 +17,48 @@ typedef enum {
 struct StringPathItem
 {
   ItemType type;
-  char item;
+  unsigned int item;	// code point (for CHAR)
   int num;
   int id;
 };
 
-struct spcompare {
-    template<typename T>
-    bool operator()(T const& left, T const& right) { return true; }
-};
-
 class StringPath {
  public:
   StringPath(){}
+  StringPath(const StringPath &other) : path(other.path) { COUNT(STRING_PATH_COPIES); }
+  StringPath(StringPath &&other) = default;
+  StringPath &operator= (const StringPath &other) {
+    COUNT(STRING_PATH_COPIES);
+    path = other.path;
+    return *this;
+  }
+  StringPath &operator= (StringPath &&other) = default;
 
-  StringPath path_from_string(string s);
-  string get_string();
-  vector<string> gen_evil_backreference_strings(vector <int> &backrefs_done);
-  void add_string(string s);
+  StringPath path_from_string(const string &s);
+  string get_string() const;
+  vector<string> gen_evil_backreference_strings(unordered_set <int> &backrefs_done);
+  void add_string(const string &s);
   void add_char(char c);
-  void add_path(StringPath path2);
+  void add_path(const StringPath &path2);
   void add_path_item(StringPathItem);
   void add_backreference(int _num, int _id);
   void add_begin_group(int _num);
   void add_end_group(int _num);
   void clear() { path.clear(); }
 
+  // returns the bytes held by the items (beyond the StringPath itself)
+  unsigned long get_memory() const { return path.capacity() * sizeof(StringPathItem); }
+
   vector <StringPathItem> path;
 
- //private:
-  
+ private:
+
+  // appends an item to the path
+  void append(const StringPathItem &item) {
+    COUNT(STRING_PATH_APPENDS);
+    if (path.size() == path.capacity()) COUNT(STRING_PATH_GROWTHS);
+    path.push_back(item);
+  }
 };
 
 #endif // STRING_PATH_H
@@ -0,0 +1,379 @@
+/*  SuiteFile.cpp: binary test suite files
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "SuiteFile.h"
+#include "egret.h"
+#include "error.h"
+using namespace std;
+
+static void put_u32(string &buf, uint32_t v);
+static void put_u64(string &buf, uint64_t v);
+static void set_u64(string &buf, size_t pos, uint64_t v);
+static void put_varint(string &buf, uint64_t v);
+static uint32_t get_u32(const unsigned char *p);
+static uint64_t get_u64(const unsigned char *p);
+
+uint64_t
+suite_fingerprint(const string &regex, const string &base_substring)
+{
+  uint64_t h = 14695981039346656037ULL;
+  string key = regex + '\0' + base_substring;
+  for (unsigned int i = 0; i < key.length(); i++) {
+    h ^= (unsigned char) key[i];
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+//=============================================================
+// Writer
+//=============================================================
+
+void
+SuiteWriter::add(const string &s, StringSource source)
+{
+  entries[s].sources |= SUITE_SOURCE_BIT(source);
+}
+
+void
+SuiteWriter::set_accepted(const string &s, bool accepted)
+{
+  has_accept = true;
+  entries[s].accepted = accepted;
+}
+
+void
+SuiteWriter::write(const string &file_name)
+{
+  string buf;
+  unsigned int count = entries.size();
+  unsigned int bitmap_size = (count + 7) / 8;
+
+  // header (offsets are filled in below)
+  buf.append(SUITE_MAGIC, 8);
+  put_u32(buf, SUITE_FORMAT_VERSION);
+  put_u32(buf, (has_accept ? SUITE_HAS_ACCEPT : 0) | SUITE_HAS_SOURCES);
+  put_u64(buf, fingerprint);
+  put_u32(buf, count);
+  put_u32(buf, SUITE_RESTART_INTERVAL);
+  put_u64(buf, 0);
+  put_u64(buf, 0);
+  put_u64(buf, 0);
+  put_u64(buf, 0);
+  char version[16];
+  memset(version, 0, sizeof(version));
+  strncpy(version, EGRET_VERSION, sizeof(version) - 1);
+  buf.append(version, sizeof(version));
+
+  // front coded strings
+  vector <uint64_t> restarts;
+  string accept_bits(bitmap_size, '\0');
+  string source_bits[3] = { string(bitmap_size, '\0'), string(bitmap_size, '\0'),
+                            string(bitmap_size, '\0') };
+  string prev = "";
+  unsigned int i = 0;
+  map <string, Entry>::iterator it;
+  for (it = entries.begin(); it != entries.end(); it++, i++) {
+    const string &s = it->first;
+    unsigned int shared = 0;
+    if (i % SUITE_RESTART_INTERVAL == 0) {
+      restarts.push_back(buf.length());
+    }
+    else {
+      while (shared < s.length() && shared < prev.length() && s[shared] == prev[shared])
+        shared++;
+    }
+    put_varint(buf, shared);
+    put_varint(buf, s.length() - shared);
+    buf.append(s, shared, string::npos);
+    prev = s;
+
+    if (it->second.accepted) accept_bits[i / 8] |= (1 << (i % 8));
+    for (int src = 0; src < 3; src++) {
+      if (it->second.sources & SUITE_SOURCE_BIT(src))
+        source_bits[src][i / 8] |= (1 << (i % 8));
+    }
+  }
+
+  // restart index
+  set_u64(buf, 32, buf.length());
+  for (unsigned int j = 0; j < restarts.size(); j++) {
+    put_u64(buf, restarts[j]);
+  }
+
+  // bitmaps
+  if (has_accept) {
+    set_u64(buf, 40, buf.length());
+    buf += accept_bits;
+  }
+  set_u64(buf, 48, buf.length());
+  for (int src = 0; src < 3; src++) {
+    buf += source_bits[src];
+  }
+
+  // status
+  set_u64(buf, 56, buf.length());
+  put_u32(buf, status.length());
+  buf += status;
+
+  ofstream out(file_name.c_str(), ios::binary | ios::trunc);
+  if (!out.is_open()) {
+    throw EgretException("ERROR: Unable to write suite file " + file_name);
+  }
+  out.write(buf.data(), buf.length());
+  out.close();
+  if (out.fail()) {
+    throw EgretException("ERROR: Unable to write suite file " + file_name);
+  }
+}
+
+//=============================================================
+// Reader
+//=============================================================
+
+SuiteReader::SuiteReader()
+{
+  data = NULL;
+  length = 0;
+  count = 0;
+  restart = 0;
+  index_pos = 0;
+  accept_pos = 0;
+  sources_pos = 0;
+  status_pos = 0;
+  fingerprint = 0;
+}
+
+SuiteReader::~SuiteReader()
+{
+  close();
+}
+
+void
+SuiteReader::open(const string &file_name)
+{
+  close();
+
+  int fd = ::open(file_name.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw EgretException("ERROR: Unable to open suite file " + file_name);
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < SUITE_HEADER_SIZE) {
+    ::close(fd);
+    throw EgretException("ERROR: Invalid suite file " + file_name);
+  }
+  void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED) {
+    throw EgretException("ERROR: Unable to map suite file " + file_name);
+  }
+  data = (const unsigned char *) map;
+  length = st.st_size;
+
+  // check header
+  count = get_u32(data + 24);
+  restart = get_u32(data + 28);
+  index_pos = get_u64(data + 32);
+  accept_pos = get_u64(data + 40);
+  sources_pos = get_u64(data + 48);
+  status_pos = get_u64(data + 56);
+  fingerprint = get_u64(data + 16);
+  unsigned int blocks = restart == 0 ? 0 : (count + restart - 1) / restart;
+  uint64_t bitmap_size = (count + 7) / 8;
+  if (memcmp(data, SUITE_MAGIC, 8) != 0
+      || get_u32(data + 8) != SUITE_FORMAT_VERSION
+      || restart == 0
+      || index_pos + 8 * (uint64_t) blocks > length
+      || (accept_pos != 0 && accept_pos + bitmap_size > length)
+      || (sources_pos != 0 && sources_pos + 3 * bitmap_size > length)
+      || status_pos + 4 > length
+      || status_pos + 4 + get_u32(data + status_pos) > length) {
+    close();
+    throw EgretException("ERROR: Invalid suite file " + file_name);
+  }
+  engine_version = string((const char *) data + 64, strnlen((const char *) data + 64, 16));
+}
+
+void
+SuiteReader::close()
+{
+  if (data != NULL) {
+    munmap((void *) data, length);
+  }
+  data = NULL;
+  length = 0;
+  count = 0;
+}
+
+string
+SuiteReader::get(unsigned int i)
+{
+  if (i >= count) {
+    throw EgretException("ERROR: Suite string index out of range");
+  }
+
+  // decode forward from the restart point
+  unsigned int block = i / restart;
+  uint64_t pos = get_u64(data + index_pos + 8 * block);
+  string s = "";
+  for (unsigned int j = block * restart; j <= i; j++) {
+    uint64_t shared = read_varint(pos);
+    uint64_t suffix = read_varint(pos);
+    if (shared > s.length() || pos + suffix > length) {
+      throw EgretException("ERROR: Corrupt suite file");
+    }
+    s.resize(shared);
+    s.append((const char *) data + pos, suffix);
+    pos += suffix;
+  }
+  return s;
+}
+
+int
+SuiteReader::find(const string &s)
+{
+  if (count == 0) return -1;
+
+  // find the last restart block starting at or before s
+  unsigned int blocks = (count + restart - 1) / restart;
+  unsigned int lo = 0;
+  unsigned int hi = blocks;
+  while (hi - lo > 1) {
+    unsigned int mid = (lo + hi) / 2;
+    if (get(mid * restart) <= s)
+      lo = mid;
+    else
+      hi = mid;
+  }
+
+  // scan the block
+  unsigned int end = (lo + 1) * restart;
+  if (end > count) end = count;
+  for (unsigned int i = lo * restart; i < end; i++) {
+    string t = get(i);
+    if (t == s) return i;
+    if (t > s) break;
+  }
+  return -1;
+}
+
+bool
+SuiteReader::has_source(unsigned int i, StringSource source)
+{
+  if (sources_pos == 0) return false;
+  return get_bit(sources_pos + (uint64_t) source * ((count + 7) / 8), i);
+}
+
+string
+SuiteReader::get_status()
+{
+  if (data == NULL) return "";
+  return string((const char *) data + status_pos + 4, get_u32(data + status_pos));
+}
+
+uint64_t
+SuiteReader::read_varint(uint64_t &pos)
+{
+  uint64_t v = 0;
+  int shift = 0;
+  while (pos < length && shift < 64) {
+    unsigned char b = data[pos++];
+    v |= (uint64_t) (b & 0x7f) << shift;
+    if (!(b & 0x80)) return v;
+    shift += 7;
+  }
+  throw EgretException("ERROR: Corrupt suite file");
+}
+
+bool
+SuiteReader::get_bit(uint64_t pos, unsigned int i)
+{
+  if (pos == 0 || i >= count) return false;
+  return (data[pos + i / 8] >> (i % 8)) & 1;
+}
+
+//=============================================================
+// Little endian helpers
+//=============================================================
+
+static void
+put_u32(string &buf, uint32_t v)
+{
+  for (int i = 0; i < 4; i++) {
+    buf += (char) ((v >> (8 * i)) & 0xff);
+  }
+}
+
+static void
+put_u64(string &buf, uint64_t v)
+{
+  for (int i = 0; i < 8; i++) {
+    buf += (char) ((v >> (8 * i)) & 0xff);
+  }
+}
+
+static void
+set_u64(string &buf, size_t pos, uint64_t v)
+{
+  for (int i = 0; i < 8; i++) {
+    buf[pos + i] = (char) ((v >> (8 * i)) & 0xff);
+  }
+}
+
+static void
+put_varint(string &buf, uint64_t v)
+{
+  while (v >= 0x80) {
+    buf += (char) ((v & 0x7f) | 0x80);
+    v >>= 7;
+  }
+  buf += (char) v;
+}
+
+static uint32_t
+get_u32(const unsigned char *p)
+{
+  uint32_t v = 0;
+  for (int i = 3; i >= 0; i--) {
+    v = (v << 8) | p[i];
+  }
+  return v;
+}
+
+static uint64_t
+get_u64(const unsigned char *p)
+{
+  uint64_t v = 0;
+  for (int i = 7; i >= 0; i--) {
+    v = (v << 8) | p[i];
+  }
+  return v;
+}
@@ -0,0 +1,174 @@
+/*  SuiteFile.h: binary test suite files
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// A suite file holds the test strings for one regex in a form that can be
+// mapped into memory and read in place.  All integers are little endian.
+//
+//   header (80 bytes)
+//     0   magic "EGRSUITE"
+//     8   u32 format version
+//     12  u32 flags (SUITE_HAS_ACCEPT, SUITE_HAS_SOURCES)
+//     16  u64 fingerprint of regex and base substring
+//     24  u32 number of strings
+//     28  u32 restart interval
+//     32  u64 offset of the restart index
+//     40  u64 offset of the accept bitmap (0 if none)
+//     48  u64 offset of the source bitmaps (0 if none)
+//     56  u64 offset of the status
+//     64  char[16] engine version (NUL padded)
+//   strings, sorted, front coded: each entry is a varint prefix length
+//     shared with the previous string, a varint suffix length, and the
+//     suffix bytes; the prefix length is 0 at every restart point
+//   restart index: u64 offset of each restart entry
+//   accept bitmap: bit i set if string i is accepted by the regex
+//   source bitmaps: initial, backreference and evil bitmaps, one after
+//     the other, bit i set if string i came from that source
+//   status: u32 length followed by the status text
+
+#ifndef SUITE_FILE_H
+#define SUITE_FILE_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include "Sink.h"
+using namespace std;
+
+#define SUITE_MAGIC "EGRSUITE"
+#define SUITE_FORMAT_VERSION 1
+#define SUITE_HEADER_SIZE 80
+#define SUITE_RESTART_INTERVAL 16
+
+// header flags
+#define SUITE_HAS_ACCEPT 0x1
+#define SUITE_HAS_SOURCES 0x2
+
+// source bits (one per StringSource)
+#define SUITE_SOURCE_BIT(source) (1 << (source))
+
+// returns the fingerprint of a regex and base substring (64-bit FNV-1a)
+uint64_t suite_fingerprint(const string &regex, const string &base_substring);
+
+class SuiteWriter {
+
+public:
+
+  SuiteWriter() { fingerprint = 0; has_accept = false; }
+
+  // adds a string (a string added more than once keeps all of its sources)
+  void add(const string &s, StringSource source);
+
+  // records whether the regex accepts a string that has been added
+  void set_accepted(const string &s, bool accepted);
+
+  // sets the fingerprint from the regex and base substring
+  void set_fingerprint(const string &regex, const string &base_substring) {
+    fingerprint = suite_fingerprint(regex, base_substring);
+  }
+
+  // sets the status of the run
+  void set_status(const string &s) { status = s; }
+
+  // writes the suite file, throws EgretException if it cannot be written
+  void write(const string &file_name);
+
+private:
+
+  struct Entry {
+    Entry() { sources = 0; accepted = false; }
+    unsigned int sources;	// source bits
+    bool accepted;		// set if the regex accepts the string
+  };
+
+  map <string, Entry> entries;	// strings in sorted order
+  uint64_t fingerprint;		// fingerprint of regex and base substring
+  bool has_accept;		// set if accept results were recorded
+  string status;		// status of the run
+};
+
+class SuiteReader {
+
+public:
+
+  SuiteReader();
+  ~SuiteReader();
+
+  // maps a suite file into memory, throws EgretException if the file
+  // cannot be read or is not a valid suite file
+  void open(const string &file_name);
+
+  // unmaps the file
+  void close();
+
+  // returns the number of strings
+  unsigned int size() { return count; }
+
+  // returns string i (strings are in sorted order)
+  string get(unsigned int i);
+
+  // returns the index of a string, or -1 if it is not in the suite
+  int find(const string &s);
+
+  // returns true if the suite records accept results
+  bool has_accept() { return accept_pos != 0; }
+
+  // returns true if the regex accepts string i
+  bool is_accepted(unsigned int i) { return get_bit(accept_pos, i); }
+
+  // returns true if the suite records where strings came from
+  bool has_sources() { return sources_pos != 0; }
+
+  // returns true if string i came from the given source
+  bool has_source(unsigned int i, StringSource source);
+
+  // returns the fingerprint of the regex and base substring
+  uint64_t get_fingerprint() { return fingerprint; }
+
+  // returns the engine version that wrote the file
+  string get_engine_version() { return engine_version; }
+
+  // returns the status of the run
+  string get_status();
+
+private:
+
+  const unsigned char *data;	// mapped file
+  size_t length;		// length of mapped file
+  unsigned int count;		// number of strings
+  unsigned int restart;		// restart interval
+  uint64_t index_pos;		// offset of restart index
+  uint64_t accept_pos;		// offset of accept bitmap (0 if none)
+  uint64_t sources_pos;		// offset of source bitmaps (0 if none)
+  uint64_t status_pos;		// offset of status
+  uint64_t fingerprint;		// fingerprint of regex and base substring
+  string engine_version;	// engine version that wrote the file
+
+  // reads a varint at pos, advancing pos
+  uint64_t read_varint(uint64_t &pos);
+
+  // returns bit i of the bitmap at pos
+  bool get_bit(uint64_t pos, unsigned int i);
+
+  SuiteReader(const SuiteReader &other);
+  SuiteReader &operator= (const SuiteReader &other);
+};
+
+#endif // SUITE_FILE_H
@@ -22,10 +22,11 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#include <algorithm>
+#include <functional>
 #include <set>
 #include <sstream>
 #include <vector>
+#include "Counters.h"
 #include "NFA.h"
 #include "TestGenerator.h"
 #include "Path.h"
@@ -34,37 +35,135 @@
 #include "StringPath.h"
 using namespace std;
 
-vector <string>
-TestGenerator::gen_test_strings()
+void
+TestGenerator::gen_test_strings(StringSink _sink)
+{
+  begin([_sink](const string &s, StringSource source) { _sink(s); });
+  while (next_batch())
+    ;
+}
+
+void
+TestGenerator::find_paths()
+{
+  TraceSpan span(trace, "find paths", "paths");
+  paths = nfa.find_paths(path_strategy, deadline, pool);
+  paths_found = true;
+}
+
+void
+TestGenerator::begin(SourceSink _sink)
 {
-  vector <string> ret_strings;
   vector <StringPath>::iterator it;
-  paths = nfa.find_basis_paths();
+  sink = _sink;
+  if (!paths_found) find_paths();
 
   // gen initial strings
   gen_initial_strings();
 
   // gen evil backreference strings
-  vector <int> backrefs_done;
+  unordered_set <int> backrefs_done;
   for(it = test_strings.begin(); it != test_strings.end(); it++) {
+    if (out_of_time("generating backreference strings")) break;
+    TraceSpan span(path_trace(), "backreference strings", "path", it - test_strings.begin());
     vector <string> res = it -> gen_evil_backreference_strings(backrefs_done);
     vector <string>::iterator i;
     for(i = res.begin(); i != res.end(); i++) {
-      if(!(std::find(ret_strings.begin(), ret_strings.end(), *i) != ret_strings.end()))
-        ret_strings.insert(ret_strings.begin(), *i);
+      add_to_output(*i, FROM_BACKREFERENCE);
     }
   }
-  
-  // gen evil strings
-  gen_evil_strings();
-  // add evil strings to ret strings list
+
+  // add initial strings
   for(it = test_strings.begin(); it != test_strings.end(); it++) {
-    string s = it -> get_string();
-    if(!(std::find(ret_strings.begin(), ret_strings.end(), s) != ret_strings.end()))
-      ret_strings.insert(ret_strings.begin(), s);
+    if (out_of_time("adding initial strings")) break;
+    add_to_output(it -> get_string(), FROM_INITIAL);
+  }
+  if (trace) trace->add_counter("strings", output_strings.size());
+}
+
+bool
+TestGenerator::next_batch()
+{
+  if (done) return false;
+
+  // stop generating once the budget or time has run out
+  if (next_path >= paths.size()) {
+    finish();
+    return false;
+  }
+  if (budget.is_exhausted()) {
+    budget.skip_paths(paths.size() - next_path);
+    finish();
+    return false;
+  }
+  if (out_of_time("generating evil strings")) {
+    finish();
+    return false;
+  }
+
+  // gen evil strings for the next path
+  vector <StringPath> evil_strings = gen_next_evil_strings();
+  add_to_output(evil_strings, FROM_EVIL);
+  next_path++;
+  if (trace) trace->add_counter("strings", output_strings.size());
+  return true;
+}
+
+vector <StringPath>
+TestGenerator::gen_next_evil_strings()
+{
+  if (pool == NULL) {
+    TraceSpan span(path_trace(), "evil strings", "path", next_path);
+    return paths[next_path].gen_evil_strings(records, punct_marks);
+  }
+
+  // keep the pool busy with the paths that follow (the records are only read
+  // from here on, and each edge generates evil strings for one path only, so
+  // the paths share no state)
+  while (next_submit < paths.size() && next_submit < next_path + 2 * pool->size()) {
+    Path *path = &paths[next_submit];
+    EdgeRecords *edge_records = &records;
+    set <char> *marks = &punct_marks;
+    Trace *span_trace = path_trace();
+    int index = next_submit;
+    submitted.push_back(pool->submit(function <PathStrings ()>([path, edge_records, marks,
+                                                                span_trace, index]() {
+      PathStrings result;
+      WarningScope scope(&result.warnings);
+      TraceSpan span(span_trace, "evil strings", "path", index);
+      result.strings = path->gen_evil_strings(*edge_records, *marks);
+      return result;
+    })));
+    next_submit++;
   }
-  return ret_strings;
 
+  // results are used in path order, so output does not depend on timing
+  PathStrings result = pool->wait(submitted.front());
+  submitted.pop_front();
+  addWarnings(result.warnings);
+  return result.strings;
+}
+
+void
+TestGenerator::set_threads(unsigned int threads)
+{
+  if (threads == 0) threads = thread::hardware_concurrency();
+  delete pool;
+  pool = NULL;
+  if (threads > 1) pool = new ThreadPool(threads);
+}
+
+void
+TestGenerator::finish()
+{
+  done = true;
+
+  // stop any work the pool has left
+  delete pool;
+  pool = NULL;
+  submitted.clear();
+
+  budget.add_warnings();
 }
 
 void
@@ -80,15 +179,16 @@ TestGenerator::gen_initial_strings()
   vector <Path>::iterator path_iter;
   StringPath first_string;
   for (path_iter = paths.begin(); path_iter != paths.end(); path_iter++) {  // for each path
+    if (out_of_time("generating initial strings")) break;
     // check for leading carets and trailing dollars
     bool start_with_caret = path_iter->has_leading_caret();
     bool end_with_dollar = path_iter->has_trailing_dollar();
 
     // go through each state in the path
-    StringPath path_string;
-    path_string.clear();
-    path_string.add_path(path_iter->gen_initial_string(base_substring));
-    add_to_test_strings(path_string);
+    TraceSpan span(path_trace(), "initial string", "path", path_iter - paths.begin());
+    test_strings.push_back(path_iter->gen_initial_string(base_substring, records));
+    const StringPath &path_string = test_strings.back();
+    test_string_count++;
 
     // for first path, record whether the path starts with ^ and/or ends with $
     if (first_string.path.empty()) {
@@ -155,28 +255,22 @@ TestGenerator::gen_initial_strings()
 }
 
 void
-TestGenerator::add_to_test_strings(StringPath s)
+TestGenerator::add_to_output(const string &s, StringSource source)
 {
-  test_strings.push_back(s);
+  COUNT(DEDUP_PROBES);
+  if (output_strings.find(s) != output_strings.end()) return;
+  if (!budget.admit(s)) return;
+  output_strings.insert(s);
+  sink(s, source);
 }
 
 void
-TestGenerator::add_to_test_strings(set <StringPath, spcompare> strs)
+TestGenerator::add_to_output(const vector <StringPath> &strs, StringSource source)
 {
-  set <StringPath, spcompare>::iterator it;
+  vector <StringPath>::const_iterator it;
   for (it = strs.begin(); it != strs.end(); it++) {
-    StringPath ptr = *it;
-    add_to_test_strings(ptr);
-  }
-}
-
-void
-TestGenerator::gen_evil_strings()
-{
-  vector <Path>::iterator path_iter;
-  for (path_iter = paths.begin(); path_iter != paths.end(); path_iter++) {
-    set <StringPath, spcompare> evil_strings = path_iter->gen_evil_strings(punct_marks);
-    add_to_test_strings(evil_strings);
+    test_string_count++;
+    add_to_output(it->get_string(), source);
   }
 }
 
@@ -184,5 +278,17 @@ void
 TestGenerator::add_stats(Stats &stats)
 {
   stats.add("PATHS", "Paths", paths.size());
-  stats.add("PATHS", "Strings", test_strings.size());
+  stats.add("PATHS", "Strings", test_string_count);
+
+  long path_bytes = paths.capacity() * sizeof(Path);
+  for (unsigned int i = 0; i < paths.size(); i++) {
+    path_bytes += paths[i].get_memory();
+  }
+  long string_bytes = test_strings.capacity() * sizeof(StringPath);
+  for (unsigned int i = 0; i < test_strings.size(); i++) {
+    string_bytes += test_strings[i].get_memory();
+  }
+  stats.add("PATHS", "Path bytes", path_bytes);
+  stats.add("PATHS", "StringPath bytes", string_bytes);
+  budget.add_stats(stats);
 }
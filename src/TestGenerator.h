@@ -25,47 +25,142 @@
 #ifndef TEST_GENERATOR_H
 #define TEST_GENERATOR_H
 
+#include <deque>
+#include <future>
 #include <set>
 #include <string>
+#include <unordered_set>
 #include <vector>
+#include "Budget.h"
+#include "Deadline.h"
 #include "NFA.h"
 #include "Path.h"
+#include "PathStrategy.h"
+#include "Sink.h"
 #include "StringPath.h"
+#include "ThreadPool.h"
+#include "Trace.h"
 using namespace std;
 
 class TestGenerator {
 
 public:
 
-  TestGenerator(NFA n, string b, set <char> p) { nfa = n; 
+  // the NFA is borrowed (it must outlive the generator)
+  TestGenerator(const NFA &n, const string &b, const set <char> &p) : nfa(n) {
 base_substring.add_string(b); 
-punct_marks = p;}
+punct_marks = p;
+test_string_count = 0;
+deadline = NULL;
+next_path = 0;
+path_strategy = BASIS_PATHS;
+pool = NULL;
+next_submit = 0;
+trace = NULL;
+trace_paths = false;
+paths_found = false;
+done = false;}
 
-  // generate test strings
-  vector <string> gen_test_strings();
+  ~TestGenerator() { delete pool; }
+
+  // sets resource limits for generation (0 means no limit)
+  void set_limits(unsigned int max_strings, unsigned long max_bytes, unsigned int max_length) {
+    budget.set_limits(max_strings, max_bytes, max_length);
+  }
+
+  // sets the deadline for generation (NULL means none)
+  void set_deadline(Deadline *d) { deadline = d; }
+
+  // sets how paths through the NFA are chosen
+  void set_path_strategy(PathStrategy s) { path_strategy = s; }
+
+  // sets the trace that gets the generation spans (NULL means none), with
+  // a span for each path's work if paths is set
+  void set_trace(Trace *t, bool paths) { trace = t; trace_paths = paths; }
+
+  // sets the number of threads generating evil strings (0 for one per core),
+  // strings are output in the same order for any number of threads
+  void set_threads(unsigned int threads);
+
+  // generate test strings, passing each one to sink as it is generated
+  void gen_test_strings(StringSink sink);
+
+  // finds the paths through the NFA (begin finds them if they were not
+  // found or set before)
+  void find_paths();
+
+  // uses paths found by an earlier run on the same NFA with the same
+  // strategy instead of finding them again
+  void set_paths(const vector <Path> &p) { paths = p; paths_found = true; }
+
+  // returns the paths (as found, until begin is called)
+  const vector <Path> &get_paths() { return paths; }
+
+  // starts generation: finds the paths and generates the initial and
+  // backreference strings, passing each one to sink
+  void begin(SourceSink sink);
+
+  // generates the evil strings for the next path, returns false once
+  // generation is complete
+  bool next_batch();
 
   // add test generation stats
   void add_stats(Stats &stats);
 
 private:
 
-  NFA nfa;				// NFA to traverse
+  // evil strings for a path generated by the pool, with the warnings
+  // issued while generating them
+  struct PathStrings {
+    vector <StringPath> strings;
+    string warnings;
+  };
+
+  const NFA &nfa;			// NFA to traverse
   StringPath base_substring;    // base string for regex strings
   set <char> punct_marks;		// set of punct marks
   vector <Path> paths;			// list of paths
-  vector <StringPath> test_strings;     // list of test strings
+  bool paths_found;			// set once the paths are found (or set)
+  EdgeRecords records;			// edge visits recorded while generating initial strings
+  PathStrategy path_strategy;		// how paths are chosen
+  vector <StringPath> test_strings;     // list of initial test strings
+  unsigned int test_string_count;	// number of test strings generated
+  SourceSink sink;			// receives output strings
+  unordered_set <string> output_strings;	// output strings (for duplicate checks)
+  unsigned int next_path;		// next path to generate evil strings for
+  bool done;				// set once generation is complete
+  ThreadPool *pool;			// threads generating evil strings (NULL if none)
+  unsigned int next_submit;		// next path to give to the pool
+  deque <future <PathStrings> > submitted;	// paths given to the pool, in path order
+  Budget budget;			// resource limits for output
+  Deadline *deadline;			// deadline for generation (NULL if none)
+  Trace *trace;				// trace for generation (NULL if none)
+  bool trace_paths;			// set if each path's work is traced
 
   // generates initial set of strings
   void gen_initial_strings();
 
-  // adds a string to test string vector (unless it is already there)
-  void add_to_test_strings(StringPath s);
+  // adds a string to the output (unless it is already there or over budget)
+  void add_to_output(const string &s, StringSource source);
+
+  // adds strings to the output (in order)
+  void add_to_output(const vector <StringPath> &strs, StringSource source);
+
+  // generates the evil strings for the next path, using the pool if there
+  // is one
+  vector <StringPath> gen_next_evil_strings();
+
+  // finishes generation
+  void finish();
+
+  // returns the trace if each path's work is traced, NULL otherwise
+  Trace *path_trace() { return trace_paths ? trace : NULL; }
 
-  // adds a set of strings to test string vector
-  void add_to_test_strings(set <StringPath, spcompare> strs);
+  // returns true if generation should stop because time has run out
+  bool out_of_time(const char *phase) { return deadline && deadline->expired(phase); }
 
-  // generates additional evil strings
-  void gen_evil_strings();
+  TestGenerator(const TestGenerator &other);
+  TestGenerator &operator= (const TestGenerator &other);
 };
 
 #endif // TEST_GENERATOR_H
@@ -0,0 +1,137 @@
+/*  ThreadPool.cpp: fixed set of worker threads
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "ThreadPool.h"
+using namespace std;
+
+// pool and queue index of the worker running on this thread (if any)
+static thread_local ThreadPool *current_pool = NULL;
+static thread_local unsigned int current_index = 0;
+
+ThreadPool::ThreadPool(unsigned int threads)
+{
+  stopping = false;
+  queued = 0;
+  for (unsigned int i = 0; i < threads; i++) {
+    queues.push_back(unique_ptr <Queue>(new Queue()));
+  }
+  for (unsigned int i = 0; i < threads; i++) {
+    workers.push_back(thread(&ThreadPool::work, this, i));
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    lock_guard <mutex> guard(lock);
+    stopping = true;
+  }
+  ready.notify_all();
+  vector <thread>::iterator it;
+  for (it = workers.begin(); it != workers.end(); it++) {
+    it->join();
+  }
+}
+
+void
+ThreadPool::push(function <void ()> task)
+{
+  Queue *queue = (current_pool == this) ? queues[current_index].get() : &shared;
+  {
+    lock_guard <mutex> guard(queue->lock);
+    queue->tasks.push_back(task);
+  }
+  {
+    lock_guard <mutex> guard(lock);
+    queued++;
+  }
+  ready.notify_one();
+}
+
+bool
+ThreadPool::take(function <void ()> &task)
+{
+  if (stopping) return false;
+
+  // newest task of this worker
+  if (current_pool == this) {
+    Queue *own = queues[current_index].get();
+    lock_guard <mutex> guard(own->lock);
+    if (!own->tasks.empty()) {
+      task = own->tasks.back();
+      own->tasks.pop_back();
+      queued--;
+      return true;
+    }
+  }
+
+  // oldest task submitted from outside the pool
+  {
+    lock_guard <mutex> guard(shared.lock);
+    if (!shared.tasks.empty()) {
+      task = shared.tasks.front();
+      shared.tasks.pop_front();
+      queued--;
+      return true;
+    }
+  }
+
+  // oldest task of another worker
+  unsigned int start = (current_pool == this) ? current_index + 1 : 0;
+  for (unsigned int i = 0; i < queues.size(); i++) {
+    Queue *victim = queues[(start + i) % queues.size()].get();
+    lock_guard <mutex> guard(victim->lock);
+    if (!victim->tasks.empty()) {
+      task = victim->tasks.front();
+      victim->tasks.pop_front();
+      queued--;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool
+ThreadPool::run_one()
+{
+  function <void ()> task;
+  if (!take(task)) return false;
+  task();
+  return true;
+}
+
+void
+ThreadPool::work(unsigned int index)
+{
+  current_pool = this;
+  current_index = index;
+  while (true) {
+    {
+      unique_lock <mutex> guard(lock);
+      ready.wait(guard, [this]() { return stopping || queued > 0; });
+      if (stopping) return;
+    }
+    run_one();
+  }
+}
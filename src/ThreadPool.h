@@ -0,0 +1,107 @@
+/*  ThreadPool.h: fixed set of worker threads
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Each worker has its own deque of tasks.  A task submitted from a worker
+// goes on the back of that worker's deque and the worker takes its newest
+// task first; tasks submitted from other threads go on a shared queue.  An
+// idle worker steals the oldest task from another worker's deque.
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+class ThreadPool {
+
+public:
+
+  // starts the worker threads
+  ThreadPool(unsigned int threads);
+
+  // discards tasks that have not started and waits for the running ones
+  ~ThreadPool();
+
+  // returns the number of worker threads
+  unsigned int size() { return workers.size(); }
+
+  // queues a task, the future gets its result (or the exception it throws)
+  template <class T>
+  future <T> submit(function <T ()> task) {
+    shared_ptr <packaged_task <T ()> > job = make_shared <packaged_task <T ()> >(task);
+    future <T> result = job->get_future();
+    push([job]() { (*job)(); });
+    return result;
+  }
+
+  // waits for a result, running queued tasks in the meantime (so a task can
+  // wait for tasks it submitted without holding up a worker)
+  template <class T>
+  T wait(future <T> &result) {
+    while (result.wait_for(chrono::seconds(0)) != future_status::ready) {
+      if (!run_one()) result.wait_for(chrono::microseconds(100));
+    }
+    return result.get();
+  }
+
+private:
+
+  // tasks owned by a worker
+  struct Queue {
+    deque <function <void ()> > tasks;	// newest at the back
+    mutex lock;				// guards tasks
+  };
+
+  vector <thread> workers;		// worker threads
+  vector <unique_ptr <Queue> > queues;	// one queue per worker
+  Queue shared;				// tasks submitted from other threads
+  atomic <int> queued;			// number of tasks in all the queues
+  mutex lock;				// guards stopping and sleeping workers
+  condition_variable ready;		// signaled when a task is queued or the pool stops
+  atomic <bool> stopping;		// set when the pool is being destroyed
+
+  // queues a task
+  void push(function <void ()> task);
+
+  // takes a task: own newest, then shared oldest, then another worker's
+  // oldest, returns false if there is none
+  bool take(function <void ()> &task);
+
+  // runs one queued task, returns false if there was none
+  bool run_one();
+
+  // runs tasks until the pool stops
+  void work(unsigned int index);
+
+  ThreadPool(const ThreadPool &other);
+  ThreadPool &operator= (const ThreadPool &other);
+};
+
+#endif // THREAD_POOL_H
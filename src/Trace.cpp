@@ -0,0 +1,144 @@
+/*  Trace.cpp: Chrome trace events for engine runs
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Trace.h"
+#include "Utf8.h"
+using namespace std;
+
+Trace::Trace(const string &name)
+{
+  trace_name = name;
+  start_time = chrono::steady_clock::now();
+  in_phase = false;
+  phase_start = 0;
+}
+
+void
+Trace::begin_phase(const string &name)
+{
+  end_phase();
+  phase_name = name;
+  phase_start = now();
+  in_phase = true;
+}
+
+void
+Trace::end_phase()
+{
+  if (!in_phase) return;
+  add_span(phase_name, "phase", phase_start);
+  in_phase = false;
+}
+
+double
+Trace::now()
+{
+  chrono::duration <double, micro> elapsed = chrono::steady_clock::now() - start_time;
+  return elapsed.count();
+}
+
+void
+Trace::add_span(const string &name, const string &category, double start, int path)
+{
+  double end = now();
+  lock_guard <mutex> guard(lock);
+  Event event = { 'X', name, category, start, end - start, thread_number(), path };
+  events.push_back(event);
+}
+
+void
+Trace::add_counter(const string &name, unsigned long value)
+{
+  double time = now();
+  lock_guard <mutex> guard(lock);
+  Event event = { 'C', name, "", time, 0, 0, (long) value };
+  events.push_back(event);
+}
+
+unsigned int
+Trace::thread_number()
+{
+  map <thread::id, unsigned int>::iterator it = threads.find(this_thread::get_id());
+  if (it != threads.end()) return it->second;
+  unsigned int number = threads.size() + 1;
+  threads[this_thread::get_id()] = number;
+  return number;
+}
+
+bool
+Trace::write(const string &file_name)
+{
+  end_phase();
+  lock_guard <mutex> guard(lock);
+
+  // the process is named after the run, the first thread is the run's own
+  string out = "{\"traceEvents\":[\n";
+  out += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":";
+  append_json_string(out, trace_name);
+  out += "}}";
+  map <thread::id, unsigned int>::iterator tit;
+  for (tit = threads.begin(); tit != threads.end(); tit++) {
+    char buf[128];
+    snprintf(buf, sizeof(buf),
+             ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+             "\"args\":{\"name\":\"%s %u\"}}",
+             tit->second, tit->second == 1 ? "run" : "worker", tit->second);
+    out += buf;
+  }
+
+  vector <Event>::iterator it;
+  for (it = events.begin(); it != events.end(); it++) {
+    char buf[160];
+    out += ",\n{\"name\":";
+    append_json_string(out, it->name);
+    if (it->type == 'X') {
+      out += ",\"cat\":";
+      append_json_string(out, it->category);
+      snprintf(buf, sizeof(buf), ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+               it->thread, it->start, it->duration);
+      out += buf;
+      if (it->value >= 0) {
+        snprintf(buf, sizeof(buf), ",\"args\":{\"path\":%ld}", it->value);
+        out += buf;
+      }
+    }
+    else {
+      snprintf(buf, sizeof(buf), ",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"value\":%ld}",
+               it->start, it->value);
+      out += buf;
+    }
+    out += "}";
+  }
+  out += "\n]}\n";
+
+  ofstream file(file_name.c_str(), ios::out | ios::binary | ios::trunc);
+  if (!file.is_open()) return false;
+  file << out;
+  file.close();
+  return !file.fail();
+}
@@ -0,0 +1,110 @@
+/*  Trace.h: Chrome trace events for engine runs
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// A trace records spans (work with a start and a duration) and counter
+// values over a run, from any thread, and writes them as JSON in the
+// Chrome trace event format, which chrome://tracing and Perfetto display.
+// Each thread gets its own track, so the evil strings generated by the
+// thread pool show up beside the run's own phases.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+class Trace {
+
+public:
+
+  Trace(const string &name);
+
+  // ends the current phase (if any) and begins the next one
+  void begin_phase(const string &name);
+
+  // ends the current phase
+  void end_phase();
+
+  // returns the time since the trace began in microseconds
+  double now();
+
+  // adds a span on the calling thread from start (see now) to now, path is
+  // added to the span's arguments unless it is negative
+  void add_span(const string &name, const string &category, double start, int path = -1);
+
+  // adds the value of a counter at the current time
+  void add_counter(const string &name, unsigned long value);
+
+  // writes the trace to a file, returns false if it could not be written
+  bool write(const string &file_name);
+
+private:
+
+  struct Event {
+    char type;			// X for a span, C for a counter
+    string name;		// name of the span or counter
+    string category;		// category of the span
+    double start;		// start in microseconds
+    double duration;		// duration in microseconds (for a span)
+    unsigned int thread;	// thread number (for a span)
+    long value;			// path (for a span, negative if none) or counter value
+  };
+
+  string trace_name;				// name of the traced run
+  chrono::steady_clock::time_point start_time;	// when the trace began
+  mutex lock;					// guards the events and threads
+  vector <Event> events;			// events in the order they ended
+  map <thread::id, unsigned int> threads;	// number of each thread seen
+  bool in_phase;				// set while a phase is open
+  string phase_name;				// name of the open phase
+  double phase_start;				// start of the open phase
+
+  // returns the number of the calling thread (lock must be held)
+  unsigned int thread_number();
+};
+
+// Adds a span for the lifetime of the scope (nothing if the trace is NULL)
+class TraceSpan {
+
+public:
+  TraceSpan(Trace *t, const char *_name, const char *_category, int _path = -1) {
+    trace = t;
+    name = _name;
+    category = _category;
+    path = _path;
+    if (trace) start = trace->now();
+  }
+  ~TraceSpan() { if (trace) trace->add_span(name, category, start, path); }
+
+private:
+  Trace *trace;
+  const char *name;
+  const char *category;
+  int path;
+  double start;
+};
+
+#endif // TRACE_H
@@ -0,0 +1,49 @@
+/*  UnicodeTables.h: Unicode general category tables
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// The tables themselves are in UnicodeTables.cpp, which is generated by
+// gen_unicode_tables.py.
+
+#ifndef UNICODE_TABLES_H
+#define UNICODE_TABLES_H
+
+#include <string>
+using namespace std;
+
+// range of code points (inclusive)
+struct UnicodeRange
+{
+  unsigned int first;
+  unsigned int last;
+};
+
+// general category (\p{Lu}) or group of categories (\p{L})
+struct UnicodeProperty
+{
+  const char *name;		// category name
+  const UnicodeRange *ranges;	// sorted, non-overlapping ranges
+  unsigned int count;		// number of ranges
+};
+
+// returns the property with the given name, or NULL if there is none
+const UnicodeProperty *find_unicode_property(const string &name);
+
+#endif // UNICODE_TABLES_H
@@ -0,0 +1,171 @@
+/*  Utf8.cpp: UTF-8 encoding and decoding
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "Utf8.h"
+using namespace std;
+
+bool
+is_valid_code_point(unsigned int cp)
+{
+  return cp <= MAX_CODE_POINT && !(cp >= 0xD800 && cp <= 0xDFFF);
+}
+
+string
+utf8_encode(unsigned int cp)
+{
+  string s;
+  if (cp < 0x80) {
+    s += (char) cp;
+  }
+  else if (cp < 0x800) {
+    s += (char) (0xC0 | (cp >> 6));
+    s += (char) (0x80 | (cp & 0x3F));
+  }
+  else if (cp < 0x10000) {
+    s += (char) (0xE0 | (cp >> 12));
+    s += (char) (0x80 | ((cp >> 6) & 0x3F));
+    s += (char) (0x80 | (cp & 0x3F));
+  }
+  else {
+    s += (char) (0xF0 | (cp >> 18));
+    s += (char) (0x80 | ((cp >> 12) & 0x3F));
+    s += (char) (0x80 | ((cp >> 6) & 0x3F));
+    s += (char) (0x80 | (cp & 0x3F));
+  }
+  return s;
+}
+
+bool
+utf8_decode(const string &s, unsigned int &idx, unsigned int &cp)
+{
+  unsigned char lead = s[idx];
+  unsigned int length;
+  unsigned int min;
+
+  if (lead < 0x80) {
+    cp = lead;
+    idx++;
+    return true;
+  }
+  else if ((lead & 0xE0) == 0xC0) {
+    cp = lead & 0x1F;
+    length = 2;
+    min = 0x80;
+  }
+  else if ((lead & 0xF0) == 0xE0) {
+    cp = lead & 0x0F;
+    length = 3;
+    min = 0x800;
+  }
+  else if ((lead & 0xF8) == 0xF0) {
+    cp = lead & 0x07;
+    length = 4;
+    min = 0x10000;
+  }
+  else {
+    return false;
+  }
+
+  if (idx + length > s.length()) return false;
+  for (unsigned int i = 1; i < length; i++) {
+    unsigned char b = s[idx + i];
+    if ((b & 0xC0) != 0x80) return false;
+    cp = (cp << 6) | (b & 0x3F);
+  }
+
+  // reject overlong encodings, surrogates, and values past the last code point
+  if (cp < min || !is_valid_code_point(cp)) return false;
+
+  idx += length;
+  return true;
+}
+
+bool
+utf8_is_valid(const string &s)
+{
+  unsigned int idx = 0;
+  unsigned int cp;
+  while (idx < s.length()) {
+    if (!utf8_decode(s, idx, cp)) return false;
+  }
+  return true;
+}
+
+bool
+utf8_code_points(const string &s, vector <unsigned int> &cps)
+{
+  unsigned int idx = 0;
+  unsigned int cp;
+  cps.clear();
+  while (idx < s.length()) {
+    if (!utf8_decode(s, idx, cp)) return false;
+    cps.push_back(cp);
+  }
+  return true;
+}
+
+string
+utf8_encode(const vector <unsigned int> &cps)
+{
+  string s;
+  vector <unsigned int>::const_iterator it;
+  for (it = cps.begin(); it != cps.end(); it++) {
+    s += utf8_encode(*it);
+  }
+  return s;
+}
+
+void
+append_json_string(string &out, const string &s)
+{
+  char buf[8];
+  unsigned int idx = 0;
+  out += '"';
+  while (idx < s.length()) {
+    unsigned int start = idx;
+    unsigned int cp;
+    if (!utf8_decode(s, idx, cp)) {
+      snprintf(buf, sizeof(buf), "\\u%04x", (unsigned char) s[idx]);
+      out += buf;
+      idx++;
+      continue;
+    }
+    switch (cp) {
+    case '"':	out += "\\\""; break;
+    case '\\':	out += "\\\\"; break;
+    case '\n':	out += "\\n"; break;
+    case '\r':	out += "\\r"; break;
+    case '\t':	out += "\\t"; break;
+    default:
+      if (cp < 0x20) {
+        snprintf(buf, sizeof(buf), "\\u%04x", cp);
+        out += buf;
+      }
+      else {
+        out.append(s, start, idx - start);
+      }
+    }
+  }
+  out += '"';
+}
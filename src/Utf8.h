@@ -0,0 +1,64 @@
+/*  Utf8.h: UTF-8 encoding and decoding
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef UTF8_H
+#define UTF8_H
+
+#include <string>
+#include <vector>
+using namespace std;
+
+#define MAX_CODE_POINT 0x10FFFF
+
+// returns true if the code point can be encoded (not a surrogate or out of range)
+bool is_valid_code_point(unsigned int cp);
+
+// returns the UTF-8 encoding of a code point
+string utf8_encode(unsigned int cp);
+
+// appends the UTF-8 encoding of a code point to a string
+inline void
+utf8_append(string &s, unsigned int cp)
+{
+  if (cp < 0x80)
+    s += (char) cp;
+  else
+    s += utf8_encode(cp);
+}
+
+// decodes the code point starting at s[idx], advancing idx past it, returns
+// false if the bytes are not valid UTF-8
+bool utf8_decode(const string &s, unsigned int &idx, unsigned int &cp);
+
+// returns true if the string is valid UTF-8
+bool utf8_is_valid(const string &s);
+
+// gets the code points of a string, returns false if it is not valid UTF-8
+bool utf8_code_points(const string &s, vector <unsigned int> &cps);
+
+// returns the UTF-8 encoding of a list of code points
+string utf8_encode(const vector <unsigned int> &cps);
+
+// appends a string as a JSON string literal, a byte that is not valid
+// UTF-8 is written as the code point with the same value
+void append_json_string(string &out, const string &s);
+
+#endif // UTF8_H
@@ -23,87 +23,933 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <unordered_set>
+#include "Budget.h"
+#include "Counters.h"
+#include "Deadline.h"
+#include "MatchProfile.h"
+#include "Matcher.h"
 #include "NFA.h"
 #include "ParseTree.h"
+#include "Redos.h"
+#include "RegexSet.h"
 #include "Scanner.h"
 #include "Stats.h"
+#include "SuiteFile.h"
 #include "TestGenerator.h"
+#include "Trace.h"
+#include "egret.h"
 #include "error.h"
 
 using namespace std;
 
-static bool debug_mode = false;
-static bool stat_mode = false;
+static void check_base_substring(const string &base_substring);
+static EngineResult get_result(EngineStream &stream, const EngineOptions &options);
+static vector <string> get_suite(EngineStream &stream);
 
 vector <string>
-run_engine(string regex, string base_substring, bool debug = false, bool stat = false)
+run_engine(string regex, string base_substring, bool debug, bool stat)
+{
+  EngineOptions options;
+  options.debug = debug;
+  options.stat = stat;
+  return run_engine(regex, base_substring, options);
+}
+
+vector <string>
+run_engine(string regex, string base_substring, const EngineOptions &options)
+{
+  EngineStream stream(regex, base_substring, options);
+  return get_suite(stream);
+}
+
+vector <vector <string> >
+run_engine(string regex, const vector <string> &base_substrings, const EngineOptions &options)
+{
+  // the regex is compiled once, the first run keeps its paths and REDOS
+  // analysis, and the runs for the other bases only generate strings
+  CompiledRegex compiled(regex, options);
+  vector <vector <string> > suites;
+  for (unsigned int i = 0; i < base_substrings.size(); i++) {
+    EngineStream stream(compiled, base_substrings[i], options);
+    suites.push_back(get_suite(stream));
+  }
+  return suites;
+}
+
+// runs stream to the end, returns the status followed by the test strings
+// (just the status if the run stopped with an error)
+static vector <string>
+get_suite(EngineStream &stream)
 {
   vector <string> test_strings;
+  string s;
+  while (stream.next(s)) {
+    test_strings.push_back(s);
+  }
 
-  // process arguments
-  debug_mode = debug;
-  stat_mode = stat;
-  
-  // clear warnings
-  clearWarnings();
+  if (stream.has_error()) {
+    vector <string> result;
+    result.push_back(stream.get_status());
+    return result;
+  }
 
-  try {
+  // most recently generated strings come first, status goes in front
+  reverse(test_strings.begin(), test_strings.end());
+  test_strings.insert(test_strings.begin(), stream.get_status());
 
-    // check base_substring
-    if (base_substring.length() < 2) {
-      throw EgretException("ERROR: Base substring must have at least two letters");
+  return test_strings;
+}
+
+EngineResult
+run_engine_result(string regex, string base_substring, const EngineOptions &options)
+{
+  EngineStream stream(regex, base_substring, options);
+  return get_result(stream, options);
+}
+
+// runs stream to the end, gathering its result
+static EngineResult
+get_result(EngineStream &stream, const EngineOptions &options)
+{
+  EngineResult result;
+  string s;
+  StringSource source;
+  while (stream.next(s, source)) {
+    result.strings.push_back(s);
+    result.sources.push_back(source);
+  }
+  if (options.stat) result.stats = stream.get_stats();
+
+  if (stream.has_error()) {
+    result.status = STATUS_ERROR;
+    result.error = stream.get_status();
+    result.strings.clear();
+    result.sources.clear();
+    return result;
+  }
+
+  // most recently generated strings come first (same order as run_engine)
+  reverse(result.strings.begin(), result.strings.end());
+  reverse(result.sources.begin(), result.sources.end());
+  result.warnings = stream.get_warnings();
+  result.status = result.warnings.empty() ? STATUS_SUCCESS : STATUS_WARNING;
+  if (options.verdicts) {
+    result.accepted.reserve(result.strings.size());
+    for (unsigned int i = 0; i < result.strings.size(); i++) {
+      result.accepted.push_back(stream.accepts(result.strings[i]));
     }
-    for (unsigned int i = 0; i < base_substring.length(); i++) {
-      if (!isalpha(base_substring[i])) {
-        throw EgretException("ERROR: Base substring can only contain letters");
+  }
+  return result;
+}
+
+string
+run_engine(string regex, string base_substring, const EngineOptions &options, StringSink sink)
+{
+  EngineStream stream(regex, base_substring, options);
+  string s;
+  while (stream.next(s)) {
+    sink(s);
+  }
+  return stream.get_status();
+}
+
+string
+write_suite(string regex, string base_substring, const EngineOptions &options,
+            string file_name, function <bool (const string &)> accept)
+{
+  EngineStream stream(regex, base_substring, options);
+  SuiteWriter writer;
+  string s;
+  StringSource source;
+  while (stream.next(s, source)) {
+    writer.add(s, source);
+    if (accept) writer.set_accepted(s, accept(s));
+  }
+  if (stream.has_error()) return stream.get_status();
+
+  writer.set_fingerprint(regex, base_substring);
+  writer.set_status(stream.get_status());
+  try {
+    writer.write(file_name);
+  }
+  catch (EgretException const &e) {
+    return e.getError();
+  }
+  return stream.get_status();
+}
+
+string
+write_suite(const EngineResult &result, string regex, string base_substring,
+            string file_name, function <bool (const string &)> accept)
+{
+  if (result.status == STATUS_ERROR) return result.error;
+
+  // the status the run gave (as run_engine does)
+  string status = "";
+  for (unsigned int i = 0; i < result.warnings.size(); i++) {
+    status += result.warnings[i].message + "\n";
+  }
+  if (status == "") status = "SUCCESS";
+
+  SuiteWriter writer;
+  for (unsigned int i = 0; i < result.strings.size(); i++) {
+    writer.add(result.strings[i], result.sources[i]);
+    if (accept) writer.set_accepted(result.strings[i], accept(result.strings[i]));
+  }
+  writer.set_fingerprint(regex, base_substring);
+  writer.set_status(status);
+  try {
+    writer.write(file_name);
+  }
+  catch (EgretException const &e) {
+    return e.getError();
+  }
+  return status;
+}
+
+//=============================================================
+// Regex sets
+//=============================================================
+
+// returns true if member a accepts one of the strings that member b does not
+static bool
+discriminates(const vector <bool> &a, const vector <bool> &b)
+{
+  for (unsigned int j = 0; j < a.size(); j++) {
+    if (a[j] && !b[j]) return true;
+  }
+  return false;
+}
+
+// returns the printable characters of two regexes and a few common ones,
+// the characters tried when editing a string to tell the regexes apart
+static string
+edit_chars(const string &regex1, const string &regex2)
+{
+  bool seen[128] = { false };
+  string all = regex1 + regex2 + "0aA_ -";
+  string chars;
+  for (unsigned int i = 0; i < all.length(); i++) {
+    unsigned char c = all[i];
+    if (c < 32 || c >= 127 || seen[c]) continue;
+    seen[c] = true;
+    chars += c;
+  }
+  return chars;
+}
+
+// looks for a string that member a accepts and member b does not by
+// removing, replacing or inserting one character of a string that both
+// accept, adds the matching steps taken to steps, returns false if none is
+// found within SET_EDIT_TRIES matches (or before steps reaches SET_EDIT_STEPS)
+static bool
+find_discriminating(const vector <string> &shared, const string &chars, Matcher &a, Matcher &b,
+                    const unordered_set <string> &in_suite, Deadline &deadline,
+                    unsigned long &steps, string &found)
+{
+  unsigned int tries = 0;
+  for (unsigned int i = 0; i < shared.size(); i++) {
+    if (deadline.expired("telling regex set members apart")) return false;
+    const string &s = shared[i];
+    for (unsigned int pos = 0; pos <= s.length(); pos++) {
+      vector <string> edits;
+      if (pos < s.length()) edits.push_back(s.substr(0, pos) + s.substr(pos + 1));
+      for (unsigned int c = 0; c < chars.length(); c++) {
+        if (pos < s.length() && s[pos] != chars[c]) {
+          edits.push_back(s.substr(0, pos) + chars[c] + s.substr(pos + 1));
+        }
+        edits.push_back(s.substr(0, pos) + chars[c] + s.substr(pos));
+      }
+      for (unsigned int e = 0; e < edits.size(); e++) {
+        if (in_suite.count(edits[e]) != 0) continue;
+        if (tries++ >= SET_EDIT_TRIES || steps >= SET_EDIT_STEPS) return false;
+        bool accepted = a.full_match(edits[e]);
+        steps += a.get_steps();
+        if (!accepted) continue;
+        bool rejected = !b.full_match(edits[e]);
+        steps += b.get_steps();
+        if (rejected) {
+          found = edits[e];
+          return true;
+        }
       }
     }
+  }
+  return false;
+}
+
+RegexSetResult
+run_regex_set(const vector <string> &regexes, string base_substring, const EngineOptions &options)
+{
+  RegexSetResult result;
+  string warnings;
+  WarningScope scope(&warnings);
+  Deadline deadline;
+  deadline.set_timeout(options.timeout);
+  deadline.set_cancel_token(options.cancel);
+  Stats stats;
+  PhaseCounters counters;
 
-    // initialize scanner with regex
-    Scanner scanner;
-    scanner.init(regex);
-  
-    // build parse tree
-    ParseTree tree;
-    tree.build(scanner);
+  try {
+    check_base_substring(base_substring);
+
+    counters.begin_phase("parse");
+    RegexSet regex_set;
+    regex_set.build(regexes, &deadline);
+    if (options.stat) regex_set.add_stats(stats);
+    for (unsigned int i = 0; i < regex_set.size(); i++) {
+      result.member_errors.push_back(regex_set.get_member_error(i));
+      if (result.member_errors[i] != "") {
+        stringstream s;
+        s << "SET WARNING: Member " << i << " was left out: " << result.member_errors[i];
+        addWarning(s.str());
+      }
+    }
+    if (regex_set.get_root() == NULL) {
+      throw EgretException("ERROR: No member of the regex set could be parsed");
+    }
 
-    // build NFA
+    // generate strings from the combined tree
+    counters.begin_phase("nfa");
     NFA nfa;
-    nfa.build(tree);
-
-    // generate tests
-    TestGenerator gen(nfa, base_substring, tree.get_punct_marks());
-    test_strings = gen.gen_test_strings();
-    
-    // print debug info
-    if (debug_mode) {
-      cout << "RegEx: " << regex << endl;
-      scanner.print();
-      tree.print();
+    nfa.build(regex_set.get_root(), &deadline);
+    if (options.stat) nfa.add_stats(stats);
+    counters.begin_phase("strings");
+    TestGenerator gen(nfa, base_substring, regex_set.get_punct_marks());
+    gen.set_limits(options.max_strings, options.max_bytes, options.max_length);
+    gen.set_deadline(&deadline);
+    gen.set_path_strategy(options.path_strategy);
+    gen.set_threads(options.threads);
+    vector <string> *strings = &result.strings;
+    gen.gen_test_strings([strings](const string &s) { strings->push_back(s); });
+    if (options.stat) gen.add_stats(stats);
+
+    // find the members that accept each string
+    counters.begin_phase("match");
+    vector <unique_ptr <Matcher> > matchers(regex_set.size());
+    vector <vector <bool> > accepts(regex_set.size());
+    vector <unsigned int> gave_up(regex_set.size(), 0);
+    for (unsigned int i = 0; i < regex_set.size(); i++) {
+      if (regex_set.get_member_tree(i) == NULL) continue;
+      if (deadline.expired("matching regex set members")) break;
+      matchers[i].reset(new Matcher(regex_set.get_member_tree(i)->get_root()));
+      for (unsigned int j = 0; j < result.strings.size(); j++) {
+        accepts[i].push_back(matchers[i]->full_match(result.strings[j]));
+        if (matchers[i]->gave_up()) gave_up[i]++;
+      }
+    }
+
+    // two members that accept a string in common are told apart by a string
+    // that one accepts and the other does not, if the suite has no such
+    // string one is looked for by editing the strings both accept (shortest
+    // first, since they are the quickest to match)
+    counters.begin_phase("discriminate");
+    Budget budget;
+    budget.set_limits(options.max_strings, options.max_bytes, options.max_length);
+    unordered_set <string> in_suite;
+    for (unsigned int j = 0; j < result.strings.size(); j++) {
+      budget.admit(result.strings[j]);
+      in_suite.insert(result.strings[j]);
+    }
+    unsigned int added = 0;
+    unsigned long steps = 0;
+    for (unsigned int i = 0; i < regex_set.size() && !budget.is_exhausted(); i++) {
+      if (!matchers[i] || accepts[i].size() != result.strings.size()) continue;
+      for (unsigned int k = i + 1; k < regex_set.size() && !budget.is_exhausted(); k++) {
+        if (!matchers[k] || accepts[k].size() != result.strings.size()) continue;
+        vector <string> shared;
+        for (unsigned int j = 0; j < result.strings.size(); j++) {
+          if (accepts[i][j] && accepts[k][j]) shared.push_back(result.strings[j]);
+        }
+        if (shared.empty()) continue;
+        stable_sort(shared.begin(), shared.end(), [](const string &x, const string &y) {
+          return x.length() < y.length();
+        });
+        string chars = edit_chars(regexes[i], regexes[k]);
+        for (int side = 0; side < 2; side++) {
+          unsigned int a = side == 0 ? i : k;
+          unsigned int b = side == 0 ? k : i;
+          if (discriminates(accepts[a], accepts[b])) continue;
+          string found;
+          if (!find_discriminating(shared, chars, *matchers[a], *matchers[b], in_suite,
+                                   deadline, steps, found)) continue;
+          if (!budget.admit(found)) break;
+          result.strings.push_back(found);
+          in_suite.insert(found);
+          added++;
+          for (unsigned int m = 0; m < regex_set.size(); m++) {
+            if (!matchers[m] || accepts[m].size() + 1 != result.strings.size()) continue;
+            accepts[m].push_back(matchers[m]->full_match(found));
+            if (matchers[m]->gave_up()) gave_up[m]++;
+          }
+        }
+      }
+    }
+    if (options.stat) {
+      stats.add("REGEX_SET", "Discriminating strings", added);
+      stats.add("REGEX_SET", "Discriminating steps", steps);
+    }
+
+    // report the members that accept each string, members that accept the
+    // same strings are not told apart by the suite
+    result.accepted_by.resize(result.strings.size());
+    map <vector <bool>, unsigned int> first_with;
+    for (unsigned int i = 0; i < regex_set.size(); i++) {
+      if (!matchers[i]) continue;
+      for (unsigned int j = 0; j < accepts[i].size(); j++) {
+        if (accepts[i][j]) result.accepted_by[j].push_back(i);
+      }
+      if (gave_up[i] > 0) {
+        stringstream s;
+        s << "SET WARNING: Member " << i << " gave up matching " << gave_up[i]
+          << " strings (step or depth limit), they are reported as not accepted";
+        addWarning(s.str());
+      }
+      map <vector <bool>, unsigned int>::iterator same = first_with.find(accepts[i]);
+      if (same != first_with.end()) {
+        stringstream s;
+        s << "SET WARNING: Members " << same->second << " and " << i
+          << " accept the same test strings";
+        addWarning(s.str());
+      }
+      else {
+        first_with[accepts[i]] = i;
+      }
+    }
+
+    deadline.add_warnings();
+
+    if (options.debug) {
+      cout << "Regex set:" << endl;
       nfa.print();
     }
+    result.status = warnings;
+    if (result.status == "") result.status = "SUCCESS";
+  }
+  catch (EgretException const &e) {
+    result.status = e.getError();
+    result.strings.clear();
+    result.accepted_by.clear();
+  }
+
+  if (options.stat) {
+    counters.add_stats(stats);
+    deadline.add_stats(stats);
+    stats.print();
+  }
+  return result;
+}
+
+//=============================================================
+// Compiled regexes
+//=============================================================
+
+// The scanner, parse tree, and NFA of a regex.  Every engine run has one:
+// a run on a regex builds its own, a run on a compiled regex shares the
+// one built when the regex was compiled, along with the analyses kept from
+// earlier runs.  An analysis is only kept if it was not cut short by the
+// deadline of the run that made it.
+struct CompiledRegex::Compiled
+{
+  Compiled() {
+    shared = false;
+    redos_done[0] = false;
+    redos_done[1] = false;
+    runs = 0;
+    reused_paths = 0;
+    reused_redos = 0;
+  }
 
-    // print stats
-    Stats stats;
-    if (stat_mode) {
-      scanner.add_stats(stats);
-      tree.add_stats(stats);
-      nfa.add_stats(stats);
-      gen.add_stats(stats);
-      stats.print();
+  string regex;			// regular expression
+  bool shared;			// set if runs share the analyses (compiled by CompiledRegex)
+  string error;			// error message if the regex did not compile ("" if none)
+  string warnings;		// warnings issued while compiling
+  Stats stats;			// stats gathered while compiling
+  Deadline deadline;		// deadline for compiling
+  Scanner scanner;		// scanner
+  ParseTree tree;		// parse tree
+  NFA nfa;			// NFA
+
+  mutex lock;					// guards the analyses and counts below
+  map <PathStrategy, vector <Path> > paths;	// paths for each strategy (before generation)
+  RedosAnalyzer redos;				// REDOS analysis without growth
+  bool redos_done[2];				// set once the REDOS analysis without (0)
+						// and with growth (1) is kept
+  string redos_warnings[2];			// warnings of each REDOS analysis
+  Stats redos_stats[2];				// stats of each REDOS analysis
+  unsigned long runs;				// runs on the compiled regex
+  unsigned long reused_paths;			// runs that reused paths
+  unsigned long reused_redos;			// runs that reused a REDOS analysis
+
+  // scans and parses the regex and builds the NFA, calling begin_phase as
+  // each phase begins and adding stats (if given)
+  void build(Deadline *_deadline, Stats *_stats,
+             const function <void (const string &)> &begin_phase);
+
+  // adds the error (by throwing it), warnings, and stats (if given) of
+  // compiling to a run on the compiled regex
+  void reuse(Stats *_stats);
+
+  // returns the paths kept for strategy (NULL if none are kept)
+  const vector <Path> *get_paths(PathStrategy strategy);
+
+  // keeps the paths for strategy (if none are kept yet)
+  void keep_paths(PathStrategy strategy, const vector <Path> &found);
+
+  // checks for catastrophic backtracking (measuring growth if asked to),
+  // adding the warnings and stats (if given), reuses a kept analysis
+  void analyze_redos(bool growth, Deadline *_deadline, Stats *_stats);
+};
+
+void
+CompiledRegex::Compiled::build(Deadline *_deadline, Stats *_stats,
+                               const function <void (const string &)> &begin_phase)
+{
+  // initialize scanner with regex
+  begin_phase("scan");
+  scanner.init(regex);
+  if (_stats) scanner.add_stats(*_stats);
+
+  // build parse tree
+  begin_phase("parse");
+  tree.build(scanner, _deadline);
+  if (_stats) tree.add_stats(*_stats);
+
+  // build NFA
+  begin_phase("nfa");
+  nfa.build(tree, _deadline);
+  if (_stats) nfa.add_stats(*_stats);
+}
+
+void
+CompiledRegex::Compiled::reuse(Stats *_stats)
+{
+  if (error != "") throw EgretException(error);
+  addWarnings(warnings);
+  if (_stats) _stats->add(stats);
+}
+
+const vector <Path> *
+CompiledRegex::Compiled::get_paths(PathStrategy strategy)
+{
+  if (!shared) return NULL;
+
+  // kept paths are never replaced, so the pointer stays valid
+  lock_guard <mutex> guard(lock);
+  map <PathStrategy, vector <Path> >::iterator it = paths.find(strategy);
+  if (it == paths.end()) return NULL;
+  reused_paths++;
+  return &it->second;
+}
+
+void
+CompiledRegex::Compiled::keep_paths(PathStrategy strategy, const vector <Path> &found)
+{
+  if (!shared) return;
+  lock_guard <mutex> guard(lock);
+  if (paths.find(strategy) == paths.end()) paths[strategy] = found;
+}
+
+void
+CompiledRegex::Compiled::analyze_redos(bool growth, Deadline *_deadline, Stats *_stats)
+{
+  RedosAnalyzer analyzer;
+  bool analyzed = false;
+  int kind = growth ? 1 : 0;
+  if (shared) {
+    lock_guard <mutex> guard(lock);
+    if (redos_done[kind]) {
+      reused_redos++;
+      addWarnings(redos_warnings[kind]);
+      if (_stats) _stats->add(redos_stats[kind]);
+      return;
     }
+    if (redos_done[0]) {
+      analyzer = redos;
+      analyzed = true;
+    }
+  }
+
+  // the analysis runs without the lock, so runs that find nothing kept
+  // may analyze at the same time (the first to finish is kept)
+  if (!analyzed) analyzer.analyze(nfa, _deadline);
+  if (growth) analyzer.measure_growth(tree.get_root(), _deadline);
+  string found_warnings;
+  {
+    WarningScope scope(&found_warnings);
+    analyzer.add_warnings();
+  }
+  Stats found_stats;
+  analyzer.add_stats(found_stats);
+  addWarnings(found_warnings);
+  if (_stats) _stats->add(found_stats);
+  if (!shared || (_deadline && _deadline->has_expired())) return;
+
+  lock_guard <mutex> guard(lock);
+  if (redos_done[kind]) return;
+  redos_done[kind] = true;
+  redos_warnings[kind] = found_warnings;
+  redos_stats[kind] = found_stats;
+  if (!growth) redos = analyzer;
+}
+
+CompiledRegex::CompiledRegex(string regex, const EngineOptions &options)
+{
+  compiled = make_shared <Compiled>();
+  compiled->regex = regex;
+  compiled->shared = true;
+  compiled->deadline.set_timeout(options.timeout);
+  compiled->deadline.set_cancel_token(options.cancel);
+
+  WarningScope scope(&compiled->warnings);
+  try {
+    compiled->build(&compiled->deadline, &compiled->stats, [](const string &name) {});
+
+    // runs on any thread share the tree, so its character sets are filled
+    // in now and only read from here on
+    compiled->tree.prepare_char_sets();
   }
   catch (EgretException const &e) {
-    vector <string> result;
-    result.push_back(e.getError());
-    return result;
+    compiled->error = e.getError();
   }
+}
 
-  // Add warnings to front of list.
-  string warnings = getWarnings();
-  if (warnings == "") warnings = "SUCCESS";
+const string &
+CompiledRegex::get_regex() const
+{
+  return compiled->regex;
+}
 
-  test_strings.insert(test_strings.begin(), warnings);
+const string &
+CompiledRegex::get_error() const
+{
+  return compiled->error;
+}
 
-  return test_strings;
+EngineResult
+CompiledRegex::generate(string base_substring, const EngineOptions &options) const
+{
+  EngineStream stream(*this, base_substring, options);
+  return get_result(stream, options);
+}
+
+vector <bool>
+CompiledRegex::classify(const vector <string> &strings) const
+{
+  vector <bool> accepted(strings.size(), false);
+  if (compiled->error != "" || compiled->tree.get_root() == NULL) return accepted;
+
+  // each call has its own matcher, the tree is only read
+  Matcher matcher(compiled->tree.get_root());
+  for (unsigned int i = 0; i < strings.size(); i++) {
+    accepted[i] = matcher.full_match(strings[i]);
+  }
+  return accepted;
+}
+
+vector <Stats::Stat>
+CompiledRegex::get_stats() const
+{
+  Stats stats;
+  stats.add(compiled->stats);
+  lock_guard <mutex> guard(compiled->lock);
+  stats.add("COMPILED", "Runs", compiled->runs);
+  stats.add("COMPILED", "Path sets kept", compiled->paths.size());
+  stats.add("COMPILED", "Runs reusing paths", compiled->reused_paths);
+  stats.add("COMPILED", "Runs reusing REDOS analysis", compiled->reused_redos);
+  return stats.get_stats();
+}
+
+//=============================================================
+// Engine stream
+//=============================================================
+
+typedef enum {
+  RUN_NOT_STARTED,
+  RUN_GENERATING,
+  RUN_DONE
+} RunState;
+
+struct EngineStream::Run
+{
+  Run(string _regex, string _base_substring, const EngineOptions &_options);
+
+  string regex;			// regular expression
+  string base_substring;	// base substring for regex strings
+  EngineOptions options;	// options for the run
+  RunState state;		// where the run is
+  bool error;			// set if the run stopped with an error
+  string status;		// status once the run is done
+  string warnings;		// warnings for the run
+  Deadline deadline;		// deadline for the run
+  Stats stats;			// stats gathered as each phase completes
+  PhaseCounters counters;	// hot path counts for each phase
+  Trace *trace;			// trace of the run (NULL unless requested)
+  shared_ptr <CompiledRegex::Compiled> compiled;	// scanner, parse tree, and NFA
+  TestGenerator *gen;		// test generator (NULL until the NFA is built)
+  MatchProfile *profile;	// backtracking profile (NULL unless requested)
+  Matcher *matcher;		// matcher for verdicts (NULL until one is asked for)
+  deque <pair <string, StringSource> > pending;	// generated strings not yet consumed
+
+  // begins a phase of the run
+  void begin_phase(const string &name);
+
+  // builds the NFA and generates the initial strings
+  void start();
+
+  // finishes a successful run
+  void complete();
+
+  // finishes a run that stopped with an error
+  void fail(const EgretException &e);
+
+  // writes the trace (if requested)
+  void write_trace();
+};
+
+EngineStream::EngineStream(string regex, string base_substring, const EngineOptions &options)
+{
+  run = new Run(regex, base_substring, options);
+  run->compiled = make_shared <CompiledRegex::Compiled>();
+  run->compiled->regex = regex;
+}
+
+EngineStream::EngineStream(const CompiledRegex &regex, string base_substring,
+                           const EngineOptions &options)
+{
+  run = new Run(regex.get_regex(), base_substring, options);
+  run->compiled = regex.compiled;
+  lock_guard <mutex> guard(run->compiled->lock);
+  run->compiled->runs++;
+}
+
+EngineStream::~EngineStream()
+{
+  delete run->gen;
+  delete run->profile;
+  delete run->matcher;
+  delete run->trace;
+  delete run;
+}
+
+bool
+EngineStream::next(string &s)
+{
+  StringSource source;
+  return next(s, source);
+}
+
+bool
+EngineStream::next(string &s, StringSource &source)
+{
+  WarningScope scope(&run->warnings);
+
+  try {
+    if (run->state == RUN_NOT_STARTED) {
+      run->start();
+    }
+    while (run->pending.empty() && run->state == RUN_GENERATING) {
+      if (!run->gen->next_batch()) {
+        run->complete();
+      }
+    }
+  }
+  catch (EgretException const &e) {
+    run->fail(e);
+  }
+
+  if (run->pending.empty()) return false;
+  s = run->pending.front().first;
+  source = run->pending.front().second;
+  run->pending.pop_front();
+  return true;
+}
+
+bool
+EngineStream::is_done()
+{
+  return run->state == RUN_DONE && run->pending.empty();
+}
+
+bool
+EngineStream::has_error()
+{
+  return run->error;
+}
+
+string
+EngineStream::get_status()
+{
+  return run->status;
+}
+
+vector <Warning>
+EngineStream::get_warnings()
+{
+  return splitWarnings(run->warnings);
+}
+
+const vector <Stats::Stat> &
+EngineStream::get_stats()
+{
+  return run->stats.get_stats();
+}
+
+bool
+EngineStream::accepts(const string &s)
+{
+  ParseNode *root = run->compiled->tree.get_root();
+  if (root == NULL) return false;
+  if (run->matcher == NULL) run->matcher = new Matcher(root);
+  return run->matcher->full_match(s);
+}
+
+EngineStream::Run::Run(string _regex, string _base_substring, const EngineOptions &_options)
+{
+  regex = _regex;
+  base_substring = _base_substring;
+  options = _options;
+  state = RUN_NOT_STARTED;
+  error = false;
+  gen = NULL;
+  profile = NULL;
+  matcher = NULL;
+  trace = NULL;
+  if (options.trace_file != "") trace = new Trace("egret: " + regex);
+
+  // start the clock
+  deadline.set_timeout(options.timeout);
+  deadline.set_cancel_token(options.cancel);
+}
+
+void
+EngineStream::Run::begin_phase(const string &name)
+{
+  counters.begin_phase(name);
+  if (trace) trace->begin_phase(name);
+}
+
+void
+EngineStream::Run::start()
+{
+  state = RUN_GENERATING;
+
+  check_base_substring(base_substring);
+
+  // scan, parse and build the NFA (a compiled regex has them already)
+  Stats *run_stats = options.stat ? &stats : NULL;
+  if (compiled->shared) {
+    compiled->reuse(run_stats);
+  }
+  else {
+    compiled->build(&deadline, run_stats, [this](const string &name) { begin_phase(name); });
+  }
+  ParseTree &tree = compiled->tree;
+  if (options.profile) profile = new MatchProfile(tree.get_root(), regex);
+
+  // generate initial strings
+  begin_phase("paths");
+  gen = new TestGenerator(compiled->nfa, base_substring, tree.get_punct_marks());
+  gen->set_limits(options.max_strings, options.max_bytes, options.max_length);
+  gen->set_deadline(&deadline);
+  gen->set_path_strategy(options.path_strategy);
+  gen->set_threads(options.threads);
+  gen->set_trace(trace, options.trace_paths);
+  const vector <Path> *kept = compiled->get_paths(options.path_strategy);
+  if (kept) {
+    gen->set_paths(*kept);
+  }
+  else {
+    gen->find_paths();
+    if (!deadline.has_expired()) compiled->keep_paths(options.path_strategy, gen->get_paths());
+  }
+  deque <pair <string, StringSource> > *output = &pending;
+  MatchProfile *match_profile = profile;
+  gen->begin([output, match_profile](const string &s, StringSource source) {
+    output->push_back(make_pair(s, source));
+    if (match_profile) match_profile->add(s);
+  });
+
+  // check for catastrophic backtracking
+  begin_phase("redos");
+  compiled->analyze_redos(options.growth, &deadline, run_stats);
+
+  // evil strings are generated as they are consumed
+  begin_phase("evil");
+}
+
+void
+EngineStream::Run::complete()
+{
+  state = RUN_DONE;
+  deadline.add_warnings();
+  if (options.stat) gen->add_stats(stats);
+  write_trace();
+
+  // print debug info
+  if (options.debug) {
+    cout << "RegEx: " << regex << endl;
+    compiled->scanner.print();
+    compiled->tree.print();
+    compiled->nfa.print();
+  }
+
+  // print stats
+  if (options.stat) {
+    counters.add_stats(stats);
+    deadline.add_stats(stats);
+    stats.print();
+  }
+
+  // print the backtracking profile
+  if (profile) profile->print();
+
+  status = warnings;
+  if (status == "") status = "SUCCESS";
+}
+
+void
+EngineStream::Run::fail(const EgretException &e)
+{
+  state = RUN_DONE;
+  error = true;
+  status = e.getError();
+  pending.clear();
+  write_trace();
+
+  // print stats
+  if (options.stat) {
+    counters.add_stats(stats);
+    deadline.add_stats(stats);
+    stats.print();
+  }
+}
+
+void
+EngineStream::Run::write_trace()
+{
+  if (trace == NULL) return;
+  if (!trace->write(options.trace_file)) {
+    addWarning("TRACE WARNING: Unable to write trace file " + options.trace_file);
+  }
+}
+
+static void
+check_base_substring(const string &base_substring)
+{
+  if (base_substring.length() < 2) {
+    throw EgretException("ERROR: Base substring must have at least two letters");
+  }
+  for (unsigned int i = 0; i < base_substring.length(); i++) {
+    if (!isalpha(base_substring[i])) {
+      throw EgretException("ERROR: Base substring can only contain letters");
+    }
+  }
 }
@@ -22,12 +22,216 @@
 #ifndef EGRET_H
 #define EGRET_H
 
+#include <memory>
 #include <string>
 #include <vector>
+#include "Deadline.h"
+#include "PathStrategy.h"
+#include "Sink.h"
+#include "Stats.h"
+#include "error.h"
 using namespace std;
 
+// engine version (recorded in suite files)
+#define EGRET_VERSION "1.0"
+
+// options for an engine run
+struct EngineOptions
+{
+  EngineOptions() {
+    debug = false;
+    stat = false;
+    max_strings = 0;
+    max_bytes = 0;
+    max_length = 0;
+    timeout = 0;
+    cancel = NULL;
+    path_strategy = BASIS_PATHS;
+    threads = 1;
+    profile = false;
+    growth = false;
+    verdicts = false;
+    trace_paths = false;
+  }
+
+  bool debug;			// print debug info
+  bool stat;			// print stats
+  unsigned int max_strings;	// maximum number of test strings (0 if no limit)
+  unsigned long max_bytes;	// maximum total bytes of test strings (0 if no limit)
+  unsigned int max_length;	// maximum length of a test string (0 if no limit)
+  double timeout;		// time limit in seconds (0 if no limit)
+  CancelToken *cancel;		// cancellation token checked during the run (NULL if none)
+  PathStrategy path_strategy;	// how paths through the NFA are chosen
+  unsigned int threads;		// threads generating evil strings (0 for one per core)
+  bool profile;			// print the backtracking steps taken by the test strings
+  bool growth;			// measure how matching steps grow for each REDOS finding
+  bool verdicts;		// decide which test strings the regex accepts (run_engine_result)
+  string trace_file;		// write a Chrome trace of the run to this file ("" for none)
+  bool trace_paths;		// trace the work for each path as well as each phase
+};
+
+// outcome of an engine run
+typedef enum {
+  STATUS_SUCCESS,		// test strings were generated without warnings
+  STATUS_WARNING,		// test strings were generated with warnings
+  STATUS_ERROR			// the run stopped with an error
+} EngineStatus;
+
+// result of an engine run
+struct EngineResult
+{
+  EngineStatus status;			// outcome of the run
+  string error;				// error message (for STATUS_ERROR)
+  vector <Warning> warnings;		// warnings in the order they were issued
+  vector <string> strings;		// test strings, most recently generated first
+  vector <StringSource> sources;	// where each test string came from
+  vector <Stats::Stat> stats;		// stats (if options.stat is set)
+  vector <bool> accepted;		// whether the regex accepts each string
+					// (if options.verdicts is set)
+};
+
 // run_engine: entry point into EGRET engine
 vector <string>
 run_engine(string regex, string base_substring, bool debug = false, bool stat = false);
 
+// run_engine: entry point into EGRET engine (with options)
+vector <string>
+run_engine(string regex, string base_substring, const EngineOptions &options);
+
+// run_engine: entry point into EGRET engine for several base substrings,
+// returns a suite for each (status first, as above).  The regex is compiled
+// and its paths enumerated once, and only the strings are generated again
+// for each base substring.
+vector <vector <string> >
+run_engine(string regex, const vector <string> &base_substrings, const EngineOptions &options);
+
+// run_engine_result: entry point into EGRET engine that returns the status,
+// warnings, and test strings separately (the matcher decides which strings
+// are accepted, as Python's re would, and reports a match that gives up at
+// its step or depth limit as not accepted)
+EngineResult
+run_engine_result(string regex, string base_substring, const EngineOptions &options);
+
+// run_engine: streaming entry point into EGRET engine, each test string is
+// passed to sink as soon as it is generated (in generation order), returns
+// the status (SUCCESS, warnings, or an error message)
+string
+run_engine(string regex, string base_substring, const EngineOptions &options, StringSink sink);
+
+// write_suite: runs the EGRET engine and writes the test strings to a binary
+// suite file (see SuiteFile.h), accept (if given) decides which strings the
+// regex accepts, returns the status (SUCCESS, warnings, or an error message)
+string
+write_suite(string regex, string base_substring, const EngineOptions &options,
+            string file_name, function <bool (const string &)> accept = nullptr);
+
+// write_suite: writes the test strings of a finished run to a binary suite
+// file, so a caller that already has the result need not run the engine
+// again, returns the status of the run (or an error message)
+string
+write_suite(const EngineResult &result, string regex, string base_substring,
+            string file_name, function <bool (const string &)> accept = nullptr);
+
+// result of a regex set run
+struct RegexSetResult
+{
+  string status;				// SUCCESS, warnings, or an error message
+  vector <string> member_errors;		// parse error of each member ("" if it parsed)
+  vector <string> strings;			// test strings in generation order
+  vector <vector <unsigned int> > accepted_by;	// members that accept each string
+};
+
+// run_regex_set: runs the EGRET engine on a set of regexes at once, with
+// their common prefixes shared (see RegexSet.h), and reports which members
+// accept each test string (a member that does not parse is left out)
+RegexSetResult
+run_regex_set(const vector <string> &regexes, string base_substring, const EngineOptions &options);
+
+// CompiledRegex: a regex scanned, parsed and built into an NFA once, for
+// callers that run the engine on the same regex many times (with different
+// base substrings or options).  The paths for each path strategy and the
+// REDOS analysis are kept from the first run that completes them, so later
+// runs only generate strings.  A compiled regex can be used from several
+// threads at once, and copies share the compiled state.
+class CompiledRegex {
+
+public:
+
+  // compiles regex (only the time limit and cancellation token of options
+  // are used, a regex that does not compile in time gets an error)
+  CompiledRegex(string regex, const EngineOptions &options = EngineOptions());
+
+  // returns the regex
+  const string &get_regex() const;
+
+  // returns the error message if the regex did not compile ("" if it did)
+  const string &get_error() const;
+
+  // runs the engine on the compiled regex (as run_engine_result does)
+  EngineResult generate(string base_substring, const EngineOptions &options) const;
+
+  // returns whether the regex accepts each string (as verdicts in
+  // EngineResult, all false if the regex did not compile)
+  vector <bool> classify(const vector <string> &strings) const;
+
+  // returns the stats gathered while compiling, followed by counts of the
+  // runs and of the analyses they reused
+  vector <Stats::Stat> get_stats() const;
+
+private:
+
+  friend class EngineStream;
+
+  struct Compiled;
+  shared_ptr <Compiled> compiled;	// state shared by copies and runs
+};
+
+// EngineStream: a run of the EGRET engine that produces test strings on
+// demand, so callers can consume strings while generation continues
+class EngineStream {
+
+public:
+
+  EngineStream(string regex, string base_substring, const EngineOptions &options);
+
+  // a run on a compiled regex (which need not outlive the stream)
+  EngineStream(const CompiledRegex &regex, string base_substring, const EngineOptions &options);
+
+  ~EngineStream();
+
+  // gets the next test string, returns false when there are no more
+  bool next(string &s);
+
+  // gets the next test string and where it came from
+  bool next(string &s, StringSource &source);
+
+  // returns true once all strings have been produced
+  bool is_done();
+
+  // returns true if the run stopped with an error
+  bool has_error();
+
+  // returns the status: SUCCESS, the warnings, or an error message
+  // (only complete once next has returned false)
+  string get_status();
+
+  // returns the warnings (only complete once next has returned false)
+  vector <Warning> get_warnings();
+
+  // returns the stats gathered so far (if options.stat is set)
+  const vector <Stats::Stat> &get_stats();
+
+  // returns true if the regex accepts s (false if the run stopped with an
+  // error before the regex was parsed)
+  bool accepts(const string &s);
+
+private:
+
+  struct Run;
+  Run *run;			// engine state for the run
+
+  EngineStream(const EngineStream &other);
+  EngineStream &operator= (const EngineStream &other);
+};
+
 #endif // EGRET_H
@@ -19,7 +19,12 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#define PY_SSIZE_T_CLEAN
 #include <Python.h>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <functional>
 #include <string>
 #include <vector>
 #include "egret.h"
@@ -27,30 +32,1298 @@ using namespace std;
 
 static PyObject *EgretExtError;
 
+// sets the path strategy from its name (NULL keeps the default), raises
+// ValueError if there is no such strategy
+static bool
+set_path_strategy(const char *name, EngineOptions &options)
+{
+  if (name != NULL && !parse_path_strategy(name, options.path_strategy)) {
+    PyErr_Format(PyExc_ValueError, "invalid path strategy: %s", name);
+    return false;
+  }
+  return true;
+}
+
+//=============================================================
+// Argument parsing
+//=============================================================
+
+// The module functions take their arguments through the fast calling
+// convention where the interpreter has it (3.7 and later), so no argument
+// tuple or keyword dict is built for each call.  The same parser handles the
+// tuple and dict form on older interpreters.
+#if PY_VERSION_HEX >= 0x03070000
+#define EGRET_FASTCALL
+#define ENGINE_CALL_FLAGS (METH_FASTCALL | METH_KEYWORDS)
+#define ENGINE_CALL(name, impl) \
+  static PyObject * \
+  name(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames) \
+  { \
+    return impl(args, nargs, kwnames, NULL); \
+  }
+#else
+#define ENGINE_CALL_FLAGS (METH_VARARGS | METH_KEYWORDS)
+#define ENGINE_CALL(name, impl) \
+  static PyObject * \
+  name(PyObject *self, PyObject *args, PyObject *kwargs) \
+  { \
+    return impl(&PyTuple_GET_ITEM(args, 0), PyTuple_GET_SIZE(args), NULL, kwargs); \
+  }
+#endif
+
+// every engine call has (at most) four positional arguments followed by
+// the keyword only engine options
+#define NUM_POSITIONAL 4
+#define NUM_ARGS 15
+
+// stores a keyword argument in values, raises TypeError if the name is
+// unknown or the argument was already given
+static bool
+set_keyword_arg(const char *fname, const char **kwlist, PyObject *name, PyObject *value,
+                PyObject **values)
+{
+  if (!PyUnicode_Check(name)) {
+    PyErr_Format(PyExc_TypeError, "%s() keywords must be strings", fname);
+    return false;
+  }
+  for (int i = 0; i < NUM_ARGS; i++) {
+    if (PyUnicode_CompareWithASCIIString(name, kwlist[i]) == 0) {
+      if (values[i] != NULL) {
+        PyErr_Format(PyExc_TypeError, "argument for %s() given by name ('%s') and position (%d)",
+                     fname, kwlist[i], i + 1);
+        return false;
+      }
+      values[i] = value;
+      return true;
+    }
+  }
+  PyErr_Format(PyExc_TypeError, "'%U' is an invalid keyword argument for %s()", name, fname);
+  return false;
+}
+
+// matches the arguments of a call to kwlist, values gets a borrowed
+// reference for each argument given (NULL for the rest), keywords come from
+// kwnames (fast calls) or kwargs
+static bool
+collect_args(const char *fname, const char **kwlist, int required,
+             PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames, PyObject *kwargs,
+             PyObject **values)
+{
+  for (int i = 0; i < NUM_ARGS; i++) {
+    values[i] = NULL;
+  }
+
+  if (nargs > NUM_POSITIONAL) {
+    PyErr_Format(PyExc_TypeError, "%s() takes at most %d positional arguments (%zd given)",
+                 fname, NUM_POSITIONAL, nargs);
+    return false;
+  }
+  for (Py_ssize_t i = 0; i < nargs; i++) {
+    values[i] = args[i];
+  }
+
+  if (kwnames != NULL) {
+    for (Py_ssize_t i = 0; i < PyTuple_GET_SIZE(kwnames); i++) {
+      if (!set_keyword_arg(fname, kwlist, PyTuple_GET_ITEM(kwnames, i), args[nargs + i], values))
+        return false;
+    }
+  }
+  if (kwargs != NULL) {
+    PyObject *name;
+    PyObject *value;
+    Py_ssize_t pos = 0;
+    while (PyDict_Next(kwargs, &pos, &name, &value)) {
+      if (!set_keyword_arg(fname, kwlist, name, value, values))
+        return false;
+    }
+  }
+
+  for (int i = 0; i < required; i++) {
+    if (values[i] == NULL) {
+      PyErr_Format(PyExc_TypeError, "%s() missing required argument '%s' (pos %d)",
+                   fname, kwlist[i], i + 1);
+      return false;
+    }
+  }
+  return true;
+}
+
+// converts a str argument (None is allowed if none_ok), the UTF-8 buffer is
+// owned by the str object
+static bool
+get_string_arg(const char *fname, const char *name, PyObject *value, bool none_ok,
+               const char **result)
+{
+  if (value == Py_None && none_ok) {
+    *result = NULL;
+    return true;
+  }
+  if (!PyUnicode_Check(value)) {
+    PyErr_Format(PyExc_TypeError, "%s() argument '%s' must be str%s, not %.50s",
+                 fname, name, none_ok ? " or None" : "", Py_TYPE(value)->tp_name);
+    return false;
+  }
+  Py_ssize_t length;
+  const char *s = PyUnicode_AsUTF8AndSize(value, &length);
+  if (s == NULL)
+    return false;
+  if ((Py_ssize_t) strlen(s) != length) {
+    PyErr_SetString(PyExc_ValueError, "embedded null character");
+    return false;
+  }
+  *result = s;
+  return true;
+}
+
+// converts an int argument (like the I and k formats, no overflow check)
+static bool
+get_unsigned_arg(const char *fname, const char *name, PyObject *value, unsigned long &result)
+{
+  if (!PyLong_Check(value)) {
+    PyErr_Format(PyExc_TypeError, "%s() argument '%s' must be int, not %.50s",
+                 fname, name, Py_TYPE(value)->tp_name);
+    return false;
+  }
+  result = PyLong_AsUnsignedLongMask(value);
+  return !(result == (unsigned long) -1 && PyErr_Occurred());
+}
+
+// converts the keyword only engine options (values[NUM_POSITIONAL] on)
+static bool
+get_engine_options(const char *fname, const char **kwlist, PyObject **values,
+                   EngineOptions &options)
+{
+  unsigned long n;
+  PyObject *value;
+
+  if ((value = values[4]) != NULL) {
+    if (!get_unsigned_arg(fname, kwlist[4], value, n)) return false;
+    options.max_strings = n;
+  }
+  if ((value = values[5]) != NULL) {
+    if (!get_unsigned_arg(fname, kwlist[5], value, n)) return false;
+    options.max_bytes = n;
+  }
+  if ((value = values[6]) != NULL) {
+    if (!get_unsigned_arg(fname, kwlist[6], value, n)) return false;
+    options.max_length = n;
+  }
+  if ((value = values[7]) != NULL) {
+    options.timeout = PyFloat_AsDouble(value);
+    if (options.timeout == -1.0 && PyErr_Occurred()) return false;
+  }
+  if ((value = values[8]) != NULL) {
+    const char *paths;
+    if (!get_string_arg(fname, kwlist[8], value, true, &paths)) return false;
+    if (!set_path_strategy(paths, options)) return false;
+  }
+  if ((value = values[9]) != NULL) {
+    if (!get_unsigned_arg(fname, kwlist[9], value, n)) return false;
+    options.threads = n;
+  }
+  if ((value = values[10]) != NULL) {
+    int flag = PyObject_IsTrue(value);
+    if (flag < 0) return false;
+    options.profile = flag;
+  }
+  if ((value = values[11]) != NULL) {
+    int flag = PyObject_IsTrue(value);
+    if (flag < 0) return false;
+    options.growth = flag;
+  }
+  if ((value = values[12]) != NULL) {
+    int flag = PyObject_IsTrue(value);
+    if (flag < 0) return false;
+    options.verdicts = flag;
+  }
+  if ((value = values[13]) != NULL) {
+    const char *trace;
+    if (!get_string_arg(fname, kwlist[13], value, true, &trace)) return false;
+    options.trace_file = trace != NULL ? trace : "";
+  }
+  if ((value = values[14]) != NULL) {
+    int flag = PyObject_IsTrue(value);
+    if (flag < 0) return false;
+    options.trace_paths = flag;
+  }
+  return true;
+}
+
+// converts the debug and stat flags (values[2] and values[3])
+static bool
+get_flag_args(PyObject **values, EngineOptions &options)
+{
+  for (int i = 2; i <= 3; i++) {
+    int flag = 0;
+    if (values[i] != NULL && (flag = PyObject_IsTrue(values[i])) < 0)
+      return false;
+    if (i == 2)
+      options.debug = flag;
+    else
+      options.stat = flag;
+  }
+  return true;
+}
+
+// parses the regex, base substring and engine options shared by run,
+// run_bulk and stream (only the first required arguments must be given)
+static bool
+parse_engine_args(const char *fname, int required,
+                  PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames, PyObject *kwargs,
+                  const char **regex, const char **base_substring, EngineOptions &options)
+{
+  static const char *kwlist[] = { "regex", "base_substring", "debug", "stat",
+    "max_strings", "max_bytes", "max_length", "timeout", "paths", "threads", "profile",
+    "growth", "verdicts", "trace", "trace_paths" };
+  PyObject *values[NUM_ARGS];
+
+  if (!collect_args(fname, kwlist, required, args, nargs, kwnames, kwargs, values)
+      || !get_string_arg(fname, kwlist[0], values[0], false, regex)
+      || !get_string_arg(fname, kwlist[1], values[1], false, base_substring))
+    return false;
+
+  return get_flag_args(values, options) && get_engine_options(fname, kwlist, values, options);
+}
+
+//=============================================================
+// Run: returns the status followed by the test strings
+//=============================================================
+
+// converts strings to a list (the list steals the reference to each str)
+static PyObject *
+string_list(const vector <string> &strings)
+{
+  PyObject *list = PyList_New(strings.size());
+  if (list == NULL)
+    return NULL;
+  for (unsigned int i = 0; i < strings.size(); i++) {
+    PyObject *str = PyUnicode_FromStringAndSize(strings[i].data(), strings[i].length());
+    if (str == NULL) {
+      Py_DECREF(list);
+      return NULL;
+    }
+    PyList_SET_ITEM(list, i, str);
+  }
+  return list;
+}
+
 static PyObject *
-egret_run(PyObject *self, PyObject *args)
+run_impl(PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames, PyObject *kwargs)
 {
   const char *regex;
   const char *base_substring;
-  int debug_mode;
-  int stat_mode;
+  EngineOptions options;
 
-  if (!PyArg_ParseTuple(args, "sspp", &regex, &base_substring, &debug_mode, &stat_mode))
+  if (!parse_engine_args("run", 4, args, nargs, kwnames, kwargs, &regex, &base_substring, options))
     return NULL;
 
-  vector <string> tests = run_engine(regex, base_substring, debug_mode, stat_mode);
+  // the engine does not touch Python objects, so other threads may run
+  vector <string> tests;
+  Py_BEGIN_ALLOW_THREADS
+  tests = run_engine(regex, base_substring, options);
+  Py_END_ALLOW_THREADS
+
+  return string_list(tests);
+}
+
+ENGINE_CALL(egret_run, run_impl)
 
-  PyObject *list = PyList_New(0);
-  vector <string>::iterator it;
-  for (it = tests.begin(); it != tests.end(); it++) {
-    PyList_Append(list, PyUnicode_FromString((*it).c_str()));
+//=============================================================
+// Run bases: returns a list (as run returns) for each base substring
+//=============================================================
+
+static PyObject *
+run_bases_impl(PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames, PyObject *kwargs)
+{
+  static const char *kwlist[] = { "regex", "base_substrings", "debug", "stat",
+    "max_strings", "max_bytes", "max_length", "timeout", "paths", "threads", "profile",
+    "growth", "verdicts", "trace", "trace_paths" };
+  PyObject *values[NUM_ARGS];
+  const char *regex;
+  EngineOptions options;
+
+  if (!collect_args("run_bases", kwlist, 2, args, nargs, kwnames, kwargs, values)
+      || !get_string_arg("run_bases", kwlist[0], values[0], false, &regex)
+      || !get_flag_args(values, options)
+      || !get_engine_options("run_bases", kwlist, values, options))
+    return NULL;
+
+  if (PyUnicode_Check(values[1])) {
+    PyErr_SetString(PyExc_TypeError,
+                    "run_bases() argument 'base_substrings' must be a sequence of str, not str");
+    return NULL;
   }
+  PyObject *seq = PySequence_Fast(values[1], "run_bases() argument 'base_substrings' must be a sequence");
+  if (seq == NULL)
+    return NULL;
+  vector <string> bases;
+  for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(seq); i++) {
+    const char *base;
+    if (!get_string_arg("run_bases", "base_substrings", PySequence_Fast_GET_ITEM(seq, i), false, &base)) {
+      Py_DECREF(seq);
+      return NULL;
+    }
+    bases.push_back(base);
+  }
+  Py_DECREF(seq);
+
+  vector <vector <string> > suites;
+  Py_BEGIN_ALLOW_THREADS
+  suites = run_engine(regex, bases, options);
+  Py_END_ALLOW_THREADS
 
+  PyObject *list = PyList_New(suites.size());
+  if (list == NULL)
+    return NULL;
+  for (unsigned int i = 0; i < suites.size(); i++) {
+    PyObject *suite = string_list(suites[i]);
+    if (suite == NULL) {
+      Py_DECREF(list);
+      return NULL;
+    }
+    PyList_SET_ITEM(list, i, suite);
+  }
   return list;
 }
 
+ENGINE_CALL(egret_run_bases, run_bases_impl)
+
+//=============================================================
+// Strings: test strings packed into one buffer, the str objects
+// are only created when the strings are accessed
+//=============================================================
+
+// The strings and their offsets are stored inline, so a suite of any size
+// is one allocation.  The offsets (count + 1 of them) come first, string i
+// is data[offsets[i]:offsets[i + 1]].
+typedef struct {
+  PyObject_VAR_HEAD
+  Py_ssize_t count;		// number of strings
+  Py_ssize_t num_offsets;	// count + 1 (shape of the offsets buffer)
+  Py_ssize_t data_length;	// total bytes of the strings
+  PyObject *status;		// SUCCESS, warnings, or an error message
+  Py_ssize_t storage[1];	// offsets followed by the string data
+} StringsObject;
+
+// buffer over the offsets of a Strings object
+typedef struct {
+  PyObject_HEAD
+  StringsObject *strings;	// owner of the offsets
+} OffsetsObject;
+
+static PyTypeObject StringsType = {
+  PyVarObject_HEAD_INIT(NULL, 0)
+};
+
+static PyTypeObject OffsetsType = {
+  PyVarObject_HEAD_INIT(NULL, 0)
+};
+
+static const char *
+Strings_data(StringsObject *self)
+{
+  return (const char *) (self->storage + self->num_offsets);
+}
+
+static void
+Strings_dealloc(StringsObject *self)
+{
+  Py_XDECREF(self->status);
+  Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static Py_ssize_t
+Strings_length(StringsObject *self)
+{
+  return self->count;
+}
+
+static PyObject *
+Strings_item(StringsObject *self, Py_ssize_t i)
+{
+  if (i < 0 || i >= self->count) {
+    PyErr_SetString(PyExc_IndexError, "egret_ext.Strings index out of range");
+    return NULL;
+  }
+  Py_ssize_t start = self->storage[i];
+  return PyUnicode_FromStringAndSize(Strings_data(self) + start, self->storage[i + 1] - start);
+}
+
+static int
+Strings_getbuffer(StringsObject *self, Py_buffer *view, int flags)
+{
+  return PyBuffer_FillInfo(view, (PyObject *) self, (void *) Strings_data(self),
+                           self->data_length, 1, flags);
+}
+
+static PyObject *
+Strings_get_status(StringsObject *self, void *closure)
+{
+  Py_INCREF(self->status);
+  return self->status;
+}
+
+static PyObject *
+Strings_get_offsets(StringsObject *self, void *closure)
+{
+  OffsetsObject *offsets = PyObject_New(OffsetsObject, &OffsetsType);
+  if (offsets == NULL)
+    return NULL;
+  Py_INCREF(self);
+  offsets->strings = self;
+
+  PyObject *view = PyMemoryView_FromObject((PyObject *) offsets);
+  Py_DECREF(offsets);
+  return view;
+}
+
+static PyGetSetDef Strings_getset[] = {
+  {(char *) "status", (getter) Strings_get_status, NULL,
+   (char *) "SUCCESS, warnings, or an error message", NULL},
+  {(char *) "offsets", (getter) Strings_get_offsets, NULL,
+   (char *) "memoryview of len(self) + 1 offsets into the string data", NULL},
+  {NULL, NULL, NULL, NULL, NULL}  /* Sentinel */
+};
+
+static PySequenceMethods Strings_as_sequence = {
+  (lenfunc) Strings_length,	/* sq_length */
+  0,				/* sq_concat */
+  0,				/* sq_repeat */
+  (ssizeargfunc) Strings_item,	/* sq_item */
+};
+
+static PyBufferProcs Strings_as_buffer = {
+  (getbufferproc) Strings_getbuffer,	/* bf_getbuffer */
+  NULL,					/* bf_releasebuffer */
+};
+
+static void
+Offsets_dealloc(OffsetsObject *self)
+{
+  Py_DECREF(self->strings);
+  Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static int
+Offsets_getbuffer(OffsetsObject *self, Py_buffer *view, int flags)
+{
+  if ((flags & PyBUF_WRITABLE) == PyBUF_WRITABLE) {
+    PyErr_SetString(PyExc_BufferError, "egret_ext.Strings offsets are read only");
+    return -1;
+  }
+  StringsObject *strings = self->strings;
+  Py_INCREF(self);
+  view->obj = (PyObject *) self;
+  view->buf = (void *) strings->storage;
+  view->len = strings->num_offsets * sizeof(Py_ssize_t);
+  view->readonly = 1;
+  view->itemsize = sizeof(Py_ssize_t);
+  view->format = (flags & PyBUF_FORMAT) ? (char *) "n" : NULL;
+  view->ndim = 1;
+  view->shape = (flags & PyBUF_ND) ? &strings->num_offsets : NULL;
+  view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? &view->itemsize : NULL;
+  view->suboffsets = NULL;
+  view->internal = NULL;
+  return 0;
+}
+
+static PyBufferProcs Offsets_as_buffer = {
+  (getbufferproc) Offsets_getbuffer,	/* bf_getbuffer */
+  NULL,					/* bf_releasebuffer */
+};
+
+// makes a Strings object for count strings of data_length bytes in total,
+// the caller fills in the offsets and the data
+static StringsObject *
+new_strings(Py_ssize_t count, Py_ssize_t data_length, const string &status)
+{
+  Py_ssize_t offsets_size = (count + 1) * sizeof(Py_ssize_t);
+  StringsObject *strings = PyObject_NewVar(StringsObject, &StringsType,
+                                           offsets_size + data_length);
+  if (strings == NULL)
+    return NULL;
+  strings->count = count;
+  strings->num_offsets = count + 1;
+  strings->data_length = data_length;
+  strings->status = PyUnicode_FromStringAndSize(status.data(), status.length());
+  if (strings->status == NULL) {
+    Py_DECREF(strings);
+    return NULL;
+  }
+  return strings;
+}
+
+static PyObject *
+run_bulk_impl(PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames, PyObject *kwargs)
+{
+  const char *regex;
+  const char *base_substring;
+  EngineOptions options;
+
+  if (!parse_engine_args("run_bulk", 4, args, nargs, kwnames, kwargs,
+                         &regex, &base_substring, options))
+    return NULL;
+
+  // the strings are packed as they are generated, ends[i] is the end of
+  // string i in data
+  string data;
+  vector <Py_ssize_t> ends;
+  string status;
+  Py_BEGIN_ALLOW_THREADS
+  status = run_engine(regex, base_substring, options, [&](const string &s) {
+    data += s;
+    ends.push_back(data.length());
+  });
+  Py_END_ALLOW_THREADS
+  if (status.compare(0, 5, "ERROR") == 0) {
+    data.clear();
+    ends.clear();
+  }
+
+  Py_ssize_t count = ends.size();
+  StringsObject *strings = new_strings(count, data.length(), status);
+  if (strings == NULL)
+    return NULL;
+
+  // most recently generated strings come first (same order as run)
+  char *out = (char *) (strings->storage + count + 1);
+  Py_ssize_t pos = 0;
+  for (Py_ssize_t i = 0; i < count; i++) {
+    Py_ssize_t end = ends[count - 1 - i];
+    Py_ssize_t start = count - 1 - i == 0 ? 0 : ends[count - 2 - i];
+    strings->storage[i] = pos;
+    memcpy(out + pos, data.data() + start, end - start);
+    pos += end - start;
+  }
+  strings->storage[count] = pos;
+
+  return (PyObject *) strings;
+}
+
+ENGINE_CALL(egret_run_bulk, run_bulk_impl)
+
+//=============================================================
+// Result: the status, warnings, and test strings of a run kept
+// apart, so callers do not parse the status
+//=============================================================
+
+static PyTypeObject ResultType;
+
+static PyStructSequence_Field Result_fields[] = {
+  {(char *) "status", (char *) "STATUS_SUCCESS, STATUS_WARNING, or STATUS_ERROR"},
+  {(char *) "error", (char *) "error message (None unless the status is STATUS_ERROR)"},
+  {(char *) "warnings", (char *) "list of (code, message) for each warning"},
+  {(char *) "strings", (char *) "test strings (egret_ext.Strings)"},
+  {(char *) "stats", (char *) "list of (tag, name, value) for each stat (None unless stat is set)"},
+  {(char *) "accepted", (char *) "bytes with 1 for each string the regex accepts, else 0 "
+   "(None unless verdicts is set)"},
+  {(char *) "sources", (char *) "bytes with where each string came from: 0 initial, "
+   "1 backreference, 2 evil (by name only)"},
+  {NULL, NULL}
+};
+
+static PyStructSequence_Desc Result_desc = {
+  (char *) "egret_ext.Result",
+  (char *) "Result of an EGRET run",
+  Result_fields,
+  6
+};
+
+// makes a Result from an engine result and the options of the run (NULL on
+// error)
+static PyObject *
+new_result(const EngineResult &result, const EngineOptions &options)
+{
+  PyObject *obj = PyStructSequence_New(&ResultType);
+  if (obj == NULL)
+    return NULL;
+
+  // the Strings status matches the status run_bulk gives
+  string status = "SUCCESS";
+  if (result.status == STATUS_ERROR) {
+    status = result.error;
+  }
+  else if (result.status == STATUS_WARNING) {
+    status = "";
+    for (unsigned int i = 0; i < result.warnings.size(); i++) {
+      status += result.warnings[i].message + "\n";
+    }
+  }
+
+  Py_ssize_t data_length = 0;
+  for (unsigned int i = 0; i < result.strings.size(); i++) {
+    data_length += result.strings[i].length();
+  }
+  StringsObject *strings = new_strings(result.strings.size(), data_length, status);
+  if (strings == NULL) {
+    Py_DECREF(obj);
+    return NULL;
+  }
+  char *out = (char *) (strings->storage + strings->num_offsets);
+  Py_ssize_t pos = 0;
+  for (unsigned int i = 0; i < result.strings.size(); i++) {
+    strings->storage[i] = pos;
+    memcpy(out + pos, result.strings[i].data(), result.strings[i].length());
+    pos += result.strings[i].length();
+  }
+  strings->storage[result.strings.size()] = pos;
+  PyStructSequence_SET_ITEM(obj, 3, (PyObject *) strings);
+
+  PyStructSequence_SET_ITEM(obj, 0, PyLong_FromLong(result.status));
+  if (result.status == STATUS_ERROR) {
+    PyStructSequence_SET_ITEM(obj, 1, PyUnicode_FromStringAndSize(result.error.data(),
+                                                                  result.error.length()));
+  }
+  else {
+    Py_INCREF(Py_None);
+    PyStructSequence_SET_ITEM(obj, 1, Py_None);
+  }
+
+  PyObject *warnings = PyList_New(result.warnings.size());
+  PyStructSequence_SET_ITEM(obj, 2, warnings);
+  if (warnings == NULL) {
+    Py_DECREF(obj);
+    return NULL;
+  }
+  for (unsigned int i = 0; i < result.warnings.size(); i++) {
+    const Warning &w = result.warnings[i];
+    PyList_SET_ITEM(warnings, i, Py_BuildValue("(s#s#)", w.code.data(), (Py_ssize_t) w.code.length(),
+                                               w.message.data(), (Py_ssize_t) w.message.length()));
+  }
+
+  PyObject *stats = Py_None;
+  if (options.stat) {
+    stats = PyList_New(result.stats.size());
+    if (stats == NULL) {
+      Py_DECREF(obj);
+      return NULL;
+    }
+    for (unsigned int i = 0; i < result.stats.size(); i++) {
+      const Stats::Stat &stat = result.stats[i];
+      PyList_SET_ITEM(stats, i, Py_BuildValue("(ssl)", stat.tag.c_str(), stat.name.c_str(),
+                                              stat.value));
+    }
+  }
+  else {
+    Py_INCREF(Py_None);
+  }
+  PyStructSequence_SET_ITEM(obj, 4, stats);
+
+  // one byte per string, so a large suite needs no bool objects
+  PyObject *accepted = Py_None;
+  if (options.verdicts) {
+    accepted = PyBytes_FromStringAndSize(NULL, result.accepted.size());
+    if (accepted == NULL) {
+      Py_DECREF(obj);
+      return NULL;
+    }
+    char *verdicts = PyBytes_AS_STRING(accepted);
+    for (unsigned int i = 0; i < result.accepted.size(); i++) {
+      verdicts[i] = result.accepted[i] ? 1 : 0;
+    }
+  }
+  else {
+    Py_INCREF(Py_None);
+  }
+  PyStructSequence_SET_ITEM(obj, 5, accepted);
+
+  PyObject *sources = PyBytes_FromStringAndSize(NULL, result.sources.size());
+  PyStructSequence_SET_ITEM(obj, 6, sources);
+  if (sources == NULL) {
+    Py_DECREF(obj);
+    return NULL;
+  }
+  for (unsigned int i = 0; i < result.sources.size(); i++) {
+    PyBytes_AS_STRING(sources)[i] = result.sources[i];
+  }
+
+  // an item that could not be made leaves NULL behind
+  if (PyErr_Occurred()) {
+    Py_DECREF(obj);
+    return NULL;
+  }
+  return obj;
+}
+
+static PyObject *
+run_result_impl(PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames, PyObject *kwargs)
+{
+  const char *regex;
+  const char *base_substring;
+  EngineOptions options;
+
+  if (!parse_engine_args("run_result", 2, args, nargs, kwnames, kwargs,
+                         &regex, &base_substring, options))
+    return NULL;
+
+  EngineResult result;
+  Py_BEGIN_ALLOW_THREADS
+  result = run_engine_result(regex, base_substring, options);
+  Py_END_ALLOW_THREADS
+
+  return new_result(result, options);
+}
+
+ENGINE_CALL(egret_run_result, run_result_impl)
+
+//=============================================================
+// Compiled: a regex compiled once and run many times
+//=============================================================
+
+typedef struct {
+  PyObject_HEAD
+  CompiledRegex *compiled;	// compiled regex (shared by calls on any thread)
+  PyObject *regex;		// regex (str)
+} CompiledObject;
+
+static PyTypeObject CompiledType = {
+  PyVarObject_HEAD_INIT(NULL, 0)
+};
+
+static void
+Compiled_dealloc(CompiledObject *self)
+{
+  delete self->compiled;
+  Py_XDECREF(self->regex);
+  Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+// takes the arguments of run_result after the regex, which comes from the
+// compiled regex
+static PyObject *
+generate_impl(CompiledObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames,
+              PyObject *kwargs)
+{
+  if (nargs > NUM_POSITIONAL - 1) {
+    PyErr_Format(PyExc_TypeError, "generate() takes at most %d positional arguments (%zd given)",
+                 NUM_POSITIONAL - 1, nargs);
+    return NULL;
+  }
+  Py_ssize_t num_keywords = kwnames != NULL ? PyTuple_GET_SIZE(kwnames) : 0;
+  vector <PyObject *> all_args;
+  all_args.push_back(self->regex);
+  all_args.insert(all_args.end(), args, args + nargs + num_keywords);
+
+  const char *regex;
+  const char *base_substring;
+  EngineOptions options;
+  if (!parse_engine_args("generate", 2, all_args.data(), nargs + 1, kwnames, kwargs,
+                         &regex, &base_substring, options))
+    return NULL;
+
+  EngineResult result;
+  Py_BEGIN_ALLOW_THREADS
+  result = self->compiled->generate(base_substring, options);
+  Py_END_ALLOW_THREADS
+
+  return new_result(result, options);
+}
+
+#ifdef EGRET_FASTCALL
+static PyObject *
+Compiled_generate(CompiledObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames)
+{
+  return generate_impl(self, args, nargs, kwnames, NULL);
+}
+#else
+static PyObject *
+Compiled_generate(CompiledObject *self, PyObject *args, PyObject *kwargs)
+{
+  return generate_impl(self, &PyTuple_GET_ITEM(args, 0), PyTuple_GET_SIZE(args), NULL, kwargs);
+}
+#endif
+
+// returns bytes with 1 for each string the regex accepts, else 0 (as the
+// accepted field of a Result)
+static PyObject *
+Compiled_classify(CompiledObject *self, PyObject *arg)
+{
+  if (PyUnicode_Check(arg)) {
+    PyErr_SetString(PyExc_TypeError, "classify() argument must be a sequence of str, not str");
+    return NULL;
+  }
+  PyObject *seq = PySequence_Fast(arg, "classify() argument must be a sequence");
+  if (seq == NULL)
+    return NULL;
+  vector <string> strings;
+  for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(seq); i++) {
+    const char *s;
+    if (!get_string_arg("classify", "strings", PySequence_Fast_GET_ITEM(seq, i), false, &s)) {
+      Py_DECREF(seq);
+      return NULL;
+    }
+    strings.push_back(s);
+  }
+  Py_DECREF(seq);
+
+  vector <bool> accepted;
+  Py_BEGIN_ALLOW_THREADS
+  accepted = self->compiled->classify(strings);
+  Py_END_ALLOW_THREADS
+
+  PyObject *verdicts = PyBytes_FromStringAndSize(NULL, accepted.size());
+  if (verdicts == NULL)
+    return NULL;
+  char *out = PyBytes_AS_STRING(verdicts);
+  for (unsigned int i = 0; i < accepted.size(); i++) {
+    out[i] = accepted[i] ? 1 : 0;
+  }
+  return verdicts;
+}
+
+// returns a list of (tag, name, value) for each stat
+static PyObject *
+Compiled_stats(CompiledObject *self, PyObject *unused)
+{
+  vector <Stats::Stat> stats = self->compiled->get_stats();
+  PyObject *list = PyList_New(stats.size());
+  if (list == NULL)
+    return NULL;
+  for (unsigned int i = 0; i < stats.size(); i++) {
+    PyObject *stat = Py_BuildValue("(ssl)", stats[i].tag.c_str(), stats[i].name.c_str(),
+                                   stats[i].value);
+    if (stat == NULL) {
+      Py_DECREF(list);
+      return NULL;
+    }
+    PyList_SET_ITEM(list, i, stat);
+  }
+  return list;
+}
+
+static PyObject *
+Compiled_get_regex(CompiledObject *self, void *closure)
+{
+  Py_INCREF(self->regex);
+  return self->regex;
+}
+
+static PyObject *
+Compiled_get_error(CompiledObject *self, void *closure)
+{
+  const string &error = self->compiled->get_error();
+  if (error == "") {
+    Py_RETURN_NONE;
+  }
+  return PyUnicode_FromStringAndSize(error.data(), error.length());
+}
+
+static PyMethodDef Compiled_methods[] = {
+#ifdef EGRET_FASTCALL
+  {"generate", (PyCFunction) (void (*)(void)) Compiled_generate, METH_FASTCALL | METH_KEYWORDS,
+#else
+  {"generate", (PyCFunction) (void (*)(void)) Compiled_generate, METH_VARARGS | METH_KEYWORDS,
+#endif
+   "Run EGRET on the compiled regex (takes the arguments of run_result after the regex)."},
+  {"classify", (PyCFunction) Compiled_classify, METH_O,
+   "Return bytes with 1 for each string the regex accepts, else 0."},
+  {"stats", (PyCFunction) Compiled_stats, METH_NOARGS,
+   "Return a list of (tag, name, value) for the compile stats and reuse counts."},
+  {NULL, NULL, 0, NULL}        /* Sentinel */
+};
+
+static PyGetSetDef Compiled_getset[] = {
+  {(char *) "regex", (getter) Compiled_get_regex, NULL, (char *) "the compiled regex", NULL},
+  {(char *) "error", (getter) Compiled_get_error, NULL,
+   (char *) "error message if the regex did not compile (None if it did)", NULL},
+  {NULL, NULL, NULL, NULL, NULL}  /* Sentinel */
+};
+
+static PyObject *
+egret_compile(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+  static const char *kwlist[] = { "regex", "timeout", NULL };
+  PyObject *regex;
+  EngineOptions options;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "U|d:compile", (char **) kwlist,
+                                   &regex, &options.timeout))
+    return NULL;
+  const char *s;
+  if (!get_string_arg("compile", "regex", regex, false, &s))
+    return NULL;
+
+  CompiledObject *compiled = PyObject_New(CompiledObject, &CompiledType);
+  if (compiled == NULL)
+    return NULL;
+  Py_INCREF(regex);
+  compiled->regex = regex;
+  compiled->compiled = NULL;
+  Py_BEGIN_ALLOW_THREADS
+  compiled->compiled = new CompiledRegex(s, options);
+  Py_END_ALLOW_THREADS
+
+  return (PyObject *) compiled;
+}
+
+//=============================================================
+// Regex sets
+//=============================================================
+
+// returns (status, [(string, (member, ...)), ...], [member error, ...])
+static PyObject *
+run_set_impl(PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames, PyObject *kwargs)
+{
+  static const char *kwlist[] = { "regexes", "base_substring", "debug", "stat",
+    "max_strings", "max_bytes", "max_length", "timeout", "paths", "threads", "profile",
+    "growth", "verdicts", "trace", "trace_paths" };
+  PyObject *values[NUM_ARGS];
+  const char *base_substring;
+  EngineOptions options;
+
+  if (!collect_args("run_set", kwlist, 2, args, nargs, kwnames, kwargs, values)
+      || !get_string_arg("run_set", kwlist[1], values[1], false, &base_substring)
+      || !get_flag_args(values, options)
+      || !get_engine_options("run_set", kwlist, values, options))
+    return NULL;
+
+  if (PyUnicode_Check(values[0])) {
+    PyErr_SetString(PyExc_TypeError, "run_set() argument 'regexes' must be a sequence of str, not str");
+    return NULL;
+  }
+  PyObject *seq = PySequence_Fast(values[0], "run_set() argument 'regexes' must be a sequence");
+  if (seq == NULL)
+    return NULL;
+  vector <string> regexes;
+  for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(seq); i++) {
+    const char *regex;
+    if (!get_string_arg("run_set", "regexes", PySequence_Fast_GET_ITEM(seq, i), false, &regex)) {
+      Py_DECREF(seq);
+      return NULL;
+    }
+    regexes.push_back(regex);
+  }
+  Py_DECREF(seq);
+
+  RegexSetResult result;
+  Py_BEGIN_ALLOW_THREADS
+  result = run_regex_set(regexes, base_substring, options);
+  Py_END_ALLOW_THREADS
+
+  PyObject *strings = PyList_New(result.strings.size());
+  PyObject *errors = PyList_New(result.member_errors.size());
+  if (strings == NULL || errors == NULL) {
+    Py_XDECREF(strings);
+    Py_XDECREF(errors);
+    return NULL;
+  }
+  for (unsigned int i = 0; i < result.strings.size(); i++) {
+    const vector <unsigned int> &members = result.accepted_by[i];
+    PyObject *accepted = PyTuple_New(members.size());
+    if (accepted == NULL) {
+      Py_DECREF(strings);
+      Py_DECREF(errors);
+      return NULL;
+    }
+    for (unsigned int j = 0; j < members.size(); j++) {
+      PyTuple_SET_ITEM(accepted, j, PyLong_FromUnsignedLong(members[j]));
+    }
+    const string &s = result.strings[i];
+    PyList_SET_ITEM(strings, i, Py_BuildValue("(s#N)", s.data(), (Py_ssize_t) s.length(), accepted));
+  }
+  for (unsigned int i = 0; i < result.member_errors.size(); i++) {
+    const string &e = result.member_errors[i];
+    PyList_SET_ITEM(errors, i, PyUnicode_FromStringAndSize(e.data(), e.length()));
+  }
+
+  const string &status = result.status;
+  return Py_BuildValue("(s#NN)", status.data(), (Py_ssize_t) status.length(), strings, errors);
+}
+
+ENGINE_CALL(egret_run_set, run_set_impl)
+
+//=============================================================
+// Stream: iterator that yields test strings as they are generated
+//=============================================================
+
+typedef struct {
+  PyObject_HEAD
+  EngineStream *stream;		// engine run
+  bool busy;			// set while the engine is running without the GIL
+} StreamObject;
+
+static PyTypeObject StreamType = {
+  PyVarObject_HEAD_INIT(NULL, 0)
+};
+
+static void
+Stream_dealloc(StreamObject *self)
+{
+  delete self->stream;
+  Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static PyObject *
+Stream_iternext(StreamObject *self)
+{
+  if (self->busy) {
+    PyErr_SetString(PyExc_RuntimeError, "egret_ext.Stream is already running");
+    return NULL;
+  }
+
+  string s;
+  bool found;
+  self->busy = true;
+  Py_BEGIN_ALLOW_THREADS
+  found = self->stream->next(s);
+  Py_END_ALLOW_THREADS
+  self->busy = false;
+
+  // returning NULL without an exception set ends the iteration
+  if (!found) return NULL;
+  return PyUnicode_FromStringAndSize(s.data(), s.length());
+}
+
+static PyObject *
+Stream_get_status(StreamObject *self, void *closure)
+{
+  if (self->busy || !self->stream->is_done()) {
+    Py_RETURN_NONE;
+  }
+  string status = self->stream->get_status();
+  return PyUnicode_FromStringAndSize(status.data(), status.length());
+}
+
+static PyGetSetDef Stream_getset[] = {
+  {(char *) "status", (getter) Stream_get_status, NULL,
+   (char *) "SUCCESS, warnings, or an error message (None until the stream is exhausted)", NULL},
+  {NULL, NULL, NULL, NULL, NULL}  /* Sentinel */
+};
+
+static PyObject *
+stream_impl(PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames, PyObject *kwargs)
+{
+  const char *regex;
+  const char *base_substring;
+  EngineOptions options;
+
+  if (!parse_engine_args("stream", 2, args, nargs, kwnames, kwargs,
+                         &regex, &base_substring, options))
+    return NULL;
+
+  StreamObject *stream = PyObject_New(StreamObject, &StreamType);
+  if (stream == NULL)
+    return NULL;
+  stream->stream = new EngineStream(regex, base_substring, options);
+  stream->busy = false;
+
+  return (PyObject *) stream;
+}
+
+ENGINE_CALL(egret_stream, stream_impl)
+
+//=============================================================
+// Binary suite files
+//=============================================================
+
+// Calls a Python accept function with the GIL held.  The first exception
+// it raises stops further calls and is raised once the suite is written.
+class AcceptCall {
+
+public:
+
+  AcceptCall(PyObject *_accept) {
+    accept = _accept;
+    exc_type = NULL;
+    exc_value = NULL;
+    exc_tb = NULL;
+  }
+
+  // returns a function that calls accept (nullptr if accept is None)
+  function <bool (const string &)> get_function() {
+    if (accept == Py_None) return nullptr;
+    return [this](const string &s) {
+      bool accepted = false;
+      PyGILState_STATE gil = PyGILState_Ensure();
+      if (exc_type == NULL) {
+        PyObject *result = PyObject_CallFunction(accept, "s#", s.data(), (Py_ssize_t) s.length());
+        if (result != NULL) {
+          accepted = PyObject_IsTrue(result) == 1;
+          Py_DECREF(result);
+        }
+        if (PyErr_Occurred()) PyErr_Fetch(&exc_type, &exc_value, &exc_tb);
+      }
+      PyGILState_Release(gil);
+      return accepted;
+    };
+  }
+
+  // raises the exception accept raised (removing the suite file), returns
+  // false if there was none
+  bool raise(const char *file_name) {
+    if (exc_type == NULL) return false;
+    remove(file_name);
+    PyErr_Restore(exc_type, exc_value, exc_tb);
+    return true;
+  }
+
+private:
+
+  PyObject *accept;		// accept function (Py_None if none)
+  PyObject *exc_type;		// first exception raised by accept (NULL if none)
+  PyObject *exc_value;
+  PyObject *exc_tb;
+};
+
+static PyObject *
+write_suite_impl(PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames, PyObject *kwargs)
+{
+  static const char *kwlist[] = { "regex", "base_substring", "file_name", "accept",
+    "max_strings", "max_bytes", "max_length", "timeout", "paths", "threads", "profile",
+    "growth", "verdicts", "trace", "trace_paths" };
+  const char *regex;
+  const char *base_substring;
+  const char *file_name;
+  PyObject *values[NUM_ARGS];
+  EngineOptions options;
+
+  if (!collect_args("write_suite", kwlist, 3, args, nargs, kwnames, kwargs, values)
+      || !get_string_arg("write_suite", kwlist[0], values[0], false, &regex)
+      || !get_string_arg("write_suite", kwlist[1], values[1], false, &base_substring)
+      || !get_string_arg("write_suite", kwlist[2], values[2], false, &file_name)
+      || !get_engine_options("write_suite", kwlist, values, options))
+    return NULL;
+  PyObject *accept = values[3] != NULL ? values[3] : Py_None;
+  if (accept != Py_None && !PyCallable_Check(accept)) {
+    PyErr_SetString(PyExc_TypeError, "accept must be callable");
+    return NULL;
+  }
+
+  string status;
+  AcceptCall call(accept);
+  function <bool (const string &)> accept_fn = call.get_function();
+  Py_BEGIN_ALLOW_THREADS
+  status = write_suite(regex, base_substring, options, file_name, accept_fn);
+  Py_END_ALLOW_THREADS
+
+  if (call.raise(file_name)) return NULL;
+  return PyUnicode_FromStringAndSize(status.data(), status.length());
+}
+
+ENGINE_CALL(egret_write_suite, write_suite_impl)
+
+// writes the test strings of an egret_ext.Result to a binary suite file,
+// so a caller that already has the result does not run the engine again
+static PyObject *
+egret_write_result(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+  static const char *kwlist[] = { "result", "regex", "base_substring", "file_name", "accept",
+    NULL };
+  PyObject *obj;
+  PyObject *regex_obj;
+  PyObject *base_obj;
+  PyObject *file_obj;
+  PyObject *accept = Py_None;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!UUU|O:write_result", (char **) kwlist,
+                                   &ResultType, &obj, &regex_obj, &base_obj, &file_obj, &accept))
+    return NULL;
+  const char *regex;
+  const char *base_substring;
+  const char *file_name;
+  if (!get_string_arg("write_result", kwlist[1], regex_obj, false, &regex)
+      || !get_string_arg("write_result", kwlist[2], base_obj, false, &base_substring)
+      || !get_string_arg("write_result", kwlist[3], file_obj, false, &file_name))
+    return NULL;
+  if (accept != Py_None && !PyCallable_Check(accept)) {
+    PyErr_SetString(PyExc_TypeError, "accept must be callable");
+    return NULL;
+  }
+
+  // rebuild the engine result from the items new_result made (a Result
+  // can also be built by hand, so each item is checked)
+  EngineResult result;
+  PyObject *status_obj = PyStructSequence_GET_ITEM(obj, 0);
+  long status_value = PyLong_Check(status_obj) ? PyLong_AsLong(status_obj) : -1;
+  if (status_value < STATUS_SUCCESS || status_value > STATUS_ERROR) {
+    PyErr_Clear();
+    PyErr_SetString(PyExc_TypeError, "result status must be an egret_ext status");
+    return NULL;
+  }
+  result.status = (EngineStatus) status_value;
+  PyObject *error = PyStructSequence_GET_ITEM(obj, 1);
+  if (error != Py_None) {
+    const char *s;
+    if (!get_string_arg("write_result", "error", error, false, &s))
+      return NULL;
+    result.error = s;
+  }
+  PyObject *warnings = PyStructSequence_GET_ITEM(obj, 2);
+  if (!PyList_Check(warnings)) {
+    PyErr_SetString(PyExc_TypeError, "result warnings must be a list");
+    return NULL;
+  }
+  for (Py_ssize_t i = 0; i < PyList_GET_SIZE(warnings); i++) {
+    PyObject *item = PyList_GET_ITEM(warnings, i);
+    const char *code;
+    const char *message;
+    if (!PyTuple_Check(item)) {
+      PyErr_SetString(PyExc_TypeError, "result warnings must be (code, message) tuples");
+      return NULL;
+    }
+    if (!PyArg_ParseTuple(item, "ss", &code, &message))
+      return NULL;
+    Warning w;
+    w.code = code;
+    w.message = message;
+    result.warnings.push_back(w);
+  }
+  PyObject *strings_obj = PyStructSequence_GET_ITEM(obj, 3);
+  if (!PyObject_TypeCheck(strings_obj, &StringsType)) {
+    PyErr_SetString(PyExc_TypeError, "result strings must be egret_ext.Strings");
+    return NULL;
+  }
+  StringsObject *strings = (StringsObject *) strings_obj;
+  PyObject *sources = PyStructSequence_GET_ITEM(obj, 6);
+  if (sources == NULL || !PyBytes_Check(sources)) {
+    PyErr_SetString(PyExc_TypeError, "result sources must be bytes");
+    return NULL;
+  }
+  if (PyBytes_GET_SIZE(sources) != strings->count) {
+    PyErr_SetString(PyExc_ValueError, "result has no source for each string");
+    return NULL;
+  }
+  for (Py_ssize_t i = 0; i < strings->count; i++) {
+    Py_ssize_t start = strings->storage[i];
+    result.strings.push_back(string(Strings_data(strings) + start,
+                                    strings->storage[i + 1] - start));
+    unsigned char source = PyBytes_AS_STRING(sources)[i];
+    if (source > FROM_EVIL) {
+      PyErr_SetString(PyExc_ValueError, "result sources must be 0, 1 or 2");
+      return NULL;
+    }
+    result.sources.push_back((StringSource) source);
+  }
+
+  string status;
+  AcceptCall call(accept);
+  function <bool (const string &)> accept_fn = call.get_function();
+  Py_BEGIN_ALLOW_THREADS
+  status = write_suite(result, regex, base_substring, file_name, accept_fn);
+  Py_END_ALLOW_THREADS
+
+  if (call.raise(file_name)) return NULL;
+  return PyUnicode_FromStringAndSize(status.data(), status.length());
+}
+
 static PyMethodDef EgretExtMethods[] = {
-  {"run", egret_run, METH_VARARGS, "Run EGRET."},
+  {"run", (PyCFunction) (void (*)(void)) egret_run, ENGINE_CALL_FLAGS, "Run EGRET."},
+  {"run_bases", (PyCFunction) (void (*)(void)) egret_run_bases, ENGINE_CALL_FLAGS,
+   "Run EGRET once for each of several base substrings, sharing the work that does not depend on them."},
+  {"run_bulk", (PyCFunction) (void (*)(void)) egret_run_bulk, ENGINE_CALL_FLAGS,
+   "Run EGRET, returning the test strings packed in one egret_ext.Strings buffer."},
+  {"run_result", (PyCFunction) (void (*)(void)) egret_run_result, ENGINE_CALL_FLAGS,
+   "Run EGRET, returning an egret_ext.Result with the status, warnings, and test strings."},
+  {"compile", (PyCFunction) (void (*)(void)) egret_compile, METH_VARARGS | METH_KEYWORDS,
+   "Compile a regex once, returning an egret_ext.Compiled to run EGRET on it many times."},
+  {"run_set", (PyCFunction) (void (*)(void)) egret_run_set, ENGINE_CALL_FLAGS,
+   "Run EGRET on a set of regexes, returning the test strings with the members that accept them."},
+  {"stream", (PyCFunction) (void (*)(void)) egret_stream, ENGINE_CALL_FLAGS,
+   "Run EGRET, returning an iterator that yields test strings as they are generated."},
+  {"write_suite", (PyCFunction) (void (*)(void)) egret_write_suite, ENGINE_CALL_FLAGS,
+   "Run EGRET, writing the test strings to a binary suite file."},
+  {"write_result", (PyCFunction) (void (*)(void)) egret_write_result, METH_VARARGS | METH_KEYWORDS,
+   "Write the test strings of an egret_ext.Result to a binary suite file."},
   {NULL, NULL, 0, NULL}        /* Sentinel */
 };
 
@@ -70,10 +1343,70 @@ extern "C" {
   {
     PyObject *m;
 
+    StreamType.tp_name = "egret_ext.Stream";
+    StreamType.tp_doc = "Iterator over EGRET test strings";
+    StreamType.tp_basicsize = sizeof(StreamObject);
+    StreamType.tp_flags = Py_TPFLAGS_DEFAULT;
+    StreamType.tp_dealloc = (destructor) Stream_dealloc;
+    StreamType.tp_iter = PyObject_SelfIter;
+    StreamType.tp_iternext = (iternextfunc) Stream_iternext;
+    StreamType.tp_getset = Stream_getset;
+    if (PyType_Ready(&StreamType) < 0)
+      return NULL;
+
+    StringsType.tp_name = "egret_ext.Strings";
+    StringsType.tp_doc = "EGRET test strings packed in one buffer (str objects are made on access)";
+    StringsType.tp_basicsize = offsetof(StringsObject, storage);
+    StringsType.tp_itemsize = 1;
+    StringsType.tp_flags = Py_TPFLAGS_DEFAULT;
+    StringsType.tp_dealloc = (destructor) Strings_dealloc;
+    StringsType.tp_as_sequence = &Strings_as_sequence;
+    StringsType.tp_as_buffer = &Strings_as_buffer;
+    StringsType.tp_getset = Strings_getset;
+    if (PyType_Ready(&StringsType) < 0)
+      return NULL;
+
+    OffsetsType.tp_name = "egret_ext.Offsets";
+    OffsetsType.tp_doc = "Buffer over the offsets of egret_ext.Strings";
+    OffsetsType.tp_basicsize = sizeof(OffsetsObject);
+    OffsetsType.tp_flags = Py_TPFLAGS_DEFAULT;
+    OffsetsType.tp_dealloc = (destructor) Offsets_dealloc;
+    OffsetsType.tp_as_buffer = &Offsets_as_buffer;
+    if (PyType_Ready(&OffsetsType) < 0)
+      return NULL;
+
+    CompiledType.tp_name = "egret_ext.Compiled";
+    CompiledType.tp_doc = "Regex compiled once for many EGRET runs (safe to share between threads)";
+    CompiledType.tp_basicsize = sizeof(CompiledObject);
+    CompiledType.tp_flags = Py_TPFLAGS_DEFAULT;
+    CompiledType.tp_dealloc = (destructor) Compiled_dealloc;
+    CompiledType.tp_methods = Compiled_methods;
+    CompiledType.tp_getset = Compiled_getset;
+    if (PyType_Ready(&CompiledType) < 0)
+      return NULL;
+
+    if (PyStructSequence_InitType2(&ResultType, &Result_desc) < 0)
+      return NULL;
+
     m = PyModule_Create(&egret_extmodule);
     if (m == NULL)
       return NULL;
 
+    Py_INCREF(&StreamType);
+    PyModule_AddObject(m, "Stream", (PyObject *) &StreamType);
+    Py_INCREF(&StringsType);
+    PyModule_AddObject(m, "Strings", (PyObject *) &StringsType);
+    Py_INCREF(&ResultType);
+    PyModule_AddObject(m, "Result", (PyObject *) &ResultType);
+    Py_INCREF(&CompiledType);
+    PyModule_AddObject(m, "Compiled", (PyObject *) &CompiledType);
+
+    PyModule_AddIntConstant(m, "STATUS_SUCCESS", STATUS_SUCCESS);
+    PyModule_AddIntConstant(m, "STATUS_WARNING", STATUS_WARNING);
+    PyModule_AddIntConstant(m, "STATUS_ERROR", STATUS_ERROR);
+
+    PyModule_AddStringConstant(m, "version", EGRET_VERSION);
+
     EgretExtError = PyErr_NewException("egret_ext.error", NULL, NULL);
     Py_INCREF(EgretExtError);
     PyModule_AddObject(m, "error", EgretExtError);
@@ -20,26 +20,84 @@
 */
 
 #include <string>
+#include <vector>
 #include "error.h"
 using namespace std;
 
-static string warnings = "";
+// warnings are kept per thread so that engine runs on different threads
+// do not mix their warnings
+static thread_local string warnings = "";
+static thread_local string *active = NULL;
+
+static string &
+activeWarnings()
+{
+  return active ? *active : warnings;
+}
 
 void
 clearWarnings()
 {
-  warnings = "";
+  activeWarnings() = "";
 }
 
 void
 addWarning(string message)
 {
-  warnings += message;
-  warnings += "\n";
+  activeWarnings() += message;
+  activeWarnings() += "\n";
+}
+
+// adds a list of warnings gathered elsewhere (such as on another thread)
+void
+addWarnings(string list)
+{
+  activeWarnings() += list;
 }
 
 string
 getWarnings()
 {
-  return warnings;
+  return activeWarnings();
+}
+
+vector <Warning>
+splitWarnings(const string &list)
+{
+  vector <Warning> result;
+  size_t start = 0;
+  while (start < list.length()) {
+    size_t end = list.find('\n', start);
+    if (end == string::npos) end = list.length();
+    string line = list.substr(start, end - start);
+    start = end + 1;
+    if (line.empty()) continue;
+
+    // lines starting with ... belong to the warning above them
+    if (line.compare(0, 3, "...") == 0 && !result.empty()) {
+      result.back().message += "\n" + line;
+      continue;
+    }
+
+    Warning warning;
+    warning.code = "GENERAL";
+    size_t kind = line.find(" WARNING:");
+    if (kind != string::npos && kind > 0 && line.find(' ') == kind) {
+      warning.code = line.substr(0, kind);
+    }
+    warning.message = line;
+    result.push_back(warning);
+  }
+  return result;
+}
+
+WarningScope::WarningScope(string *list)
+{
+  previous = active;
+  active = list;
+}
+
+WarningScope::~WarningScope()
+{
+  active = previous;
 }
@@ -23,13 +23,38 @@
 #define ERROR_H
 
 #include <string>
+#include <vector>
 using namespace std;
 
 // Warnings 
 void clearWarnings();
 void addWarning(string message);
+void addWarnings(string list);
 string getWarnings();
 
+// A warning in a warning list: the kind of warning (such as REDOS for a
+// "REDOS WARNING: ..." line, GENERAL if it has none) and its text,
+// including the lines starting with "..." that follow it
+struct Warning {
+  string code;
+  string message;
+};
+
+// splits a warning list into its warnings
+vector <Warning> splitWarnings(const string &list);
+
+// Makes a warning list the active list on the current thread for the
+// lifetime of the scope (used by runs that are resumed across calls)
+class WarningScope {
+
+public:
+  WarningScope(string *list);
+  ~WarningScope();
+
+private:
+  string *previous;
+};
+
 // Egret Exception
 class EgretException {
 
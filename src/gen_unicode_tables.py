@@ -0,0 +1,99 @@
+# gen_unicode_tables.py: Generates UnicodeTables.cpp from Python's unicodedata
+#
+# Copyright (C) 2016  Eric Larson and Anna Kirk
+# elarson@seattleu.edu
+#
+# This file is part of EGRET.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# usage: python3 gen_unicode_tables.py > UnicodeTables.cpp
+
+import sys
+import unicodedata
+
+# general categories, and the one letter groups made from them
+CATEGORIES = [ "Lu", "Ll", "Lt", "Lm", "Lo", "Mn", "Mc", "Me", "Nd", "Nl", "No",
+               "Pc", "Pd", "Ps", "Pe", "Pi", "Pf", "Po", "Sm", "Sc", "Sk", "So",
+               "Zs", "Zl", "Zp", "Cc", "Cf", "Cs", "Co", "Cn" ]
+GROUPS = [ "L", "M", "N", "P", "S", "Z", "C" ]
+
+def ranges(codePoints):
+    result = []
+    for cp in codePoints:
+        if result and result[-1][1] == cp - 1:
+            result[-1][1] = cp
+        else:
+            result.append([cp, cp])
+    return result
+
+members = { name: [] for name in CATEGORIES + GROUPS }
+for cp in range(0x110000):
+    cat = unicodedata.category(chr(cp))
+    if cat in members:
+        members[cat].append(cp)
+        members[cat[0]].append(cp)
+
+out = sys.stdout
+out.write("""/*  UnicodeTables.cpp: Unicode general category tables
+
+    Generated by gen_unicode_tables.py from Unicode %s - do not edit.
+
+    Copyright (C) 2016  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string>
+#include "UnicodeTables.h"
+using namespace std;
+""" % unicodedata.unidata_version)
+
+for name in GROUPS + CATEGORIES:
+    rs = ranges(members[name])
+    out.write("\nstatic const UnicodeRange %s_RANGES[] = {\n" % name.upper())
+    for i in range(0, len(rs), 4):
+        out.write("  " + " ".join("{ 0x%04X, 0x%04X }," % (lo, hi) for (lo, hi) in rs[i:i + 4]) + "\n")
+    out.write("};\n")
+
+out.write("\nstatic const UnicodeProperty PROPERTIES[] = {\n")
+for name in GROUPS + CATEGORIES:
+    out.write("  { \"%s\", %s_RANGES, sizeof(%s_RANGES) / sizeof(UnicodeRange) },\n"
+              % (name, name.upper(), name.upper()))
+out.write("};\n")
+
+out.write("""
+const UnicodeProperty *
+find_unicode_property(const string &name)
+{
+  for (unsigned int i = 0; i < sizeof(PROPERTIES) / sizeof(UnicodeProperty); i++) {
+    if (name == PROPERTIES[i].name) return &PROPERTIES[i];
+  }
+  return NULL;
+}
+""")
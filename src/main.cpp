@@ -19,15 +19,28 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <thread>
 #include <vector>
+#include "Corpus.h"
+#include "Fuzzer.h"
+#include "SuiteFile.h"
 #include "egret.h"
+#include "error.h"
 using namespace std;
 
 static char *get_arg(int &idx, int argc, char **argv);
+static int print_suite(string file_name);
+static int run_set_mode(string set_file, string base_substring, const EngineOptions &options);
+static int run_corpus_mode(string corpus_file, string results_file, string base_substring,
+                           const EngineOptions &options, CorpusOptions corpus);
+static int run_fuzz_mode(FuzzOptions fuzz);
+static int run_thread_check(string regex, string base_substring, const EngineOptions &options,
+                            unsigned int threads);
 
 int
 main(int argc, char *argv[])
@@ -36,8 +49,16 @@ main(int argc, char *argv[])
   int idx = 1;
   string regex = "";
   string base_substring = "evil";
-  bool debug_mode = false;
-  bool stat_mode = false;
+  EngineOptions options;
+  bool stream_mode = false;
+  string suite_file = "";
+  string corpus_file = "";
+  string set_file = "";
+  string results_file = "";
+  CorpusOptions corpus;
+  bool fuzz_mode = false;
+  FuzzOptions fuzz;
+  unsigned int check_threads = 0;
 
   // Process arguments
   while (idx < argc) {
@@ -80,12 +101,138 @@ main(int argc, char *argv[])
 
     // -d: print debug information based on the given mode 
     else if (strcmp(arg, "-d") == 0) {
-      debug_mode = true;
+      options.debug = true;
     }
 
     // -s: print stats
     else if (strcmp(arg, "-s") == 0) {
-      stat_mode = true;
+      options.stat = true;
+    }
+
+    // -T: print the backtracking steps taken by the test strings
+    else if (strcmp(arg, "-T") == 0) {
+      options.profile = true;
+    }
+
+    // -G: measure how matching steps grow for each REDOS finding
+    else if (strcmp(arg, "-G") == 0) {
+      options.growth = true;
+    }
+
+    // -R: write a Chrome trace of the run's phases to a file
+    else if (strcmp(arg, "-R") == 0) {
+      options.trace_file = get_arg(idx, argc, argv);
+    }
+
+    // -RP: write a Chrome trace of the run's phases and paths to a file
+    else if (strcmp(arg, "-RP") == 0) {
+      options.trace_file = get_arg(idx, argc, argv);
+      options.trace_paths = true;
+    }
+
+    // -ms: maximum number of test strings
+    else if (strcmp(arg, "-ms") == 0) {
+      options.max_strings = strtoul(get_arg(idx, argc, argv), NULL, 10);
+    }
+
+    // -mb: maximum total bytes of test strings
+    else if (strcmp(arg, "-mb") == 0) {
+      options.max_bytes = strtoul(get_arg(idx, argc, argv), NULL, 10);
+    }
+
+    // -ml: maximum length of a test string
+    else if (strcmp(arg, "-ml") == 0) {
+      options.max_length = strtoul(get_arg(idx, argc, argv), NULL, 10);
+    }
+
+    // -S: stream test strings as they are generated (status printed last)
+    else if (strcmp(arg, "-S") == 0) {
+      stream_mode = true;
+    }
+
+    // -o: write test strings to a binary suite file
+    else if (strcmp(arg, "-o") == 0) {
+      suite_file = get_arg(idx, argc, argv);
+    }
+
+    // -p: print the contents of a binary suite file
+    else if (strcmp(arg, "-p") == 0) {
+      return print_suite(get_arg(idx, argc, argv));
+    }
+
+    // -P: path strategy (basis or cover)
+    else if (strcmp(arg, "-P") == 0) {
+      char *name = get_arg(idx, argc, argv);
+      if (!parse_path_strategy(name, options.path_strategy)) {
+        cerr << "USAGE: Invalid path strategy: " << name << endl;
+        return -1;
+      }
+    }
+
+    // -j: threads generating evil strings (0 for one per core)
+    else if (strcmp(arg, "-j") == 0) {
+      options.threads = strtoul(get_arg(idx, argc, argv), NULL, 10);
+    }
+
+    // -t: time limit in seconds
+    else if (strcmp(arg, "-t") == 0) {
+      options.timeout = strtod(get_arg(idx, argc, argv), NULL);
+    }
+
+    // -c: corpus file with one regular expression per line
+    else if (strcmp(arg, "-c") == 0) {
+      corpus_file = get_arg(idx, argc, argv);
+    }
+
+    // -M: regex set file with one member per line
+    else if (strcmp(arg, "-M") == 0) {
+      set_file = get_arg(idx, argc, argv);
+    }
+
+    // -J: JSONL results file for a corpus (also used to resume)
+    else if (strcmp(arg, "-J") == 0) {
+      results_file = get_arg(idx, argc, argv);
+    }
+
+    // -w: corpus regexes run at the same time (0 for one per core)
+    else if (strcmp(arg, "-w") == 0) {
+      corpus.workers = strtoul(get_arg(idx, argc, argv), NULL, 10);
+    }
+
+    // --shard: run shard i of n of the corpus (given as i/n)
+    else if (strcmp(arg, "--shard") == 0) {
+      char *shard = get_arg(idx, argc, argv);
+      if (!parse_shard(shard, corpus.shard, corpus.num_shards)) {
+        cerr << "USAGE: Invalid shard (expected i/n with i < n): " << shard << endl;
+        return -1;
+      }
+    }
+
+    // -F: fuzz the engine with this many random regexes
+    else if (strcmp(arg, "-F") == 0) {
+      fuzz_mode = true;
+      fuzz.count = strtoul(get_arg(idx, argc, argv), NULL, 10);
+    }
+
+    // --seed: seed for the fuzzer's random regexes
+    else if (strcmp(arg, "--seed") == 0) {
+      fuzz.seed = strtoul(get_arg(idx, argc, argv), NULL, 10);
+    }
+
+    // --top: most costly fuzzed regexes to report
+    else if (strcmp(arg, "--top") == 0) {
+      fuzz.top = strtoul(get_arg(idx, argc, argv), NULL, 10);
+    }
+
+    // --memory: limit on the process memory while fuzzing (MB)
+    else if (strcmp(arg, "--memory") == 0) {
+      fuzz.memory_limit = strtoul(get_arg(idx, argc, argv), NULL, 10);
+    }
+
+    // --check-threads: run a compiled regex on this many threads at once and
+    // compare each result with a run on its own
+    else if (strcmp(arg, "--check-threads") == 0) {
+      check_threads = strtoul(get_arg(idx, argc, argv), NULL, 10);
     }
 
     // everything else is invalid
@@ -95,12 +242,63 @@ main(int argc, char *argv[])
     }
   }
 
+  if ((corpus_file != "" || set_file != "" || fuzz_mode) && options.trace_file != "") {
+    cerr << "USAGE: A trace can only be written for a single regular expression" << endl;
+    return -1;
+  }
+
+  if (fuzz_mode) {
+    if (regex != "" || corpus_file != "" || set_file != "") {
+      cerr << "USAGE: Cannot fuzz and process a regular expression, corpus or regex set" << endl;
+      return -1;
+    }
+    fuzz.base_substring = base_substring;
+    fuzz.engine = options;
+    return run_fuzz_mode(fuzz);
+  }
+
+  if (corpus_file != "") {
+    if (regex != "") {
+      cerr << "USAGE: Cannot process a regular expression and a corpus" << endl;
+      return -1;
+    }
+    if (results_file == "") {
+      cerr << "USAGE: A corpus needs a results file (-J)" << endl;
+      return -1;
+    }
+    return run_corpus_mode(corpus_file, results_file, base_substring, options, corpus);
+  }
+
+  if (set_file != "") {
+    if (regex != "") {
+      cerr << "USAGE: Cannot process a regular expression and a regex set" << endl;
+      return -1;
+    }
+    return run_set_mode(set_file, base_substring, options);
+  }
+
   if (regex == "") {
     cerr << "USAGE: Did not find a regular expression to process" << endl;
     return -1;
   }
 
-  vector <string> test_strings = run_engine(regex, base_substring, debug_mode, stat_mode);
+  if (check_threads != 0) {
+    return run_thread_check(regex, base_substring, options, check_threads);
+  }
+
+  if (suite_file != "") {
+    cout << write_suite(regex, base_substring, options, suite_file) << endl;
+    return 0;
+  }
+
+  if (stream_mode) {
+    string status = run_engine(regex, base_substring, options,
+                               [](const string &s) { cout << s << endl; });
+    cout << status << endl;
+    return 0;
+  }
+
+  vector <string> test_strings = run_engine(regex, base_substring, options);
   vector <string>::iterator it;
   for (it = test_strings.begin(); it != test_strings.end(); it++) {
     cout << *it << endl;
@@ -109,6 +307,143 @@ main(int argc, char *argv[])
   return 0;
 }
 
+static int
+print_suite(string file_name)
+{
+  SuiteReader suite;
+  try {
+    suite.open(file_name);
+    cout << "Engine version: " << suite.get_engine_version() << endl;
+    cout << "Fingerprint:    " << hex << suite.get_fingerprint() << dec << endl;
+    cout << "Strings:        " << suite.size() << endl;
+    for (unsigned int i = 0; i < suite.size(); i++) {
+      string sources = "";
+      if (suite.has_source(i, FROM_INITIAL)) sources += "I";
+      if (suite.has_source(i, FROM_BACKREFERENCE)) sources += "B";
+      if (suite.has_source(i, FROM_EVIL)) sources += "E";
+      if (suite.has_accept()) sources += suite.is_accepted(i) ? " +" : " -";
+      cout << sources << "\t" << suite.get(i) << endl;
+    }
+    cout << suite.get_status() << endl;
+  }
+  catch (EgretException const &e) {
+    cerr << e.getError() << endl;
+    return -1;
+  }
+  return 0;
+}
+
+// prints each test string of a regex set with the members that accept it
+static int
+run_set_mode(string set_file, string base_substring, const EngineOptions &options)
+{
+  ifstream in(set_file.c_str());
+  if (!in.is_open()) {
+    cerr << "USAGE: Unable to open file " << set_file << endl;
+    return -1;
+  }
+  vector <string> regexes;
+  string line;
+  while (getline(in, line)) {
+    if (line != "") regexes.push_back(line);
+  }
+  in.close();
+
+  RegexSetResult result = run_regex_set(regexes, base_substring, options);
+  cout << result.status << endl;
+  for (unsigned int i = 0; i < result.strings.size(); i++) {
+    cout << result.strings[i] << "\t";
+    for (unsigned int j = 0; j < result.accepted_by[i].size(); j++) {
+      if (j > 0) cout << ",";
+      cout << result.accepted_by[i][j];
+    }
+    cout << endl;
+  }
+  return 0;
+}
+
+// prints the counts of a fuzzing run and its most costly regexes
+static int
+run_fuzz_mode(FuzzOptions fuzz)
+{
+  FuzzSummary summary = run_fuzzer(fuzz);
+  cout << "Generated: " << summary.generated << endl;
+  cout << "Invalid: " << summary.invalid << endl;
+  cout << "Stopped at a limit: " << summary.limited << endl;
+  cout << "Out of memory: " << summary.out_of_memory << endl;
+  cout << "Baseline (s): " << summary.baseline << endl;
+  for (unsigned int i = 0; i < summary.top.size(); i++) {
+    const FuzzFinding &finding = summary.top[i];
+    cout << endl;
+    cout << "Regex: " << finding.regex << endl;
+    cout << "Time (s): " << finding.seconds << endl;
+    cout << "Cost (s per byte): " << finding.cost << endl;
+    if (finding.stopped != "") cout << "Stopped: " << finding.stopped << endl;
+    cout << "Minimized: " << finding.minimized << endl;
+    cout << "Minimized time (s): " << finding.minimized_seconds << endl;
+  }
+  return 0;
+}
+
+// runs a compiled regex on several threads at once (none of them starting
+// with the analyses of another) and checks that each gets the result of a
+// run on its own (build with make TSAN=1 to check for data races as well)
+static int
+run_thread_check(string regex, string base_substring, const EngineOptions &options,
+                 unsigned int threads)
+{
+  EngineResult expected = run_engine_result(regex, base_substring, options);
+
+  CompiledRegex compiled(regex, options);
+  vector <EngineResult> results(threads);
+  vector <thread> workers;
+  for (unsigned int i = 0; i < threads; i++) {
+    workers.push_back(thread([&compiled, &results, &base_substring, &options, i]() {
+      results[i] = compiled.generate(base_substring, options);
+    }));
+  }
+  for (unsigned int i = 0; i < threads; i++) {
+    workers[i].join();
+  }
+
+  unsigned int differ = 0;
+  for (unsigned int i = 0; i < threads; i++) {
+    bool same = results[i].status == expected.status && results[i].error == expected.error &&
+      results[i].strings == expected.strings &&
+      results[i].warnings.size() == expected.warnings.size();
+    for (unsigned int j = 0; same && j < expected.warnings.size(); j++) {
+      same = results[i].warnings[j].message == expected.warnings[j].message;
+    }
+    if (!same) {
+      cout << "Thread " << i << " differs" << endl;
+      differ++;
+    }
+  }
+  cout << "Threads: " << threads << endl;
+  cout << "Differ:  " << differ << endl;
+  return differ == 0 ? 0 : -1;
+}
+
+static int
+run_corpus_mode(string corpus_file, string results_file, string base_substring,
+                const EngineOptions &options, CorpusOptions corpus)
+{
+  corpus.base_substring = base_substring;
+  corpus.engine = options;
+  try {
+    CorpusSummary summary = run_corpus(corpus_file, results_file, corpus);
+    cout << "Regexes in shard: " << summary.total << endl;
+    cout << "Already done:     " << summary.skipped << endl;
+    cout << "Processed:        " << summary.processed << endl;
+    cout << "Errors:           " << summary.errors << endl;
+  }
+  catch (EgretException const &e) {
+    cerr << e.getError() << endl;
+    return -1;
+  }
+  return 0;
+}
+
 static char *
 get_arg(int &idx, int argc, char **argv)
 {